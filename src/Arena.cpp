@@ -0,0 +1,140 @@
+#include "Arena.h"
+#include "Statistics.h"
+
+#include <cstdlib>
+#include <new>
+
+thread_local Arena* Arena::current = NULL;
+
+/**
+ * ArenaObjects are preceded by a header that holds the arena they were
+ * allocated from, or NULL. The header keeps the object aligned.
+ */
+struct ArenaHeader {
+  Arena* arena;
+  void* padding;
+};
+
+Arena::Arena(size_t blockSize) {
+  size_t i;
+
+  this->blockSize = blockSize;
+  pos = end = NULL;
+  used = reserved = 0;
+  for (i = 0; i < FREELIST_CLASSES; i++)
+    freeLists[i] = NULL;
+}
+
+Arena::~Arena() {
+  std::vector<char*>::iterator it;
+
+  for (it = blocks.begin(); it != blocks.end(); it++)
+    std::free(*it);
+}
+
+void Arena::newBlock(size_t size) {
+  char* block;
+
+  if (size < blockSize)
+    size = blockSize;
+  block = (char*)std::malloc(size);
+  if (block == NULL)
+    throw std::bad_alloc();
+
+  blocks.push_back(block);
+  reserved += size;
+  pos = block;
+  end = block + size;
+}
+
+void* Arena::allocate(size_t size) {
+  size_t c;
+  void* p;
+
+  size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+  if (size == 0)
+    size = ALIGNMENT;
+
+  c = size / ALIGNMENT - 1;
+  if (c < FREELIST_CLASSES && freeLists[c] != NULL) {
+    p = freeLists[c];
+    freeLists[c] = *(void**)p;
+  } else {
+    if ((size_t)(end - pos) < size)
+      newBlock(size);
+    p = pos;
+    pos += size;
+  }
+  used += size;
+  return p;
+}
+
+void Arena::deallocate(void* p, size_t size) {
+  size_t c;
+
+  size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+  if (size == 0)
+    size = ALIGNMENT;
+
+  used -= size;
+
+  // larger objects are left in place until the arena is destroyed
+  c = size / ALIGNMENT - 1;
+  if (c < FREELIST_CLASSES) {
+    *(void**)p = freeLists[c];
+    freeLists[c] = p;
+  }
+}
+
+size_t Arena::getUsed() const {
+  return used;
+}
+
+size_t Arena::getReserved() const {
+  return reserved;
+}
+
+Arena* Arena::getCurrent() {
+  return current;
+}
+
+void Arena::setCurrent(Arena* arena) {
+  current = arena;
+}
+
+ArenaScope::ArenaScope(Arena &arena) {
+  previous = Arena::getCurrent();
+  Arena::setCurrent(&arena);
+}
+
+ArenaScope::~ArenaScope() {
+  Arena::setCurrent(previous);
+}
+
+void* ArenaObject::operator new(size_t size) {
+  Arena* arena = Arena::getCurrent();
+  ArenaHeader* header;
+
+  Statistics::count(Statistics::ARENA_OBJECTS);
+  
+  if (arena != NULL)
+    header = (ArenaHeader*)arena->allocate(sizeof(ArenaHeader) + size);
+  else
+    header = (ArenaHeader*)::operator new(sizeof(ArenaHeader) + size);
+
+  header->arena = arena;
+  return header + 1;
+}
+
+void ArenaObject::operator delete(void* p, size_t size) {
+  ArenaHeader* header;
+
+  if (p == NULL)
+    return;
+
+  header = (ArenaHeader*)p - 1;
+  if (header->arena != NULL)
+    header->arena->deallocate(header, sizeof(ArenaHeader) + size);
+  else
+    ::operator delete(header);
+}
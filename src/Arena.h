@@ -0,0 +1,100 @@
+#ifndef __Arena_h__
+#define __Arena_h__
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Bump allocator for the objects of one compilation.
+ *
+ * Memory is handed out from large blocks and is only returned to the
+ * system when the arena is destroyed, so a whole tree of objects can
+ * be released at once. Small objects that are deleted early (like the
+ * temporary values created while evaluating expressions) are kept on a
+ * free list and reused.
+ *
+ * An arena is not thread safe; use one arena per compilation and
+ * thread.
+ */
+class Arena {
+private:
+  static const size_t ALIGNMENT = 16;
+  static const size_t FREELIST_CLASSES = 32;
+  static thread_local Arena* current;
+
+  std::vector<char*> blocks;
+  char* pos;
+  char* end;
+  size_t blockSize;
+  size_t used;
+  size_t reserved;
+
+  /**
+   * Free lists for sizes up to FREELIST_CLASSES * ALIGNMENT bytes,
+   * indexed by size / ALIGNMENT - 1.
+   */
+  void* freeLists[FREELIST_CLASSES];
+
+  void newBlock(size_t size);
+
+  // not copyable
+  Arena(const Arena &a);
+  Arena& operator=(const Arena &a);
+
+public:
+  Arena(size_t blockSize = 64 * 1024);
+  virtual ~Arena();
+
+  void* allocate(size_t size);
+
+  /**
+   * Give memory back to the arena. <code>size</code> has to be the
+   * size that was passed to allocate().
+   */
+  void deallocate(void* p, size_t size);
+
+  /**
+   * Returns the number of bytes that are in use.
+   */
+  size_t getUsed() const;
+
+  /**
+   * Returns the number of bytes reserved from the system.
+   */
+  size_t getReserved() const;
+
+  /**
+   * Returns the arena that ArenaObjects are allocated from in the
+   * calling thread, or NULL if they are allocated on the heap.
+   */
+  static Arena* getCurrent();
+  static void setCurrent(Arena* arena);
+};
+
+/**
+ * Makes an arena the current arena of the thread until the scope is
+ * left.
+ */
+class ArenaScope {
+private:
+  Arena* previous;
+
+public:
+  ArenaScope(Arena &arena);
+  ~ArenaScope();
+};
+
+/**
+ * Base class for objects that are allocated from the current arena,
+ * or from the heap if no arena is set. The object remembers where it
+ * came from, so <code>new</code> and <code>delete</code> are used as
+ * usual. Objects from an arena have to be deleted (or abandoned)
+ * before the arena is destroyed.
+ */
+class ArenaObject {
+public:
+  static void* operator new(size_t size);
+  static void operator delete(void* p, size_t size);
+};
+
+#endif
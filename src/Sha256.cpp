@@ -0,0 +1,153 @@
+#include "Sha256.h"
+
+#include <cstring>
+
+static const uint32_t K[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+  0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+  0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+  0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+  0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+  0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+  0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+  0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+  0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static inline uint32_t rotr(uint32_t x, unsigned int n) {
+  return (x >> n) | (x << (32 - n));
+}
+
+Sha256::Sha256() {
+  state[0] = 0x6a09e667;
+  state[1] = 0xbb67ae85;
+  state[2] = 0x3c6ef372;
+  state[3] = 0xa54ff53a;
+  state[4] = 0x510e527f;
+  state[5] = 0x9b05688c;
+  state[6] = 0x1f83d9ab;
+  state[7] = 0x5be0cd19;
+  used = 0;
+  length = 0;
+}
+
+void Sha256::transform(const unsigned char* data) {
+  uint32_t w[64];
+  uint32_t a, b, c, d, e, f, g, h, t1, t2;
+  unsigned int i;
+
+  for (i = 0; i < 16; i++) {
+    w[i] = ((uint32_t)data[i * 4] << 24) |
+      ((uint32_t)data[i * 4 + 1] << 16) |
+      ((uint32_t)data[i * 4 + 2] << 8) |
+      (uint32_t)data[i * 4 + 3];
+  }
+  for (; i < 64; i++) {
+    w[i] = (rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10)) +
+      w[i - 7] +
+      (rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3)) +
+      w[i - 16];
+  }
+
+  a = state[0];
+  b = state[1];
+  c = state[2];
+  d = state[3];
+  e = state[4];
+  f = state[5];
+  g = state[6];
+  h = state[7];
+
+  for (i = 0; i < 64; i++) {
+    t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) +
+      ((e & f) ^ (~e & g)) + K[i] + w[i];
+    t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) +
+      ((a & b) ^ (a & c) ^ (b & c));
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + t2;
+  }
+
+  state[0] += a;
+  state[1] += b;
+  state[2] += c;
+  state[3] += d;
+  state[4] += e;
+  state[5] += f;
+  state[6] += g;
+  state[7] += h;
+}
+
+void Sha256::update(const char* data, size_t length) {
+  const unsigned char* d = (const unsigned char*)data;
+  size_t n;
+
+  this->length += length;
+  
+  if (used > 0) {
+    n = 64 - used < length ? 64 - used : length;
+    std::memcpy(block + used, d, n);
+    used += n;
+    d += n;
+    length -= n;
+    if (used < 64)
+      return;
+    transform(block);
+    used = 0;
+  }
+
+  for (; length >= 64; d += 64, length -= 64)
+    transform(d);
+
+  if (length > 0) {
+    std::memcpy(block, d, length);
+    used = length;
+  }
+}
+
+void Sha256::update(const std::string &data) {
+  update(data.data(), data.size());
+}
+
+std::string Sha256::getDigest() {
+  static const char digits[] = "0123456789abcdef";
+  uint64_t bits = length * 8;
+  unsigned char padding[72];
+  size_t n;
+  std::string digest;
+  unsigned int i;
+
+  // a 1 bit, zeros up to 56 bytes into a block, and the length in bits
+  n = used < 56 ? 56 - used : 120 - used;
+  std::memset(padding, 0, sizeof(padding));
+  padding[0] = 0x80;
+  for (i = 0; i < 8; i++)
+    padding[n + i] = (unsigned char)(bits >> (56 - i * 8));
+  update((const char*)padding, n + 8);
+
+  digest.reserve(64);
+  for (i = 0; i < 32; i++) {
+    digest.push_back(digits[(state[i / 4] >> (28 - (i % 4) * 8)) & 0xf]);
+    digest.push_back(digits[(state[i / 4] >> (24 - (i % 4) * 8)) & 0xf]);
+  }
+  return digest;
+}
+
+std::string Sha256::hash(const char* data, size_t length) {
+  Sha256 sha;
+
+  sha.update(data, length);
+  return sha.getDigest();
+}
@@ -0,0 +1,43 @@
+#ifndef __Sha256_h__
+#define __Sha256_h__
+
+#include <string>
+#include <cstddef>
+#include <stdint.h>
+
+/**
+ * SHA-256 digest (FIPS 180-4) of the contents the caches read, so that
+ * files and compilations with the same digest can be taken to be the
+ * same without comparing their contents.
+ */
+class Sha256 {
+private:
+  uint32_t state[8];
+  unsigned char block[64];
+  size_t used;
+  uint64_t length;
+
+  void transform(const unsigned char* data);
+  
+public:
+  Sha256();
+
+  /**
+   * Add <code>length</code> bytes at <code>data</code>.
+   */
+  void update(const char* data, size_t length);
+  void update(const std::string &data);
+
+  /**
+   * The digest of the bytes that were added, as 64 lower case
+   * hexadecimal digits. No more bytes can be added after this.
+   */
+  std::string getDigest();
+
+  /**
+   * The digest of <code>length</code> bytes at <code>data</code>.
+   */
+  static std::string hash(const char* data, size_t length);
+};
+
+#endif
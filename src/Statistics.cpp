@@ -0,0 +1,268 @@
+#include "Statistics.h"
+
+#include <ctime>
+#include <cstdio>
+
+bool Statistics::enabled = false;
+thread_local Statistics::Timer* Statistics::currentPhase = NULL;
+thread_local Statistics::Timer* Statistics::currentFile = NULL;
+thread_local Statistics::Recording* Statistics::recording = NULL;
+
+Statistics::Timer::Timer(Phase phase) {
+  file = false;
+  this->phase = phase;
+  begin();
+}
+
+Statistics::Timer::Timer(const std::string &filename) {
+  file = true;
+  phase = PHASE_COUNT;
+  this->filename = filename;
+  begin();
+}
+
+void Statistics::Timer::begin() {
+  Timer*& current = file ? currentFile : currentPhase;
+
+  running = Statistics::isEnabled();
+  if (!running)
+    return;
+  
+  parent = current;
+  current = this;
+  nested.wall = nested.cpu = 0;
+  start = Statistics::now();
+}
+
+Statistics::Timer::~Timer() {
+  Timer*& current = file ? currentFile : currentPhase;
+  Time end, elapsed;
+
+  if (!running)
+    return;
+  
+  end = Statistics::now();
+  elapsed.wall = end.wall - start.wall;
+  elapsed.cpu = end.cpu - start.cpu;
+  current = parent;
+
+  if (parent != NULL) {
+    parent->nested.wall += elapsed.wall;
+    parent->nested.cpu += elapsed.cpu;
+  }
+  elapsed.wall -= nested.wall;
+  elapsed.cpu -= nested.cpu;
+
+  if (file)
+    Statistics::getInstance().addTime(filename, elapsed);
+  else
+    Statistics::getInstance().addTime(phase, elapsed);
+}
+
+Statistics::Statistics() {
+  int i;
+  
+  for (i = 0; i < COUNTER_COUNT; i++)
+    counters[i] = 0;
+  for (i = 0; i < PHASE_COUNT; i++)
+    phases[i].wall = phases[i].cpu = 0;
+}
+
+Statistics& Statistics::getInstance() {
+  static Statistics statistics;
+  return statistics;
+}
+
+void Statistics::setEnabled(bool enabled) {
+  Statistics& s = getInstance();
+  std::unique_lock<std::mutex> l(s.lock);
+  int i;
+
+  if (enabled) {
+    for (i = 0; i < COUNTER_COUNT; i++)
+      s.counters[i] = 0;
+    for (i = 0; i < PHASE_COUNT; i++)
+      s.phases[i].wall = s.phases[i].cpu = 0;
+    s.files.clear();
+    s.fileIndex.clear();
+    s.functions.clear();
+  }
+  Statistics::enabled = enabled;
+}
+
+Statistics::Time Statistics::now() {
+  struct timespec ts;
+  Time t;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  t.wall = ts.tv_sec + ts.tv_nsec / 1e9;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  t.cpu = ts.tv_sec + ts.tv_nsec / 1e9;
+  return t;
+}
+
+void Statistics::addTime(Phase phase, const Time &time) {
+  std::unique_lock<std::mutex> l(lock);
+
+  phases[phase].wall += time.wall;
+  phases[phase].cpu += time.cpu;
+}
+
+void Statistics::addTime(const std::string &filename, const Time &time) {
+  std::unordered_map<std::string, size_t>::iterator it;
+  std::unique_lock<std::mutex> l(lock);
+  Time* t;
+
+  it = fileIndex.find(filename);
+  if (it == fileIndex.end()) {
+    fileIndex[filename] = files.size();
+    files.push_back(std::make_pair(filename, time));
+  } else {
+    t = &files[it->second].second;
+    t->wall += time.wall;
+    t->cpu += time.cpu;
+  }
+}
+
+void Statistics::countFunction(const std::string &name) {
+  Statistics &s = getInstance();
+  
+  if (!enabled)
+    return;
+  
+  count(FUNCTION_CALLS);
+  if (recording != NULL)
+    recording->functions.push_back(name);
+  std::unique_lock<std::mutex> l(s.lock);
+  s.functions[name]++;
+}
+
+void Statistics::setRecording(Recording* recording) {
+  Statistics::recording = recording;
+}
+
+void Statistics::replay(const Recording &recording) {
+  std::vector<std::string>::const_iterator it;
+  unsigned long long i;
+
+  if (!enabled)
+    return;
+  
+  for (i = 0; i < recording.values; i++)
+    count(VALUES);
+  for (it = recording.functions.begin(); it != recording.functions.end();
+       it++)
+    countFunction(*it);
+}
+
+const char* Statistics::getName(Phase phase) {
+  static const char* names[PHASE_COUNT] = {
+    "tokenize", "parse", "process", "extend", "write"
+  };
+  return names[phase];
+}
+
+const char* Statistics::getName(Counter counter) {
+  static const char* names[COUNTER_COUNT] = {
+    "tokens", "rulesets", "mixin_calls", "guards", "values",
+    "function_calls", "arena_objects"
+  };
+  return names[counter];
+}
+
+void Statistics::write(std::ostream &out) {
+  std::vector<std::pair<std::string, Time> >::iterator f_it;
+  std::map<std::string, unsigned long long>::iterator fn_it;
+  std::unique_lock<std::mutex> l(lock);
+  char line[256];
+  int i;
+
+  out << "Phase           wall (ms)   cpu (ms)\n";
+  for (i = 0; i < PHASE_COUNT; i++) {
+    std::snprintf(line, sizeof(line), "%-12s %12.3f %10.3f\n",
+                  getName((Phase)i), phases[i].wall * 1000,
+                  phases[i].cpu * 1000);
+    out << line;
+  }
+
+  out << "\nFile            wall (ms)   cpu (ms)\n";
+  for (f_it = files.begin(); f_it != files.end(); f_it++) {
+    std::snprintf(line, sizeof(line), "%12.3f %10.3f  ",
+                  f_it->second.wall * 1000, f_it->second.cpu * 1000);
+    out << "             " << line << f_it->first << "\n";
+  }
+
+  out << "\nCounter\n";
+  for (i = 0; i < COUNTER_COUNT; i++) {
+    std::snprintf(line, sizeof(line), "%-16s %12llu\n",
+                  getName((Counter)i), counters[i].load());
+    out << line;
+  }
+
+  if (!functions.empty()) {
+    out << "\nFunction calls\n";
+    for (fn_it = functions.begin(); fn_it != functions.end(); fn_it++) {
+      std::snprintf(line, sizeof(line), "%12llu  ", fn_it->second);
+      out << line << fn_it->first << "\n";
+    }
+  }
+}
+
+void Statistics::writeJsonString(std::ostream &out, const std::string &str) {
+  std::string::const_iterator it;
+  char escape[8];
+
+  out << '"';
+  for (it = str.begin(); it != str.end(); it++) {
+    if (*it == '"' || *it == '\\')
+      out << '\\' << *it;
+    else if ((unsigned char)*it < 0x20) {
+      std::snprintf(escape, sizeof(escape), "\\u%04x", (unsigned char)*it);
+      out << escape;
+    } else
+      out << *it;
+  }
+  out << '"';
+}
+
+void Statistics::writeJson(std::ostream &out) {
+  std::vector<std::pair<std::string, Time> >::iterator f_it;
+  std::map<std::string, unsigned long long>::iterator fn_it;
+  std::unique_lock<std::mutex> l(lock);
+  char number[64];
+  int i;
+
+  out << "{\"phases\":{";
+  for (i = 0; i < PHASE_COUNT; i++) {
+    std::snprintf(number, sizeof(number),
+                  "{\"wall_ms\":%.3f,\"cpu_ms\":%.3f}",
+                  phases[i].wall * 1000, phases[i].cpu * 1000);
+    out << (i > 0 ? "," : "") << '"' << getName((Phase)i) << "\":" <<
+      number;
+  }
+  
+  out << "},\"files\":[";
+  for (f_it = files.begin(); f_it != files.end(); f_it++) {
+    out << (f_it != files.begin() ? "," : "") << "{\"file\":";
+    writeJsonString(out, f_it->first);
+    std::snprintf(number, sizeof(number),
+                  ",\"wall_ms\":%.3f,\"cpu_ms\":%.3f}",
+                  f_it->second.wall * 1000, f_it->second.cpu * 1000);
+    out << number;
+  }
+  
+  out << "],\"counters\":{";
+  for (i = 0; i < COUNTER_COUNT; i++) {
+    out << (i > 0 ? "," : "") << '"' << getName((Counter)i) << "\":" <<
+      counters[i].load();
+  }
+  
+  out << "},\"functions\":{";
+  for (fn_it = functions.begin(); fn_it != functions.end(); fn_it++) {
+    if (fn_it != functions.begin())
+      out << ",";
+    writeJsonString(out, fn_it->first);
+    out << ":" << fn_it->second;
+  }
+  out << "}}\n";
+}
@@ -0,0 +1,149 @@
+#ifndef __Statistics_h__
+#define __Statistics_h__
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <mutex>
+#include <atomic>
+#include <iostream>
+
+/**
+ * Process wide timings and counters of the compilations, reported by
+ * <code>lessc --stats</code>. Nothing is recorded unless the statistics
+ * are enabled, so the counting points only cost a check of a flag.
+ *
+ * Values and function calls are counted when they are evaluated. A
+ * function call that is folded into a constant is counted every time
+ * the value is used, and so are the values and calls of a mixin
+ * expansion that is reused.
+ *
+ * The time of a phase doesn't include the phases that run inside it:
+ * importing files is part of parsing, but the time spent reading and
+ * tokenizing them is counted as tokenizing. The input file itself is
+ * tokenized while it is parsed, which counts as parsing. The times of
+ * the threads that read imports and compile batch jobs are added up.
+ *
+ * The statistics are thread safe.
+ */
+class Statistics {
+public:
+  enum Phase {
+    TOKENIZE, PARSE, PROCESS, EXTEND, WRITE, PHASE_COUNT
+  };
+  enum Counter {
+    TOKENS, RULESETS, MIXIN_CALLS, GUARDS, VALUES, FUNCTION_CALLS,
+    ARENA_OBJECTS, COUNTER_COUNT
+  };
+
+  /**
+   * The values and function calls counted on a thread while it
+   * records them, so they can be counted again when the result is
+   * reused.
+   */
+  struct Recording {
+    unsigned long long values;
+    std::vector<std::string> functions;
+
+    Recording(): values(0) {
+    }
+  };
+
+  /**
+   * Wall and CPU time in seconds.
+   */
+  struct Time {
+    double wall;
+    double cpu;
+  };
+
+  /**
+   * Measures the time until the scope is left and adds it to a phase
+   * or a file, less the time of the timers of the same kind that were
+   * started in the scope on the same thread.
+   */
+  class Timer {
+  private:
+    Timer* parent;
+    bool file;
+    Phase phase;
+    std::string filename;
+    Time start;
+    Time nested;
+    bool running;
+
+    void begin();
+
+  public:
+    Timer(Phase phase);
+    Timer(const std::string &filename);
+    ~Timer();
+  };
+  
+private:
+  static bool enabled;
+  static thread_local Timer* currentPhase;
+  static thread_local Timer* currentFile;
+  static thread_local Recording* recording;
+  
+  std::atomic<unsigned long long> counters[COUNTER_COUNT];
+  Time phases[PHASE_COUNT];
+  /**
+   * The files in the order they were first timed.
+   */
+  std::vector<std::pair<std::string, Time> > files;
+  std::unordered_map<std::string, size_t> fileIndex;
+  std::map<std::string, unsigned long long> functions;
+  std::mutex lock;
+
+  Statistics();
+
+  static Time now();
+  void addTime(Phase phase, const Time &time);
+  void addTime(const std::string &filename, const Time &time);
+
+  static const char* getName(Phase phase);
+  static const char* getName(Counter counter);
+  static void writeJsonString(std::ostream &out, const std::string &str);
+
+public:
+  static Statistics& getInstance();
+
+  /**
+   * Start or stop recording. Enabling clears the statistics. It has
+   * to be done before the compilations start.
+   */
+  static void setEnabled(bool enabled);
+  static bool isEnabled() {
+    return enabled;
+  }
+
+  static void count(Counter counter) {
+    if (enabled) {
+      getInstance().counters[counter].fetch_add(1, std::memory_order_relaxed);
+      if (counter == VALUES && recording != NULL)
+        recording->values++;
+    }
+  }
+  /**
+   * Count a call of the function <code>name</code>.
+   */
+  static void countFunction(const std::string &name);
+
+  /**
+   * Add the values and function calls counted on this thread to
+   * <code>recording</code> from now on, or stop if it is NULL.
+   */
+  static void setRecording(Recording* recording);
+  /**
+   * Count the values and function calls of a recording again.
+   */
+  static void replay(const Recording &recording);
+
+  void write(std::ostream &out);
+  void writeJson(std::ostream &out);
+};
+
+#endif
@@ -0,0 +1,165 @@
+#include "SymbolTable.h"
+
+/**
+ * The names that are in the fixed table: the builtin tokens and the
+ * delimiters of selectors, the common properties and keywords, and
+ * the variables every mixin has.
+ */
+static const char* const WELL_KNOWN[] = {
+  " ", ",", "(", ")", ".", "#", ":", "::", "*", ">", "+", "~", "&",
+  "=", "/", "!", ";", "and", "not", "when", "only", "all", "screen",
+  "print", "@arguments", "@rest", "@media", "@import", "@font-face",
+  "@keyframes", "@charset", "@page", "@supports",
+
+  "background", "background-attachment", "background-clip",
+  "background-color", "background-image", "background-origin",
+  "background-position", "background-repeat", "background-size",
+  "border", "border-bottom", "border-bottom-color",
+  "border-bottom-left-radius", "border-bottom-right-radius",
+  "border-bottom-style", "border-bottom-width", "border-collapse",
+  "border-color", "border-left", "border-left-color",
+  "border-left-style", "border-left-width", "border-radius",
+  "border-right", "border-right-color", "border-right-style",
+  "border-right-width", "border-spacing", "border-style",
+  "border-top", "border-top-color", "border-top-left-radius",
+  "border-top-right-radius", "border-top-style", "border-top-width",
+  "border-width", "bottom", "box-shadow", "box-sizing", "clear",
+  "clip", "color", "content", "cursor", "display", "filter", "flex",
+  "flex-direction", "flex-wrap", "float", "font", "font-family",
+  "font-size", "font-style", "font-variant", "font-weight", "height",
+  "left", "letter-spacing", "line-height", "list-style",
+  "list-style-type", "margin", "margin-bottom", "margin-left",
+  "margin-right", "margin-top", "max-height", "max-width",
+  "min-height", "min-width", "opacity", "outline", "overflow",
+  "overflow-x", "overflow-y", "padding", "padding-bottom",
+  "padding-left", "padding-right", "padding-top", "position",
+  "right", "text-align", "text-decoration", "text-indent",
+  "text-overflow", "text-shadow", "text-transform", "top",
+  "transform", "transition", "vertical-align", "visibility",
+  "white-space", "width", "word-wrap", "z-index",
+
+  "absolute", "auto", "block", "bold", "both", "center", "collapse",
+  "dashed", "default", "dotted", "fixed", "hidden", "important",
+  "inherit", "initial", "inline", "inline-block", "italic", "middle",
+  "no-repeat", "none", "normal", "nowrap", "pointer", "relative",
+  "repeat", "repeat-x", "repeat-y", "scroll", "solid", "static",
+  "transparent", "underline", "visible",
+
+  "black", "blue", "gray", "green", "red", "white", "yellow",
+  
+  "a", "body", "button", "div", "form", "h1", "h2", "h3", "h4", "h5",
+  "h6", "hover", "active", "focus", "before", "after", "first-child",
+  "last-child", "img", "input", "label", "li", "nth-child", "p",
+  "select", "span", "table", "td", "textarea", "th", "tr", "ul",
+  NULL
+};
+
+/**
+ * The symbol of the first string in the process wide table.
+ */
+static const Symbol DEFAULT_FIRST = 1u << 31;
+
+const Symbol SymbolTable::NONE;
+thread_local SymbolTable* SymbolTable::current = NULL;
+
+SymbolTable::SymbolTable(const char* const* names) {
+  first = 1;
+  for (; *names != NULL; names++)
+    insert(*names);
+}
+
+SymbolTable::SymbolTable() {
+  const SymbolTable &fixed = getFixed();
+
+  first = fixed.first + fixed.strings.size();
+}
+
+SymbolTable::SymbolTable(Symbol first) {
+  this->first = first;
+}
+
+const SymbolTable& SymbolTable::getFixed() {
+  static const SymbolTable table(WELL_KNOWN);
+  return table;
+}
+
+SymbolTable& SymbolTable::getDefault() {
+  static SymbolTable table(DEFAULT_FIRST);
+  return table;
+}
+
+SymbolTable& SymbolTable::getTable() {
+  return current != NULL ? *current : getDefault();
+}
+
+Symbol SymbolTable::find(const std::string &str) const {
+  std::unordered_map<std::string, Symbol>::const_iterator it =
+    symbols.find(str);
+
+  return it == symbols.end() ? NONE : it->second;
+}
+
+Symbol SymbolTable::insert(const std::string &str) {
+  std::pair<std::unordered_map<std::string, Symbol>::iterator, bool> ret;
+
+  ret = symbols.insert(std::make_pair(str, first + (Symbol)strings.size()));
+  if (ret.second)
+    strings.push_back(&ret.first->first);
+  return ret.first->second;
+}
+
+const std::string* SymbolTable::get(Symbol symbol) const {
+  if (symbol < first || symbol - first >= strings.size())
+    return NULL;
+  return strings[symbol - first];
+}
+
+Symbol SymbolTable::intern(const std::string &str) {
+  Symbol symbol = getFixed().find(str);
+  SymbolTable* t;
+
+  if (symbol != NONE)
+    return symbol;
+  
+  t = &getTable();
+  std::unique_lock<std::mutex> l(t->lock);
+  return t->insert(str);
+}
+
+const std::string& SymbolTable::getString(Symbol symbol) {
+  static const std::string empty;
+  const std::string* str = getFixed().get(symbol);
+  SymbolTable* t;
+
+  if (str != NULL)
+    return *str;
+  
+  t = symbol >= DEFAULT_FIRST ? &getDefault() : &getTable();
+  std::unique_lock<std::mutex> l(t->lock);
+  str = t->get(symbol);
+  return str != NULL ? *str : empty;
+}
+
+size_t SymbolTable::size() {
+  SymbolTable &t = getTable();
+  std::unique_lock<std::mutex> l(t.lock);
+  
+  return getFixed().strings.size() + t.strings.size();
+}
+
+SymbolTable* SymbolTable::getCurrent() {
+  return current;
+}
+
+void SymbolTable::setCurrent(SymbolTable* table) {
+  current = table;
+}
+
+SymbolScope::SymbolScope(SymbolTable &table) {
+  previous = SymbolTable::getCurrent();
+  SymbolTable::setCurrent(&table);
+}
+
+SymbolScope::~SymbolScope() {
+  SymbolTable::setCurrent(previous);
+}
@@ -0,0 +1,115 @@
+#ifndef __SymbolTable_h__
+#define __SymbolTable_h__
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <mutex>
+
+/**
+ * Integer id of an interned string. Equal strings have equal symbols,
+ * so symbols can be compared instead of the strings themselves.
+ */
+typedef unsigned int Symbol;
+
+/**
+ * Table of interned identifiers, variable names and property names.
+ *
+ * The well-known names (common properties, keywords and the builtin
+ * tokens) are in a fixed table that is filled in once and shared by
+ * every thread without locking. The other strings are interned in the
+ * table of the compilation, which a SymbolScope makes current on the
+ * thread that runs it, and which is thrown away with the compilation;
+ * a daemon or watch process doesn't keep the names of every
+ * stylesheet it compiled. Symbols from one compilation mean nothing in
+ * another, so tokens that are shared between compilations, like the
+ * ones in the ImportCache, are not interned.
+ *
+ * Strings interned outside of a compilation go to a process wide table
+ * that is never emptied. Its symbols have the top bit set, so they
+ * can't collide with the symbols of a compilation and are found
+ * from inside one.
+ */
+class SymbolTable {
+private:
+  std::unordered_map<std::string, Symbol> symbols;
+  std::vector<const std::string*> strings;
+  /**
+   * The symbol of the first string in this table.
+   */
+  Symbol first;
+  std::mutex lock;
+
+  static thread_local SymbolTable* current;
+
+  /**
+   * The table of well-known names.
+   */
+  static const SymbolTable& getFixed();
+  /**
+   * The table that is used outside of a compilation.
+   */
+  static SymbolTable& getDefault();
+  static SymbolTable& getTable();
+  
+  SymbolTable(const char* const* names);
+  SymbolTable(Symbol first);
+
+  Symbol find(const std::string &str) const;
+  Symbol insert(const std::string &str);
+  const std::string* get(Symbol symbol) const;
+  
+  // not copyable
+  SymbolTable(const SymbolTable &t);
+  SymbolTable& operator=(const SymbolTable &t);
+
+public:
+  /**
+   * Symbol 0 is never handed out and means 'not interned'.
+   */
+  static const Symbol NONE = 0;
+
+  /**
+   * Create the table of a compilation.
+   */
+  SymbolTable();
+  
+  /**
+   * Returns the symbol for <code>str</code>, adding it to the current
+   * table if it has not been seen before.
+   */
+  static Symbol intern(const std::string &str);
+
+  /**
+   * Returns the string that <code>symbol</code> stands for.
+   */
+  static const std::string& getString(Symbol symbol);
+
+  /**
+   * Returns the number of strings in the fixed table and the current
+   * table.
+   */
+  static size_t size();
+
+  /**
+   * Returns the table strings are interned in on the calling thread,
+   * or NULL if the process wide table is used.
+   */
+  static SymbolTable* getCurrent();
+  static void setCurrent(SymbolTable* table);
+};
+
+/**
+ * Makes the table of a compilation the current table of the thread
+ * until the scope is left.
+ */
+class SymbolScope {
+private:
+  SymbolTable* previous;
+
+public:
+  SymbolScope(SymbolTable &table);
+  ~SymbolScope();
+};
+
+#endif
@@ -8,21 +8,36 @@ const Token Token::BUILTIN_COMMA(",", Token::OTHER, 0,0, BUILTIN_SOURCE);
 const Token Token::BUILTIN_PAREN_OPEN("(", Token::PAREN_OPEN, 0,0, BUILTIN_SOURCE);
 const Token Token::BUILTIN_PAREN_CLOSED(")", Token::PAREN_CLOSED, 0,0, BUILTIN_SOURCE);
 
+/**
+ * The builtin tokens are shared by every thread, so their symbols are
+ * interned up front instead of by the first getSymbol() call.
+ */
+static bool internBuiltins() {
+  Token::BUILTIN_SPACE.getSymbol();
+  Token::BUILTIN_COMMA.getSymbol();
+  Token::BUILTIN_PAREN_OPEN.getSymbol();
+  Token::BUILTIN_PAREN_CLOSED.getSymbol();
+  return true;
+}
+static const bool builtinsInterned = internBuiltins();
+
 Token::Token ():
-  line(0), column(0), source(BUILTIN_SOURCE), type(OTHER) {
+  symbol(SymbolTable::NONE), line(0), column(0), source(BUILTIN_SOURCE),
+  type(OTHER) {
 }
 
 Token::Token (unsigned int line,
               unsigned int column,
               const char* source):
-  line(line), column(column), source(source), type(OTHER) {
+  symbol(SymbolTable::NONE), line(line), column(column), source(source),
+  type(OTHER) {
 }
 
 Token::Token (const std::string &s, Type t,
               unsigned int line,
               unsigned int column,
               const char* source):
-  line(line), column(column), source(source) {
+  symbol(SymbolTable::NONE), line(line), column(column), source(source) {
   type = t;
   append(s);
 }
@@ -34,6 +49,7 @@ void Token::setLocation(const Token &ref)  {
 }
 
 void Token::clear () {
+  symbol = SymbolTable::NONE;
   std::string::clear();
   type = OTHER;
 }
@@ -44,6 +60,7 @@ bool Token::stringHasQuotes() const {
 }
 
 void Token::removeQuotes() {
+  symbol = SymbolTable::NONE;
   removeQuotes(*this);
 }
 
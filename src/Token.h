@@ -3,10 +3,29 @@
 #define __Token_h__
 
 #include <string>
-
+#include "SymbolTable.h"
+
+/**
+ * A token read by a tokenizer, or generated while processing.
+ *
+ * The token owns its text instead of pointing into the source buffer:
+ * the parser and the processing code rely on the std::string interface
+ * (comparisons, find, substr, passing tokens as const std::string&),
+ * short tokens fit in the string without a heap allocation, and tokens
+ * outlive their buffer in the ImportCache and in closures. Lists of
+ * tokens are moved rather than copied where they are built.
+ */
 class Token: public std::string {
 
 protected:
+  /**
+   * The interned text of the token, or SymbolTable::NONE. The
+   * tokenizer interns identifiers and at-keywords; other tokens are
+   * interned when getSymbol() is first called. Members that change the
+   * text reset it, so code that modifies a token should do so through
+   * the Token interface rather than std::string.
+   */
+  mutable Symbol symbol;
  
 public:
   unsigned int line, column;
@@ -35,6 +54,15 @@ public:
          const char* source);
 
 
+  /**
+   * Returns the symbol of the token text, interning it if needed.
+   */
+  inline Symbol getSymbol() const {
+    if (symbol == SymbolTable::NONE)
+      symbol = SymbolTable::intern(*this);
+    return symbol;
+  }
+
   /**
    * Copy line, column and source from the reference token.
    */
@@ -68,15 +96,32 @@ public:
   std::string getUrlString() const;
   
   inline std::string& append(char c) {
+    symbol = SymbolTable::NONE;
     return std::string::append(1, c);
   }
   inline std::string& append(const std::string &c) {
+    symbol = SymbolTable::NONE;
     return std::string::append(c);
   }
+  inline std::string& append(const char* s, size_t n) {
+    symbol = SymbolTable::NONE;
+    return std::string::append(s, n);
+  }
+  inline std::string& insert(size_t pos, const char* s) {
+    symbol = SymbolTable::NONE;
+    return std::string::insert(pos, s);
+  }
+  inline std::string& replace(size_t pos, size_t n, const std::string &s) {
+    symbol = SymbolTable::NONE;
+    return std::string::replace(pos, n, s);
+  }
 
   inline bool operator == (const Token &t) const {
-    return (type == t.type &&
-            (std::string)*this == (std::string)t);
+    if (type != t.type)
+      return false;
+    if (symbol != SymbolTable::NONE && t.symbol != SymbolTable::NONE)
+      return symbol == t.symbol;
+    return (const std::string&)*this == (const std::string&)t;
   }
   inline bool operator != (const Token &t) const {
     return !(*this == t);
@@ -99,6 +144,7 @@ public:
   }
 
   inline Token& operator= (const std::string& str) {
+    symbol = SymbolTable::NONE;
     std::string::assign(str);
     return *this;
   }
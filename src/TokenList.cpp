@@ -1,14 +1,17 @@
 
 #include "TokenList.h"
 
+#include <algorithm>
+
 TokenList::~TokenList() {
 }
 
+static bool isNotWhitespace(const Token &t) {
+  return t.type != Token::WHITESPACE;
+}
+
 void TokenList::ltrim() {
-  while (!empty() &&
-         front().type == Token::WHITESPACE) {
-    pop_front();
-  }
+  erase(begin(), std::find_if(begin(), end(), isNotWhitespace));
 }
 void TokenList::rtrim() {
   while (!empty() &&
@@ -24,7 +27,7 @@ void TokenList::trim() {
   
 std::string TokenList::toString() const {
   std::string str;
-  std::list<Token>::const_iterator it;
+  TokenList::const_iterator it;
   
   for (it = begin(); it != end(); it++) {
     str.append(*it);
@@ -33,7 +36,7 @@ std::string TokenList::toString() const {
 }
 
 bool TokenList::contains(const Token &t) const {
-  std::list<Token>::const_iterator it;
+  TokenList::const_iterator it;
 
   for (it = begin(); it != end(); it++) {
     if (*it == t)
@@ -44,7 +47,7 @@ bool TokenList::contains(const Token &t) const {
 
 bool TokenList::contains(Token::Type type, const std::string &str)
   const {
-  std::list<Token>::const_iterator it;
+  TokenList::const_iterator it;
 
   for (it = begin(); it != end(); it++) {
     if ((*it).type == type && *it == str)
@@ -54,7 +57,7 @@ bool TokenList::contains(Token::Type type, const std::string &str)
 }
 
 bool TokenList::containsType(Token::Type type) const {
-  std::list<Token>::const_iterator it;
+  TokenList::const_iterator it;
 
   for (it = begin(); it != end(); it++) {
     if ((*it).type == type)
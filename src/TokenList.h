@@ -3,12 +3,43 @@
 #define __TokenList_h__
 
 #include "Token.h"
-#include <list>
+#include <vector>
 
-class TokenList: public std::list<Token> {
+/**
+ * A sequence of tokens stored in one contiguous block of memory.
+ *
+ * Token lists are mostly appended to and walked from front to back, so
+ * a vector keeps them cache friendly and saves an allocation per
+ * token. Note that, unlike with a linked list, inserting or erasing
+ * tokens invalidates iterators into the same list.
+ */
+class TokenList: public std::vector<Token> {
   
 public:
+  TokenList() {}
+  TokenList(const TokenList &) = default;
+
+  /**
+   * Lists are moved, not copied, when they are returned or inserted
+   * into containers. The destructor would otherwise suppress the
+   * implicit move operations.
+   */
+  TokenList(TokenList &&) = default;
+  TokenList& operator=(const TokenList &) = default;
+  TokenList& operator=(TokenList &&) = default;
   virtual ~TokenList();
+
+  /**
+   * Remove the first token. This moves the remaining tokens, so a loop
+   * that consumes tokens from the front should advance an iterator and
+   * erase() the tokens it used at once.
+   */
+  inline void pop_front() {
+    erase(begin());
+  }
+  inline void push_front(const Token &t) {
+    insert(begin(), t);
+  }
   
 
   /**
@@ -1,7 +1,7 @@
 
 #include "VariableMap.h"
 
-const TokenList* VariableMap::getVariable(const std::string &key) const {
+const TokenList* VariableMap::getVariable(Symbol key) const {
   VariableMap::const_iterator mit;
 
   if ((mit = this->find(key)) != this->end()) {
@@ -28,7 +28,7 @@ std::string VariableMap::toString() const {
   VariableMap::const_iterator it;
   
   for (it = this->cbegin(); it != this->cend(); ++it) {
-    str.append(it->first);
+    str.append(SymbolTable::getString(it->first));
     str.append(": ");
     str.append(it->second.toString());
     str.append("\n");
@@ -1,14 +1,17 @@
-
 #ifndef __VariableMap_h__
 #define __VariableMap_h__
 
 #include "TokenList.h"
+#include "SymbolTable.h"
 #include <map>
 
-class VariableMap: public std::map<std::string, TokenList> {
+/**
+ * Variables keyed by the symbol of their name (including the '@').
+ */
+class VariableMap: public std::map<Symbol, TokenList> {
   
 public:
-  const TokenList* getVariable(const std::string &key) const ;
+  const TokenList* getVariable(Symbol key) const ;
   void merge(const VariableMap &map);
 
   void overwrite(const VariableMap &map);
@@ -0,0 +1,41 @@
+#include "WorkingDirectory.h"
+
+#include <unistd.h>
+#include <climits>
+
+std::string WorkingDirectory::directory;
+bool WorkingDirectory::valid = false;
+std::mutex WorkingDirectory::lock;
+
+void WorkingDirectory::update() {
+  char buffer[PATH_MAX];
+  std::unique_lock<std::mutex> l(lock);
+
+  if (getcwd(buffer, sizeof(buffer)) == NULL)
+    directory.clear();
+  else
+    directory = buffer;
+  valid = true;
+}
+
+std::string WorkingDirectory::get() {
+  {
+    std::unique_lock<std::mutex> l(lock);
+    if (valid)
+      return directory;
+  }
+  update();
+  return get();
+}
+
+std::string WorkingDirectory::getKey(const std::string &path) {
+  std::string key;
+
+  if (!path.empty() && path[0] == '/')
+    return path;
+
+  key = get();
+  key.push_back('\0');
+  key.append(path);
+  return key;
+}
@@ -0,0 +1,43 @@
+#ifndef __WorkingDirectory_h__
+#define __WorkingDirectory_h__
+
+#include <string>
+#include <mutex>
+
+/**
+ * The working directory of the process, which the file caches add to
+ * their keys. A daemon changes its working directory to that of each
+ * client, so the same relative path can name different files from one
+ * compilation to the next.
+ *
+ * The directory is read once and kept until update() is called, so
+ * the caches don't call getcwd() for every lookup.
+ */
+class WorkingDirectory {
+private:
+  static std::string directory;
+  static bool valid;
+  static std::mutex lock;
+  
+public:
+  /**
+   * Read the working directory again. Called when a compilation
+   * starts.
+   */
+  static void update();
+  
+  /**
+   * The current working directory, or an empty string if it can't be
+   * determined.
+   */
+  static std::string get();
+
+  /**
+   * A key for <code>path</code> that only matches the same path from
+   * the same working directory: relative paths are prefixed with the
+   * working directory and a '\0'. Absolute paths are their own key.
+   */
+  static std::string getKey(const std::string &path);
+};
+
+#endif
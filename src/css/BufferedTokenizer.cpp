@@ -0,0 +1,78 @@
+#include "BufferedTokenizer.h"
+
+BufferedTokenizer::BufferedTokenizer(const char* source):
+  CssTokenizer(NULL, 0, source), next(0), parseError(NULL),
+  ioError(NULL) {
+}
+
+BufferedTokenizer::BufferedTokenizer(TokenVector tokens,
+                                     const char* source):
+  CssTokenizer(NULL, 0, source), tokens(tokens), next(0),
+  parseError(NULL), ioError(NULL) {
+}
+
+BufferedTokenizer::~BufferedTokenizer() {
+  if (parseError != NULL)
+    delete parseError;
+  if (ioError != NULL)
+    delete ioError;
+}
+
+void BufferedTokenizer::read(CssTokenizer &tokenizer) {
+  std::vector<Token>* v = new std::vector<Token>();
+
+  tokens = TokenVector(v);
+  next = 0;
+  
+  try {
+    do {
+      tokenizer.readNextToken();
+      v->push_back(tokenizer.getToken());
+    } while (tokenizer.getTokenType() != Token::EOS);
+    
+  } catch (ParseException* e) {
+    parseError = e;
+  } catch (IOException* e) {
+    ioError = e;
+  }
+}
+
+BufferedTokenizer::TokenVector BufferedTokenizer::getTokens() const {
+  return tokens;
+}
+
+const std::string &BufferedTokenizer::getHash() const {
+  return hash;
+}
+
+void BufferedTokenizer::setHash(const std::string &hash) {
+  this->hash = hash;
+}
+
+bool BufferedTokenizer::hasError() const {
+  return parseError != NULL || ioError != NULL;
+}
+
+Token::Type BufferedTokenizer::readNextToken() {
+  ParseException* pe;
+  IOException* ioe;
+  
+  if (tokens && next < tokens->size()) {
+    currentToken = (*tokens)[next++];
+
+    if (currentToken.type == Token::IDENTIFIER ||
+        currentToken.type == Token::ATKEYWORD)
+      currentToken.getSymbol();
+    
+  } else if (parseError != NULL) {
+    pe = parseError;
+    parseError = NULL;
+    throw pe;
+    
+  } else if (ioError != NULL) {
+    ioe = ioError;
+    ioError = NULL;
+    throw ioe;
+  }
+  return currentToken.type;
+}
@@ -0,0 +1,61 @@
+#ifndef __BufferedTokenizer_h__
+#define __BufferedTokenizer_h__
+
+#include <vector>
+#include <memory>
+#include "CssTokenizer.h"
+
+/**
+ * Returns the tokens that another tokenizer read in advance, so a file
+ * can be tokenized on one thread and parsed on another, or tokenized
+ * once and parsed any number of times.
+ *
+ * The tokens are stored without symbols; the symbols of identifiers
+ * and at-keywords are interned when the tokens are returned, the same
+ * as the CssTokenizer does. If the tokenizer threw an exception it is
+ * thrown again after the last token that was read before it.
+ */
+class BufferedTokenizer: public CssTokenizer {
+public:
+  typedef std::shared_ptr<const std::vector<Token> > TokenVector;
+  
+private:
+  TokenVector tokens;
+  size_t next;
+  ParseException* parseError;
+  IOException* ioError;
+  std::string hash;
+
+public:
+  BufferedTokenizer(const char* source);
+  /**
+   * Return <code>tokens</code>, which may be shared with other
+   * BufferedTokenizers.
+   */
+  BufferedTokenizer(TokenVector tokens, const char* source);
+  virtual ~BufferedTokenizer();
+
+  /**
+   * Read the tokens from <code>tokenizer</code> until the end of the
+   * input or until it throws an exception.
+   */
+  void read(CssTokenizer &tokenizer);
+
+  TokenVector getTokens() const;
+
+  /**
+   * The digest of the contents the tokens were read from, or an empty
+   * string if it was not set.
+   */
+  const std::string &getHash() const;
+  void setHash(const std::string &hash);
+
+  /**
+   * Returns true if the tokenizer that was read threw an exception.
+   */
+  bool hasError() const;
+
+  virtual Token::Type readNextToken();
+};
+
+#endif
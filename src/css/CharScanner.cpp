@@ -0,0 +1,275 @@
+#include "CharScanner.h"
+
+#include <config.h>
+
+#if defined(WITH_SIMD) && defined(__SSE2__)
+#define CHARSCANNER_SSE2
+#include <emmintrin.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+// AVX2 functions are compiled with a target attribute and only called
+// if the processor supports them.
+#define CHARSCANNER_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+#define ESCAPE_CHAR 27
+
+typedef const char* (*scanFunction)(const char* p, const char* end);
+typedef const char* (*scanStringFunction)(const char* p, const char* end,
+                                          char delim);
+
+static inline bool isWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f';
+}
+
+static const char* whitespaceEndScalar(const char* p, const char* end) {
+  while (p < end && isWhitespace(*p))
+    p++;
+  return p;
+}
+
+static const char* commentEndScalar(const char* p, const char* end) {
+  for (; p < end; p++) {
+    if (*p == ESCAPE_CHAR ||
+        (*p == '*' && p + 1 < end && p[1] == '/'))
+      return p;
+  }
+  return end;
+}
+
+static const char* lineEndScalar(const char* p, const char* end) {
+  for (; p < end; p++) {
+    if (*p == '\n' || *p == ESCAPE_CHAR)
+      return p;
+  }
+  return end;
+}
+
+static const char* stringEndScalar(const char* p, const char* end,
+                                   char delim) {
+  for (; p < end; p++) {
+    if (*p == delim || *p == '\\' || *p == '\n' || *p == '\r' ||
+        *p == '\f' || *p == ESCAPE_CHAR)
+      return p;
+  }
+  return end;
+}
+
+#ifdef CHARSCANNER_SSE2
+
+static inline __m128i eq16(__m128i v, char c) {
+  return _mm_cmpeq_epi8(v, _mm_set1_epi8(c));
+}
+
+static const char* whitespaceEndSSE2(const char* p, const char* end) {
+  __m128i v;
+  int mask;
+
+  for (; end - p >= 16; p += 16) {
+    v = _mm_loadu_si128((const __m128i*)p);
+    mask = _mm_movemask_epi8(_mm_or_si128(
+      _mm_or_si128(eq16(v, ' '), eq16(v, '\t')),
+      _mm_or_si128(_mm_or_si128(eq16(v, '\r'), eq16(v, '\n')),
+                   eq16(v, '\f')))) ^ 0xFFFF;
+    if (mask != 0)
+      return p + __builtin_ctz(mask);
+  }
+  return whitespaceEndScalar(p, end);
+}
+
+static const char* commentEndSSE2(const char* p, const char* end) {
+  __m128i v;
+  int mask;
+
+  for (; end - p >= 16; p += 16) {
+    v = _mm_loadu_si128((const __m128i*)p);
+    mask = _mm_movemask_epi8(_mm_or_si128(eq16(v, '*'),
+                                          eq16(v, ESCAPE_CHAR)));
+    while (mask != 0) {
+      const char* c = p + __builtin_ctz(mask);
+      if (*c == ESCAPE_CHAR || (c + 1 < end && c[1] == '/'))
+        return c;
+      mask &= mask - 1;
+    }
+  }
+  return commentEndScalar(p, end);
+}
+
+static const char* lineEndSSE2(const char* p, const char* end) {
+  __m128i v;
+  int mask;
+
+  for (; end - p >= 16; p += 16) {
+    v = _mm_loadu_si128((const __m128i*)p);
+    mask = _mm_movemask_epi8(_mm_or_si128(eq16(v, '\n'),
+                                          eq16(v, ESCAPE_CHAR)));
+    if (mask != 0)
+      return p + __builtin_ctz(mask);
+  }
+  return lineEndScalar(p, end);
+}
+
+static const char* stringEndSSE2(const char* p, const char* end,
+                                 char delim) {
+  __m128i v;
+  int mask;
+
+  for (; end - p >= 16; p += 16) {
+    v = _mm_loadu_si128((const __m128i*)p);
+    mask = _mm_movemask_epi8(_mm_or_si128(
+      _mm_or_si128(_mm_or_si128(eq16(v, delim), eq16(v, '\\')),
+                   _mm_or_si128(eq16(v, '\n'), eq16(v, '\r'))),
+      _mm_or_si128(eq16(v, '\f'), eq16(v, ESCAPE_CHAR))));
+    if (mask != 0)
+      return p + __builtin_ctz(mask);
+  }
+  return stringEndScalar(p, end, delim);
+}
+
+#endif
+
+#ifdef CHARSCANNER_AVX2
+
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+
+AVX2_FUNCTION static inline __m256i eq32(__m256i v, char c) {
+  return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c));
+}
+
+AVX2_FUNCTION
+static const char* whitespaceEndAVX2(const char* p, const char* end) {
+  __m256i v;
+  unsigned int mask;
+
+  for (; end - p >= 32; p += 32) {
+    v = _mm256_loadu_si256((const __m256i*)p);
+    mask = ~(unsigned int)_mm256_movemask_epi8(_mm256_or_si256(
+      _mm256_or_si256(eq32(v, ' '), eq32(v, '\t')),
+      _mm256_or_si256(_mm256_or_si256(eq32(v, '\r'), eq32(v, '\n')),
+                      eq32(v, '\f'))));
+    if (mask != 0)
+      return p + __builtin_ctz(mask);
+  }
+  return whitespaceEndSSE2(p, end);
+}
+
+AVX2_FUNCTION
+static const char* commentEndAVX2(const char* p, const char* end) {
+  __m256i v;
+  unsigned int mask;
+
+  for (; end - p >= 32; p += 32) {
+    v = _mm256_loadu_si256((const __m256i*)p);
+    mask = _mm256_movemask_epi8(_mm256_or_si256(eq32(v, '*'),
+                                                eq32(v, ESCAPE_CHAR)));
+    while (mask != 0) {
+      const char* c = p + __builtin_ctz(mask);
+      if (*c == ESCAPE_CHAR || (c + 1 < end && c[1] == '/'))
+        return c;
+      mask &= mask - 1;
+    }
+  }
+  return commentEndSSE2(p, end);
+}
+
+AVX2_FUNCTION
+static const char* lineEndAVX2(const char* p, const char* end) {
+  __m256i v;
+  unsigned int mask;
+
+  for (; end - p >= 32; p += 32) {
+    v = _mm256_loadu_si256((const __m256i*)p);
+    mask = _mm256_movemask_epi8(_mm256_or_si256(eq32(v, '\n'),
+                                                eq32(v, ESCAPE_CHAR)));
+    if (mask != 0)
+      return p + __builtin_ctz(mask);
+  }
+  return lineEndSSE2(p, end);
+}
+
+AVX2_FUNCTION
+static const char* stringEndAVX2(const char* p, const char* end,
+                                 char delim) {
+  __m256i v;
+  unsigned int mask;
+
+  for (; end - p >= 32; p += 32) {
+    v = _mm256_loadu_si256((const __m256i*)p);
+    mask = _mm256_movemask_epi8(_mm256_or_si256(
+      _mm256_or_si256(_mm256_or_si256(eq32(v, delim), eq32(v, '\\')),
+                      _mm256_or_si256(eq32(v, '\n'), eq32(v, '\r'))),
+      _mm256_or_si256(eq32(v, '\f'), eq32(v, ESCAPE_CHAR))));
+    if (mask != 0)
+      return p + __builtin_ctz(mask);
+  }
+  return stringEndSSE2(p, end, delim);
+}
+
+#endif
+
+/**
+ * The scanning functions for the instruction set of the processor,
+ * selected once at startup.
+ */
+struct ScanFunctions {
+  const char* instructionSet;
+  scanFunction whitespaceEnd;
+  scanFunction commentEnd;
+  scanFunction lineEnd;
+  scanStringFunction stringEnd;
+};
+
+static ScanFunctions selectScanFunctions() {
+  ScanFunctions f;
+
+#ifdef CHARSCANNER_AVX2
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    f.instructionSet = "avx2";
+    f.whitespaceEnd = whitespaceEndAVX2;
+    f.commentEnd = commentEndAVX2;
+    f.lineEnd = lineEndAVX2;
+    f.stringEnd = stringEndAVX2;
+    return f;
+  }
+#endif
+#ifdef CHARSCANNER_SSE2
+  f.instructionSet = "sse2";
+  f.whitespaceEnd = whitespaceEndSSE2;
+  f.commentEnd = commentEndSSE2;
+  f.lineEnd = lineEndSSE2;
+  f.stringEnd = stringEndSSE2;
+#else
+  f.instructionSet = "scalar";
+  f.whitespaceEnd = whitespaceEndScalar;
+  f.commentEnd = commentEndScalar;
+  f.lineEnd = lineEndScalar;
+  f.stringEnd = stringEndScalar;
+#endif
+  return f;
+}
+
+static const ScanFunctions scanFunctions = selectScanFunctions();
+
+const char* CharScanner::findWhitespaceEnd(const char* p, const char* end) {
+  return scanFunctions.whitespaceEnd(p, end);
+}
+
+const char* CharScanner::findCommentEnd(const char* p, const char* end) {
+  return scanFunctions.commentEnd(p, end);
+}
+
+const char* CharScanner::findLineEnd(const char* p, const char* end) {
+  return scanFunctions.lineEnd(p, end);
+}
+
+const char* CharScanner::findStringEnd(const char* p, const char* end,
+                                       char delim) {
+  return scanFunctions.stringEnd(p, end, delim);
+}
+
+const char* CharScanner::getInstructionSet() {
+  return scanFunctions.instructionSet;
+}
@@ -0,0 +1,49 @@
+#ifndef __CharScanner_h__
+#define __CharScanner_h__
+
+#include <cstddef>
+
+/**
+ * Scanning functions that search a buffer for the next character
+ * that ends a run of whitespace, a comment or a string.
+ *
+ * The functions use SSE2 or AVX2 instructions when they are available
+ * and fall back to a plain loop otherwise. Each of them also stops at
+ * the escape character (27), which the CssTokenizer treats as the end
+ * of the input.
+ *
+ * All functions return <code>end</code> if nothing was found.
+ */
+class CharScanner {
+public:
+  /**
+   * Find the first character that is not a space, tab, carriage
+   * return, newline or form feed.
+   */
+  static const char* findWhitespaceEnd(const char* p, const char* end);
+
+  /**
+   * Find the '*' of the first "*\/" sequence.
+   */
+  static const char* findCommentEnd(const char* p, const char* end);
+
+  /**
+   * Find the first newline.
+   */
+  static const char* findLineEnd(const char* p, const char* end);
+
+  /**
+   * Find the first <code>delim</code> quote, backslash, carriage
+   * return, newline or form feed.
+   */
+  static const char* findStringEnd(const char* p, const char* end,
+                                   char delim);
+
+  /**
+   * Returns the name of the instruction set that is used: "avx2",
+   * "sse2" or "scalar".
+   */
+  static const char* getInstructionSet();
+};
+
+#endif
@@ -232,7 +232,7 @@ Declaration* CssParser::parseDeclaration (Ruleset &ruleset) {
   skipWhitespace();
   
   keyword = property.front();
-  keyword.assign(property.toString());
+  keyword = property.toString();
   
   declaration = ruleset.createDeclaration(keyword);
   
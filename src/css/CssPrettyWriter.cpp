@@ -10,7 +10,7 @@ void CssPrettyWriter::indent() {
 }
 
 void CssPrettyWriter::newline() {
-  out->write("\n", 1);
+  writeStr("\n", 1);
   column = 0;
   
   if (sourcemap != NULL)
@@ -1,5 +1,8 @@
 
 #include "CssTokenizer.h"
+#include "CharScanner.h"
+#include "../Statistics.h"
+#include <cstring>
 
 #include <config.h>
 
@@ -8,7 +11,25 @@
 #endif
 
 CssTokenizer::CssTokenizer(istream &in, const char* source):
-  in(&in), line(0),  source(source) {
+  in(&in), pos(NULL), end(NULL), eof(false), lastRead(0),
+  line(0), source(source), intern(true) {
+  currentToken.source = source;
+  readChar();
+  column = 0;
+}
+
+CssTokenizer::CssTokenizer(const char* buffer, size_t length,
+                           const char* source):
+  in(NULL), pos(buffer), end(buffer + length), eof(false), lastRead(0),
+  line(0), source(source), intern(true) {
+  currentToken.source = source;
+  readChar();
+  column = 0;
+}
+
+CssTokenizer::CssTokenizer(const InputBuffer &buffer, const char* source):
+  in(NULL), pos(buffer.getData()), end(buffer.getData() + buffer.getLength()),
+  eof(false), lastRead(0), line(0), source(source), intern(true) {
   currentToken.source = source;
   readChar();
   column = 0;
@@ -21,35 +42,56 @@ const char* CssTokenizer::getSource() {
   return source;
 }
 
-void CssTokenizer::readChar(){
-  if (in == NULL) 
-    return;
-  
-  // Last char was a newline. Increment the line counter.
-  if (lastReadEq('\n')) {
-    line++;
-    column = 0;
-  } else
-    column++;
-  
+void CssTokenizer::setInterning(bool intern) {
+  this->intern = intern;
+}
+
+void CssTokenizer::readStreamChar(){
   in->get(lastRead);
 
-  // check for end of file or escape key
-  if(in->eof() || lastRead == 27) 
-    in = NULL;
+  // check for end of file
+  if(in->eof()) 
+    eof = true;
   else if (in->fail() || in->bad())
     throw new IOException("Error reading input");
+}
+
+void CssTokenizer::readUntil(const char* p) {
+  const char* start = pos - 1;
+  const char* last = p - 1;
+  const char* nl, *lastNl = NULL;
 
-  if (lastReadEq('\n') && column > 0) // don't count newlines as chars
-    column--;
+  if (p <= start)
+    return;
+  currentToken.append(start, p - start);
+
+  if (last > start) {
+    // Every newline before the new lastRead starts a new line.
+    for (nl = start;
+         (nl = (const char*)memchr(nl, '\n', last - nl)) != NULL;
+         nl++) {
+      line++;
+      lastNl = nl;
+    }
+    if (lastNl != NULL)
+      column = last - lastNl - 1;
+    else
+      column += last - start;
+    if (*last == '\n' && column > 0)
+      column--;
+  }
+  lastRead = *last;
+  pos = p;
+  readChar();
 }
 
 Token::Type CssTokenizer::readNextToken(){
-  if (in == NULL) {
+  if (eof) {
     currentToken.type = Token::EOS;
     return Token::EOS;
   }
 
+  Statistics::count(Statistics::TOKENS);
   currentToken.clear();
   currentToken.line = line;
   currentToken.column = column;
@@ -188,6 +230,8 @@ Token::Type CssTokenizer::readNextToken(){
       }
     } else if (readWhitespace()) {
       currentToken.type = Token::WHITESPACE;
+      if (in == NULL && !eof)
+        readUntil(CharScanner::findWhitespaceEnd(pos - 1, end));
       while (readWhitespace()) {};
     } else {
       currentToken.append(lastRead);
@@ -195,6 +239,14 @@ Token::Type CssTokenizer::readNextToken(){
     }
     break;
   }
+
+  // identifiers and variable names are looked up and compared often;
+  // intern them once here.
+  if (intern &&
+      (currentToken.type == Token::IDENTIFIER ||
+       currentToken.type == Token::ATKEYWORD))
+    currentToken.getSymbol();
+  
 #ifdef WITH_LIBGLOG
   VLOG(4) << "Token: " << currentToken << "[" << currentToken.type
           << "]";
@@ -224,7 +276,7 @@ bool CssTokenizer::readName () {
 }
 
 bool CssTokenizer::readNMStart () {
-  if (in == NULL)
+  if (eof)
     return false;
   
   if (lastReadEq('_') ||
@@ -237,7 +289,7 @@ bool CssTokenizer::readNMStart () {
     return (readNonAscii() || readEscape());
 }
 bool CssTokenizer::readNonAscii () {
-  if (in == NULL || lastRead >= 0)
+  if (eof || lastRead >= 0)
     return false;
   
   currentToken.append(lastRead);
@@ -278,7 +330,7 @@ bool CssTokenizer::readUnicode () {
 }
 
 bool CssTokenizer::readNMChar () {
-  if (in == NULL)
+  if (eof)
     return false;
   
   if (lastReadEq('_') ||
@@ -334,7 +386,14 @@ bool CssTokenizer::readString() {
 
   currentToken.append(lastRead);
   readChar();
-  while (in != NULL) {
+  while (!eof) {
+    // skip to the next character that needs attention
+    if (in == NULL && lastRead != delim) {
+      readUntil(CharScanner::findStringEnd(pos - 1, end, delim));
+      if (eof)
+        break;
+    }
+
     if (lastReadEq(delim)) {
       currentToken.append(lastRead);
       readChar();
@@ -414,7 +473,7 @@ bool CssTokenizer::readUrl() {
     }
   }
 
-  while (in != NULL) {
+  while (!eof) {
     if (readWhitespace() || lastReadEq(')')) {
       while (readWhitespace()) {};
       if (lastReadEq(')')) {
@@ -426,7 +485,7 @@ bool CssTokenizer::readUrl() {
                                  "end of url (')')",
                                  line,column,source);
       }
-    } else if (in != NULL && urlchars.find(lastRead)) {
+    } else if (!eof && urlchars.find(lastRead)) {
       currentToken.append(lastRead);
       readChar();
     } else if (!readNonAscii() &&
@@ -448,7 +507,13 @@ bool CssTokenizer::readComment () {
     return false;
   currentToken.append(lastRead);
   readChar();
-  while (in != NULL) {
+  while (!eof) {
+    if (in == NULL) {
+      readUntil(CharScanner::findCommentEnd(pos - 1, end));
+      if (eof)
+        break;
+    }
+
     if (lastReadEq('*')) {
       currentToken.append(lastRead);
       readChar();
@@ -470,7 +535,7 @@ bool CssTokenizer::readComment () {
 }
 
 bool CssTokenizer::readUnicodeRange () {
-  if (in == NULL)
+  if (eof)
     return false;
   for (int i=0; i < 6; i++) {
     if (!lastReadIsHex())
@@ -496,21 +561,3 @@ Token& CssTokenizer::getToken(){
 Token::Type CssTokenizer::getTokenType() {
   return currentToken.type;
 }
-
-bool CssTokenizer::lastReadEq(char c) {
-  return (in != NULL && lastRead == c);
-}
-
-bool CssTokenizer::lastReadInRange(char c1, char c2) {
-  return (in != NULL && lastRead >= c1 && lastRead <= c2);
-}
-bool CssTokenizer::lastReadIsDigit() {
-  return (in != NULL &&
-          lastReadInRange('0', '9'));
-}
-bool CssTokenizer::lastReadIsHex() {
-  return (in != NULL &&
-          (lastReadIsDigit() ||
-           lastReadInRange('a', 'f') ||
-           lastReadInRange('A', 'F')));
-}
@@ -5,6 +5,7 @@
 #include <iostream>
 #include <string>
 #include "../Token.h"
+#include "InputBuffer.h"
 #include "IOException.h"
 #include "ParseException.h"
 
@@ -87,26 +88,67 @@ class CssTokenizer {
 public:
 	
   CssTokenizer(istream &in, const char* source);
+
+  /**
+   * Tokenize <code>length</code> bytes of memory starting at
+   * <code>buffer</code>. The memory is scanned directly instead of
+   * going through an istream and has to stay valid for as long as the
+   * tokenizer is used.
+   */
+  CssTokenizer(const char* buffer, size_t length, const char* source);
+  CssTokenizer(const InputBuffer &buffer, const char* source);
 		
-  ~CssTokenizer();
+  virtual ~CssTokenizer();
   
-  Token::Type readNextToken();
+  virtual Token::Type readNextToken();
   
   Token& getToken();
   Token::Type getTokenType();
 
   const char* getSource();
+
+  /**
+   * Turn off interning the symbols of identifiers and at-keywords. The
+   * SymbolTable is not thread safe, so tokenizers that run on other
+   * threads leave the symbols to be interned when the tokens are used.
+   */
+  void setInterning(bool intern);
 		
 protected:
+  /**
+   * Input stream, or NULL if the input is read from a buffer.
+   */
   istream* in;
 
+  /**
+   * Read position and end of the input buffer.
+   */
+  const char* pos;
+  const char* end;
+
+  /**
+   * Set when the end of the input has been reached.
+   */
+  bool eof;
+
   Token currentToken;
   char lastRead;
   
   unsigned int line, column;
   const char* source;
+
+  bool intern;
   
   void readChar();
+  void readStreamChar();
+
+  /**
+   * Append the characters from lastRead up to (not including)
+   * <code>p</code> to the current token and continue reading at
+   * <code>p</code>. Only used when reading from a buffer; the line and
+   * column are updated as if the characters were read one by one.
+   */
+  void readUntil(const char* p);
 
   bool readIdent();
   bool readName();
@@ -130,4 +172,48 @@ protected:
   bool lastReadIsHex();
 };
 
+inline void CssTokenizer::readChar(){
+  if (eof) 
+    return;
+  
+  // Last char was a newline. Increment the line counter.
+  if (lastRead == '\n') {
+    line++;
+    column = 0;
+  } else
+    column++;
+
+  if (in != NULL)
+    readStreamChar();
+  else if (pos != end)
+    lastRead = *pos++;
+  else
+    eof = true;
+
+  // stop at the end of the input or the escape key
+  if (eof || lastRead == 27) {
+    eof = true;
+    return;
+  }
+
+  if (lastRead == '\n' && column > 0) // don't count newlines as chars
+    column--;
+}
+
+inline bool CssTokenizer::lastReadEq(char c) {
+  return (!eof && lastRead == c);
+}
+
+inline bool CssTokenizer::lastReadInRange(char c1, char c2) {
+  return (!eof && lastRead >= c1 && lastRead <= c2);
+}
+inline bool CssTokenizer::lastReadIsDigit() {
+  return lastReadInRange('0', '9');
+}
+inline bool CssTokenizer::lastReadIsHex() {
+  return (lastReadIsDigit() ||
+          lastReadInRange('a', 'f') ||
+          lastReadInRange('A', 'F'));
+}
+
 #endif
@@ -15,84 +15,129 @@ CssWriter::CssWriter(std::ostream &out, SourceMapWriter &sourcemap):
 }
 
 CssWriter::~CssWriter() {
+  flush();
 }
 
 unsigned int CssWriter::getColumn() {
   return column;
 }
 
-void CssWriter::writeStr(const char* str, size_t len) {
-  out->write(str, len);
-  column += len;
+void CssWriter::flush() {
+  if (out != NULL && !buffer.empty()) 
+    out->write(buffer.data(), buffer.size());
+  buffer.clear();
 }
-void CssWriter::writeToken(const Token &token) {
-  std::string url;
+
+void CssWriter::writeUrl(const Token &token) {
+  std::string url = token.getUrlString();
   
-  if (rootpath != NULL && token.type == Token::URL) {
-    url = token.getUrlString();
-    if (url.find(':') == std::string::npos) {
-      writeStr("url(\"", 5);
-      writeStr(rootpath, std::strlen(rootpath));
-
-      writeStr(url.c_str(), url.size());
-      writeStr("\")", 2);
-    } else {
-      writeStr(token.c_str(),
-               token.size());
-    }
+  if (url.find(':') == std::string::npos) {
+    writeStr("url(\"", 5);
+    writeStr(rootpath, std::strlen(rootpath));
+
+    writeStr(url.c_str(), url.size());
+    writeStr("\")", 2);
   } else {
     writeStr(token.c_str(),
              token.size());
   }
 }
-void CssWriter::writeTokenList(const TokenList &tokens) {
+
+void CssWriter::writeToken(const Token &token) {
+  if (rootpath != NULL)
+    writeToken<true>(token);
+  else
+    writeToken<false>(token);
+}
+
+template <bool REWRITE_URLS>
+void CssWriter::writeTokens(const TokenList &tokens) {
   TokenList::const_iterator i = tokens.begin();
   
   for(; i != tokens.end(); i++) {
-    writeToken(*i);
+    writeToken<REWRITE_URLS>(*i);
   }
 }
 
-void CssWriter::writeSelector(const TokenList &selector) {
+void CssWriter::writeTokenList(const TokenList &tokens) {
+  if (rootpath != NULL)
+    writeTokens<true>(tokens);
+  else
+    writeTokens<false>(tokens);
+}
+
+template <bool SOURCEMAP, bool REWRITE_URLS>
+void CssWriter::writeSelectorTokens(const TokenList &selector) {
   TokenList::const_iterator it;
   bool newselector = true;
 
   for (it = selector.begin(); it != selector.end(); it++) {
 
-    if (newselector && sourcemap != NULL) {
+    if (SOURCEMAP && newselector) {
       sourcemap->writeMapping(column, *it);
       newselector = false;
     }
 
-    writeToken(*it);
+    writeToken<REWRITE_URLS>(*it);
 
-    if ((*it) == ",") 
+    if (SOURCEMAP && (*it) == ",") 
       newselector = true;
   }
 }
 
-void CssWriter::writeValue(const TokenList &value) {
+void CssWriter::writeSelector(const TokenList &selector) {
+  if (sourcemap != NULL) {
+    if (rootpath != NULL)
+      writeSelectorTokens<true, true>(selector);
+    else
+      writeSelectorTokens<true, false>(selector);
+  } else {
+    if (rootpath != NULL)
+      writeSelectorTokens<false, true>(selector);
+    else
+      writeSelectorTokens<false, false>(selector);
+  }
+}
+
+template <bool SOURCEMAP, bool REWRITE_URLS>
+void CssWriter::writeValueTokens(const TokenList &value) {
   TokenList::const_iterator it = value.begin();
   const Token* t;
 
   while(it != value.end() && (*it).type == Token::WHITESPACE) {
     it++;
   }
+  if (it == value.end())
+    return;
   
-  if (sourcemap != NULL)
+  if (SOURCEMAP)
     sourcemap->writeMapping(column, *it);
   t = &(*it);
   
   for (; it != value.end(); it++) {
     
-    if ((*it).source != t->source ||
-        (*it).line != t->line) {
-      if (sourcemap != NULL)
-        sourcemap->writeMapping(column, (*it));
+    if (SOURCEMAP &&
+        ((*it).source != t->source ||
+         (*it).line != t->line)) {
+      sourcemap->writeMapping(column, (*it));
       t = &(*it);
     }
 
-    writeToken(*it);
+    writeToken<REWRITE_URLS>(*it);
+  }
+}
+
+void CssWriter::writeValue(const TokenList &value) {
+  if (sourcemap != NULL) {
+    if (rootpath != NULL)
+      writeValueTokens<true, true>(value);
+    else
+      writeValueTokens<true, false>(value);
+  } else {
+    if (rootpath != NULL)
+      writeValueTokens<false, true>(value);
+    else
+      writeValueTokens<false, false>(value);
   }
 }
 
@@ -150,6 +195,7 @@ void CssWriter::writeMediaQueryEnd() {
 }
 
 void CssWriter::writeSourceMapUrl(const char* sourcemap_url) {
+  flush();
   *out << std::endl << "/*# sourceMappingURL=" <<
     sourcemap_url << " */" << std::endl;
 }
@@ -6,14 +6,50 @@
 #include "SourceMapWriter.h"
 #include <iostream>
 #include <cstring>
+#include <string>
 
+/**
+ * Writes the CSS output, collecting it in a buffer that is written to
+ * the output stream in large chunks. The buffer is written out by
+ * flush(), which Stylesheet::write() calls when it's done.
+ *
+ * The loops that write selectors and values are instantiated for each
+ * combination of writing a source map and rewriting urls, so the
+ * common case of neither doesn't check for them on every token.
+ */
 class CssWriter {
+private:
+  std::string buffer;
+  static const size_t BUFFER_SIZE = 65536;
+
+  void writeUrl(const Token &token);
+
+  template <bool REWRITE_URLS>
+  void writeTokens(const TokenList &tokens);
+  template <bool SOURCEMAP, bool REWRITE_URLS>
+  void writeSelectorTokens(const TokenList &selector);
+  template <bool SOURCEMAP, bool REWRITE_URLS>
+  void writeValueTokens(const TokenList &value);
+  
 protected:
   std::ostream* out;
   unsigned int column;
   SourceMapWriter* sourcemap;
 
-  void writeStr(const char* str, size_t len);
+  inline void writeStr(const char* str, size_t len) {
+    buffer.append(str, len);
+    column += len;
+    if (buffer.size() >= BUFFER_SIZE)
+      flush();
+  }
+  
+  template <bool REWRITE_URLS>
+  inline void writeToken(const Token &token) {
+    if (REWRITE_URLS && token.type == Token::URL)
+      writeUrl(token);
+    else
+      writeStr(token.c_str(), token.size());
+  }
   void writeToken(const Token &token);
   void writeTokenList(const TokenList &tokens);
   
@@ -41,6 +77,11 @@ public:
   virtual void writeMediaQueryEnd();
 
   void writeSourceMapUrl(const char* sourcemap_url);
+
+  /**
+   * Write the buffered output to the stream.
+   */
+  void flush();
 };
   
 #endif
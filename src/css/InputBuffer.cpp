@@ -0,0 +1,118 @@
+#include "InputBuffer.h"
+
+#include <config.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+#ifdef WITH_LIBGLOG
+#include <glog/logging.h>
+#endif
+
+InputBuffer::InputBuffer(const char* filename) {
+  int fd = open(filename, O_RDONLY);
+
+  data = NULL;
+  length = 0;
+  mapped = false;
+
+  if (fd < 0)
+    throw new IOException("Error opening file");
+
+  try {
+    if (!mapFile(fd))
+      readFile(fd);
+  } catch (IOException*) {
+    close(fd);
+    throw;
+  }
+  close(fd);
+
+#ifdef WITH_LIBGLOG
+  VLOG(2) << "Loaded " << filename << " (" << length << " bytes" <<
+    (mapped ? ", mapped)" : ")");
+#endif
+}
+
+InputBuffer::InputBuffer(istream &in) {
+  char chunk[8192];
+
+  mapped = false;
+
+  while (in.read(chunk, sizeof(chunk)) || in.gcount() > 0) {
+    contents.append(chunk, in.gcount());
+  }
+  if (in.bad())
+    throw new IOException("Error reading input");
+
+  data = contents.data();
+  length = contents.size();
+}
+
+InputBuffer::~InputBuffer() {
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+  if (mapped)
+    munmap((void*)data, length);
+#endif
+}
+
+bool InputBuffer::mapFile(int fd) {
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+  struct stat st;
+  void* addr;
+
+  // Only regular, non-empty files can be mapped. Anything else (pipes,
+  // devices) is read into memory.
+  if (fstat(fd, &st) != 0 ||
+      !S_ISREG(st.st_mode) ||
+      st.st_size == 0)
+    return false;
+
+  addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (addr == MAP_FAILED)
+    return false;
+
+#ifdef HAVE_MADVISE
+  madvise(addr, st.st_size, MADV_SEQUENTIAL);
+#endif
+
+  data = (const char*)addr;
+  length = st.st_size;
+  mapped = true;
+  return true;
+#else
+  (void)fd;
+  return false;
+#endif
+}
+
+void InputBuffer::readFile(int fd) {
+  char chunk[8192];
+  ssize_t n;
+
+  while ((n = read(fd, chunk, sizeof(chunk))) != 0) {
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      throw new IOException("Error reading input");
+    }
+    contents.append(chunk, n);
+  }
+  data = contents.data();
+  length = contents.size();
+}
+
+const char* InputBuffer::getData() const {
+  return data;
+}
+
+size_t InputBuffer::getLength() const {
+  return length;
+}
@@ -0,0 +1,59 @@
+#ifndef __InputBuffer_h__
+#define __InputBuffer_h__
+
+#include <iostream>
+#include <string>
+#include <cstddef>
+#include "IOException.h"
+
+using namespace std;
+
+/**
+ * Holds the complete contents of a source file in one contiguous
+ * block of memory so the CssTokenizer can scan it with a pointer
+ * instead of reading it one character at a time from a stream.
+ *
+ * Files are mapped into memory where mmap() is available, otherwise
+ * (and for streams like stdin) the input is read into a heap buffer.
+ */
+class InputBuffer {
+private:
+  const char* data;
+  size_t length;
+
+  /**
+   * Set if data points to a mapped region that has to be unmapped,
+   * otherwise data points into <code>contents</code>.
+   */
+  bool mapped;
+  std::string contents;
+
+  bool mapFile(int fd);
+  void readFile(int fd);
+
+  // not copyable
+  InputBuffer(const InputBuffer &b);
+  InputBuffer& operator=(const InputBuffer &b);
+
+public:
+  /**
+   * Map or read the file with the given name.
+   *
+   * @throws IOException if the file can not be opened or read.
+   */
+  InputBuffer(const char* filename);
+
+  /**
+   * Read the stream until the end of input.
+   *
+   * @throws IOException if the stream reports an error.
+   */
+  InputBuffer(istream &in);
+
+  virtual ~InputBuffer();
+
+  const char* getData() const;
+  size_t getLength() const;
+};
+
+#endif
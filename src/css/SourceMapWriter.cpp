@@ -13,6 +13,8 @@ SourceMapWriter::SourceMapWriter(std::ostream &sourcemap,
   lastSrcFile = 0;
   lastSrcLine = 0;
   lastSrcColumn = 0;
+  lineMapped = false;
+  indexedSources = 0;
   writePreamble(out_filename, rootpath, basepath);
 }
 
@@ -70,31 +72,58 @@ void SourceMapWriter::writePreamble(const char* out_filename,
 }
 
 void SourceMapWriter::close() {
+  flush();
   sourcemap_h << "\"}" << std::endl;
 }
 
+void SourceMapWriter::flush() {
+  sourcemap_h.write(buffer.data(), buffer.size());
+  buffer.clear();
+}
 
 void SourceMapWriter::writeMapping(unsigned int column, const Token& source) {
-  char buffer[10];
-  size_t len = encodeMapping(column, source, buffer);
-
-  sourcemap_h.write(buffer, len);
-  sourcemap_h.write(",", 1);
+  char mapping[32];
+  size_t len;
+
+  if (lineMapped &&
+      sourceFileIndex(source.source) == lastSrcFile &&
+      source.line == lastSrcLine &&
+      source.column == lastSrcColumn)
+    return;
+
+  len = encodeMapping(column, source, mapping);
+  buffer.append(mapping, len);
+  buffer.push_back(',');
+  lineMapped = true;
+
+  if (buffer.size() >= BUFFER_SIZE)
+    flush();
 }
 
 void SourceMapWriter::writeNewline() {
-  sourcemap_h.write(";", 1);
+  buffer.push_back(';');
   lastDstColumn = 0;
+  lineMapped = false;
 }
 
 size_t SourceMapWriter::sourceFileIndex(const char* file) {
+  std::unordered_map<const char*, size_t>::iterator it;
   std::list<const char*>::iterator i;
   size_t pos = 0;
-  
-  for (i = sources.begin(); i != sources.end(); i++, pos++) {
-    if (*i == file)
-      return pos;
+
+  // sources can be added after the writer is created
+  if (indexedSources != sources.size()) {
+    sourceIndex.clear();
+    for (i = sources.begin(); i != sources.end(); i++, pos++) {
+      // the first occurrence wins
+      sourceIndex.insert(std::pair<const char*, size_t>(*i, pos));
+    }
+    indexedSources = sources.size();
   }
+
+  it = sourceIndex.find(file);
+  if (it != sourceIndex.end())
+    return it->second;
   return 0;
 }
 
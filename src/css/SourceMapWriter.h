@@ -5,10 +5,20 @@
 #include "../Token.h"
 
 #include <list>
+#include <string>
+#include <unordered_map>
 #include <iostream>
 #include <stdlib.h>
 #include <string.h>
 
+/**
+ * Writes a version 3 source map.
+ *
+ * The mappings are encoded into a buffer that is written to the stream
+ * in large chunks. A mapping that points to the same source position
+ * as the previous mapping on the same line is left out, since the
+ * previous mapping already covers it.
+ */
 class SourceMapWriter {
 private:
   std::ostream &sourcemap_h;
@@ -16,8 +26,20 @@ private:
 
   unsigned int lastDstColumn;
   unsigned int lastSrcFile, lastSrcLine, lastSrcColumn;
+  bool lineMapped;
+
+  std::string buffer;
+  static const size_t BUFFER_SIZE = 65536;
+
+  /**
+   * The index of each source file name in sources. Sources are
+   * compared by pointer, like the tokens store them.
+   */
+  std::unordered_map<const char*, size_t> sourceIndex;
+  size_t indexedSources;
 
   size_t sourceFileIndex(const char* file) ;
+  void flush();
   size_t encodeMapping(unsigned int column,
                        const Token &source, char* buffer);
   size_t encodeField(int field, char* buffer);
@@ -0,0 +1,314 @@
+#include "CompilationCache.h"
+#include "../Sha256.h"
+
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <unordered_set>
+#include <atomic>
+#include <utility>
+#include <cstdio>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <utime.h>
+
+#include <config.h>
+
+#ifdef WITH_LIBGLOG
+#include <glog/logging.h>
+#endif
+
+CompilationCache::CompilationCache(const std::string &directory,
+                                   unsigned long long maxSize) {
+  this->directory = directory;
+  this->maxSize = maxSize;
+
+  // if it can't be created every lookup misses
+  mkdir(directory.c_str(), 0777);
+}
+
+std::string CompilationCache::getPath(const std::string &key,
+                                      const char* extension) const {
+  return directory + "/" + key + extension;
+}
+
+std::string CompilationCache::hashFiles(const FileHashes &files,
+                                        const std::string &key) {
+  Sha256 sha;
+  FileHashes::const_iterator it;
+
+  sha.update(key);
+  for (it = files.begin(); it != files.end(); it++) {
+    // the name includes the terminating '\0'
+    sha.update(it->first.c_str(), it->first.size() + 1);
+    sha.update(it->second);
+  }
+  return sha.getDigest();
+}
+
+std::string CompilationCache::hashFile(const std::string &path) {
+  std::string contents;
+
+  if (!readFile(path, contents))
+    contents.clear();
+  return Sha256::hash(contents.data(), contents.size());
+}
+
+bool CompilationCache::readFile(const std::string &path,
+                                std::string &contents) {
+  std::ifstream in(path.c_str(), std::ios::in | std::ios::binary);
+  std::ostringstream buffer;
+
+  if (!in.good())
+    return false;
+  buffer << in.rdbuf();
+  contents = buffer.str();
+  return !in.bad();
+}
+
+bool CompilationCache::fileExists(const std::string &path) {
+  std::ifstream in(path.c_str());
+  return in.good();
+}
+
+bool CompilationCache::writeFile(const std::string &path,
+                                 const std::string &contents) {
+  static std::atomic<unsigned int> counter(0);
+  std::ostringstream temp;
+  
+  temp << path << ".tmp" << getpid() << "." << counter++;
+  {
+    std::ofstream out(temp.str().c_str(),
+                      std::ios::out | std::ios::binary);
+    out << contents;
+    out.close();
+    if (!out.good()) {
+      unlink(temp.str().c_str());
+      return false;
+    }
+  }
+  if (rename(temp.str().c_str(), path.c_str()) != 0) {
+    unlink(temp.str().c_str());
+    return false;
+  }
+  return true;
+}
+
+void CompilationCache::touch(const std::string &path) {
+  utime(path.c_str(), NULL);
+}
+
+void CompilationCache::count(bool hit) {
+  std::string path = directory + "/stats";
+  unsigned long long hits = 0, misses = 0;
+  char buffer[64];
+  ssize_t n;
+  int fd;
+
+  fd = open(path.c_str(), O_RDWR | O_CREAT, 0666);
+  if (fd < 0)
+    return;
+  // other processes update the counts too
+  flock(fd, LOCK_EX);
+
+  n = pread(fd, buffer, sizeof(buffer) - 1, 0);
+  if (n > 0) {
+    buffer[n] = '\0';
+    std::sscanf(buffer, "%llu %llu", &hits, &misses);
+  }
+  if (hit)
+    hits++;
+  else
+    misses++;
+
+  n = std::snprintf(buffer, sizeof(buffer), "%llu %llu\n", hits, misses);
+  if (ftruncate(fd, 0) == 0 && pwrite(fd, buffer, n, 0) != n) {
+#ifdef WITH_LIBGLOG
+    LOG(ERROR) << "Error writing " << path;
+#endif
+  }
+
+  flock(fd, LOCK_UN);
+  close(fd);
+}
+
+void CompilationCache::evict() {
+  DIR* dir;
+  struct dirent* entry;
+  struct stat st;
+  std::string name, path;
+  std::vector<std::pair<time_t, std::pair<std::string, off_t> > > files;
+  std::vector<std::pair<time_t, std::pair<std::string, off_t> > >
+    ::iterator it;
+  unsigned long long size = 0;
+
+  if (maxSize == 0 || (dir = opendir(directory.c_str())) == NULL)
+    return;
+
+  while ((entry = readdir(dir)) != NULL) {
+    name = entry->d_name;
+    if (name[0] == '.' || name == "stats" ||
+        name.find(".tmp") != std::string::npos)
+      continue;
+    
+    path = directory + "/" + name;
+    if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+      continue;
+    files.push_back(std::make_pair(st.st_mtime,
+                                   std::make_pair(path, st.st_size)));
+    size += st.st_size;
+  }
+  closedir(dir);
+
+  if (size <= maxSize)
+    return;
+  
+  std::sort(files.begin(), files.end());
+  
+  for (it = files.begin(); it != files.end() && size > maxSize; it++) {
+#ifdef WITH_LIBGLOG
+    VLOG(2) << "Evicting " << it->second.first;
+#endif
+    if (unlink(it->second.first.c_str()) == 0)
+      size -= it->second.second;
+  }
+}
+
+bool CompilationCache::get(const std::string &key, bool sourcemap,
+                           std::string &css, std::string &map,
+                           std::vector<std::string> &files) {
+  std::string deps_path = getPath(key, ".deps"), deps, line;
+  FileHashes dependencies;
+  FileHashes::iterator it;
+  std::string result;
+  bool missing = false;
+
+  if (!readFile(deps_path, deps)) {
+    count(false);
+    return false;
+  }
+
+  // the missing paths follow an empty line
+  std::istringstream lines(deps);
+  while (std::getline(lines, line)) {
+    if (line.empty())
+      missing = true;
+    else if (!missing)
+      dependencies.push_back(std::make_pair(line, hashFile(line)));
+    else if (fileExists(line)) {
+#ifdef WITH_LIBGLOG
+      VLOG(1) << "Cache miss, file created: " << line;
+#endif
+      count(false);
+      return false;
+    } else
+      dependencies.push_back(std::make_pair(line, std::string()));
+  }
+  
+  result = hashFiles(dependencies, key);
+  
+  if (!readFile(getPath(result, ".css"), css) ||
+      (sourcemap && !readFile(getPath(result, ".map"), map))) {
+    count(false);
+    return false;
+  }
+
+#ifdef WITH_LIBGLOG
+  VLOG(1) << "Cache hit: " << getPath(result, ".css");
+#endif
+
+  touch(deps_path);
+  touch(getPath(result, ".css"));
+  if (sourcemap)
+    touch(getPath(result, ".map"));
+  count(true);
+  
+  for (it = dependencies.begin(); it != dependencies.end(); it++) {
+    if (!it->second.empty())
+      files.push_back(it->first);
+  }
+  return true;
+}
+
+void CompilationCache::put(const std::string &key,
+                           const FileHashes &files,
+                           const std::string &css, const std::string* map) {
+  FileHashes dependencies, missing;
+  FileHashes::const_iterator it;
+  std::unordered_set<std::string> seen;
+  std::string deps, id, result;
+
+  // a file can be imported more than once. It is listed again only if
+  // it changed in between, so the output never matches.
+  for (it = files.begin(); it != files.end(); it++) {
+    id = it->first;
+    id.push_back('\0');
+    id.append(it->second);
+    
+    if (!seen.insert(id).second)
+      continue;
+    if (it->second.empty())
+      missing.push_back(*it);
+    else {
+      dependencies.push_back(*it);
+      deps.append(it->first);
+      deps.push_back('\n');
+    }
+  }
+  if (!missing.empty()) {
+    deps.push_back('\n');
+    for (it = missing.begin(); it != missing.end(); it++) {
+      dependencies.push_back(*it);
+      deps.append(it->first);
+      deps.push_back('\n');
+    }
+  }
+  
+  result = hashFiles(dependencies, key);
+
+  // the output is written first so the list of files never points to
+  // output that is missing.
+  if (!writeFile(getPath(result, ".css"), css) ||
+      (map != NULL && !writeFile(getPath(result, ".map"), *map)) ||
+      !writeFile(getPath(key, ".deps"), deps))
+    return;
+
+  evict();
+}
+
+void CompilationCache::getStats(unsigned long long &hits,
+                                unsigned long long &misses,
+                                size_t &entries,
+                                unsigned long long &size) const {
+  std::string counts, name, path;
+  DIR* dir;
+  struct dirent* entry;
+  struct stat st;
+
+  hits = misses = 0;
+  entries = 0;
+  size = 0;
+
+  if (readFile(directory + "/stats", counts))
+    std::sscanf(counts.c_str(), "%llu %llu", &hits, &misses);
+
+  if ((dir = opendir(directory.c_str())) == NULL)
+    return;
+  
+  while ((entry = readdir(dir)) != NULL) {
+    name = entry->d_name;
+    path = directory + "/" + name;
+    if (name[0] == '.' || stat(path.c_str(), &st) != 0 ||
+        !S_ISREG(st.st_mode))
+      continue;
+    
+    if (name.size() > 4 && name.compare(name.size() - 4, 4, ".css") == 0)
+      entries++;
+    size += st.st_size;
+  }
+  closedir(dir);
+}
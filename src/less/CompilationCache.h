@@ -0,0 +1,115 @@
+#ifndef __CompilationCache_h__
+#define __CompilationCache_h__
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+/**
+ * On-disk cache of compiled stylesheets, shared by the processes that
+ * use the same directory.
+ *
+ * A compilation is looked up by a key for its input file and options,
+ * the SHA-256 digest of their description. Under that key the cache
+ * keeps the list of files the last compilation read: the input, its
+ * imports and the images it looked at, followed by the paths it looked
+ * for and found missing, like the places an import was searched for
+ * before it was found. The output is stored under the
+ * SHA-256 digest of the key and the contents the compilation read
+ * from those files, so it is found again as long as none of the files
+ * changed and none of the missing paths exists, without tokenizing
+ * anything.
+ *
+ * When the files take up more than the maximum size, the least
+ * recently used files are removed. The number of hits and misses is
+ * kept in the directory as well.
+ */
+class CompilationCache {
+public:
+  /**
+   * The files a compilation read, each with the SHA-256 digest of the
+   * contents that were read. Paths that did not exist have an empty
+   * digest.
+   */
+  typedef std::vector<std::pair<std::string, std::string> > FileHashes;
+  
+private:
+  std::string directory;
+  unsigned long long maxSize;
+
+  std::string getPath(const std::string &key, const char* extension) const;
+  /**
+   * The digest of <code>key</code> and the names and content digests
+   * of <code>files</code>.
+   */
+  static std::string hashFiles(const FileHashes &files,
+                               const std::string &key);
+  /**
+   * The digest of the current contents of a file. A missing file
+   * hashes like an empty one.
+   */
+  static std::string hashFile(const std::string &path);
+
+  static bool readFile(const std::string &path, std::string &contents);
+  /**
+   * Check whether a file exists the way LessParser::findFile() does.
+   */
+  static bool fileExists(const std::string &path);
+  /**
+   * Write a file under a temporary name and rename it, so other
+   * processes never see a partial file.
+   */
+  static bool writeFile(const std::string &path,
+                        const std::string &contents);
+  /**
+   * Update the modification time of a file to mark it as used.
+   */
+  static void touch(const std::string &path);
+
+  /**
+   * Add one to the hits or the misses.
+   */
+  void count(bool hit);
+  
+  /**
+   * Remove the least recently used files until the cache is below
+   * its maximum size.
+   */
+  void evict();
+  
+public:
+  CompilationCache(const std::string &directory,
+                   unsigned long long maxSize);
+
+  /**
+   * Look up the output of the compilation with <code>key</code>. On a
+   * hit <code>css</code> and, if <code>sourcemap</code> is set,
+   * <code>map</code> are set to the output, and the files it was
+   * compiled from are added to <code>files</code>.
+   *
+   * @return true on a hit.
+   */
+  bool get(const std::string &key, bool sourcemap,
+           std::string &css, std::string &map,
+           std::vector<std::string> &files);
+
+  /**
+   * Store the output of a compilation that read <code>files</code>.
+   * The files are not read again; the output is stored under the
+   * digests of the contents the compilation read, so a file that
+   * changed during the compilation doesn't match it later.
+   * <code>map</code> is NULL if there is no source map.
+   */
+  void put(const std::string &key, const FileHashes &files,
+           const std::string &css, const std::string* map);
+
+  /**
+   * Get the number of hits and misses so far, and the number of
+   * stored stylesheets and the size of all files in the cache.
+   */
+  void getStats(unsigned long long &hits, unsigned long long &misses,
+                size_t &entries, unsigned long long &size) const;
+};
+
+#endif
@@ -0,0 +1,124 @@
+#include "ImportCache.h"
+#include "LessTokenizer.h"
+#include "../css/InputBuffer.h"
+#include "../css/IOException.h"
+#include "../WorkingDirectory.h"
+#include "../Statistics.h"
+#include "../Sha256.h"
+
+#include <sys/stat.h>
+#include <cstring>
+
+#include <config.h>
+
+#ifdef WITH_LIBGLOG
+#include <glog/logging.h>
+#endif
+
+ImportCache::ImportCache() {
+  hits = 0;
+  misses = 0;
+}
+
+ImportCache& ImportCache::getInstance() {
+  static ImportCache cache;
+  return cache;
+}
+
+BufferedTokenizer* ImportCache::get(const std::string &filename) {
+  struct stat st;
+  long nsec;
+  Entry* entry;
+  std::string h;
+  BufferedTokenizer* tokens;
+  std::string key;
+  Statistics::Timer timer(Statistics::TOKENIZE);
+  std::unordered_map<std::string, Entry*>::iterator it;
+  
+  if (stat(filename.c_str(), &st) != 0)
+    throw new IOException("Error opening file");
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+  nsec = st.st_mtim.tv_nsec;
+#else
+  nsec = 0;
+#endif
+  key = WorkingDirectory::getKey(filename);
+  
+  {
+    std::unique_lock<std::mutex> l(lock);
+    
+    it = entries.find(key);
+    if (it == entries.end()) {
+      entry = new Entry();
+      entry->source = new char[filename.length() + 1];
+      std::strcpy(entry->source, filename.c_str());
+      entry->mtime = 0;
+      entry->mtime_nsec = 0;
+      entry->size = 0;
+      entries[key] = entry;
+    } else 
+      entry = it->second;
+    
+    if (entry->tokens &&
+        entry->mtime == st.st_mtime &&
+        entry->mtime_nsec == nsec &&
+        entry->size == st.st_size) {
+      hits++;
+      tokens = new BufferedTokenizer(entry->tokens, entry->source);
+      tokens->setHash(entry->hash);
+      return tokens;
+    }
+  }
+
+  // The file may change after stat() is called, but then the next
+  // call sees a newer time than the one stored.
+  InputBuffer in(filename.c_str());
+  h = Sha256::hash(in.getData(), in.getLength());
+
+  {
+    std::unique_lock<std::mutex> l(lock);
+    
+    if (entry->tokens && entry->hash == h) {
+#ifdef WITH_LIBGLOG
+      VLOG(2) << "Unchanged: " << filename;
+#endif
+      entry->mtime = st.st_mtime;
+      entry->mtime_nsec = nsec;
+      entry->size = st.st_size;
+      hits++;
+      tokens = new BufferedTokenizer(entry->tokens, entry->source);
+      tokens->setHash(h);
+      return tokens;
+    }
+    misses++;
+  }
+
+  tokens = new BufferedTokenizer(entry->source);
+  tokens->setHash(h);
+  {
+    LessTokenizer tokenizer(in, entry->source);
+    tokenizer.setInterning(false);
+    tokens->read(tokenizer);
+  }
+
+  if (!tokens->hasError()) {
+    std::unique_lock<std::mutex> l(lock);
+    
+    entry->tokens = tokens->getTokens();
+    entry->mtime = st.st_mtime;
+    entry->mtime_nsec = nsec;
+    entry->size = st.st_size;
+    entry->hash = h;
+  }
+  return tokens;
+}
+
+size_t ImportCache::getHits() {
+  std::unique_lock<std::mutex> l(lock);
+  return hits;
+}
+
+size_t ImportCache::getMisses() {
+  std::unique_lock<std::mutex> l(lock);
+  return misses;
+}
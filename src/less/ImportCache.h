@@ -0,0 +1,74 @@
+#ifndef __ImportCache_h__
+#define __ImportCache_h__
+
+#include "../css/BufferedTokenizer.h"
+
+#include <string>
+#include <unordered_map>
+#include <mutex>
+#include <ctime>
+#include <sys/types.h>
+#include <cstddef>
+
+/**
+ * Process wide cache of the tokens of imported files, so stylesheets
+ * that are compiled in the same process and import the same files
+ * only read and tokenize them once.
+ *
+ * An entry is used as long as the modification time and size of the
+ * file stay the same. When they change the file is read again, and it
+ * is only tokenized again if its contents hash to a different value.
+ *
+ * The tokens are parsed again for every import, so a file imported with
+ * the (reference) directive and without it shares its entry; the
+ * parser marks the statements as references. Files that fail to
+ * tokenize are not cached.
+ *
+ * Relative file names are cached per working directory.
+ *
+ * The cache is thread safe.
+ */
+class ImportCache {
+private:
+  struct Entry {
+    /**
+     * The file name the tokens refer to as their source. It is kept
+     * for as long as the process runs since the stylesheets that were
+     * parsed from the tokens refer to it.
+     */
+    char* source;
+    BufferedTokenizer::TokenVector tokens;
+    time_t mtime;
+    long mtime_nsec;
+    off_t size;
+    std::string hash;
+  };
+
+  std::unordered_map<std::string, Entry*> entries;
+  std::mutex lock;
+  size_t hits, misses;
+  
+  ImportCache();
+
+public:
+  static ImportCache& getInstance();
+
+  /**
+   * Get a tokenizer that returns the tokens of the file, reading the
+   * file if it is not cached or has changed. The SHA-256 digest of
+   * the contents the tokens were read from is set on the tokenizer. The caller has
+   * to delete the tokenizer.
+   *
+   * @throws IOException if the file can not be opened or read.
+   */
+  BufferedTokenizer* get(const std::string &filename);
+
+  /**
+   * The number of times get() found the tokens in the cache and the
+   * number of times it had to tokenize the file.
+   */
+  size_t getHits();
+  size_t getMisses();
+};
+
+#endif
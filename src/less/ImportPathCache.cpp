@@ -0,0 +1,145 @@
+#include "ImportPathCache.h"
+#include "../WorkingDirectory.h"
+
+#include <sys/stat.h>
+
+#include <config.h>
+
+#ifdef WITH_LIBGLOG
+#include <glog/logging.h>
+#endif
+
+bool ImportPathCache::Directory::operator==(const Directory &d) const {
+  return exists == d.exists &&
+    mtime == d.mtime &&
+    mtime_nsec == d.mtime_nsec &&
+    path == d.path;
+}
+
+ImportPathCache::ImportPathCache() {
+  generation = 0;
+}
+
+ImportPathCache& ImportPathCache::getInstance() {
+  static ImportPathCache cache;
+  return cache;
+}
+
+std::string ImportPathCache::getKey(const std::string &key) {
+  std::string k = WorkingDirectory::get();
+
+  k.push_back('\0');
+  k.append(key);
+  return k;
+}
+
+std::string ImportPathCache::getParent(const std::string &path) {
+  size_t pos = path.find_last_of("/\\");
+
+  if (pos == std::string::npos)
+    return ".";
+  else if (pos == 0)
+    return "/";
+  else
+    return path.substr(0, pos);
+}
+
+ImportPathCache::Directory ImportPathCache::getDirectory(const std::string
+                                                         &path) {
+  Directory directory;
+  struct stat st;
+
+  directory.path = path;
+  directory.exists = stat(path.c_str(), &st) == 0;
+  if (directory.exists) {
+    directory.mtime = st.st_mtime;
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+    directory.mtime_nsec = st.st_mtim.tv_nsec;
+#else
+    directory.mtime_nsec = 0;
+#endif
+  } else {
+    directory.mtime = 0;
+    directory.mtime_nsec = 0;
+  }
+  return directory;
+}
+
+bool ImportPathCache::isChanged(const Entry &entry) {
+  std::vector<Directory>::const_iterator it;
+
+  for (it = entry.directories.begin(); it != entry.directories.end();
+       it++) {
+    if (!(getDirectory(it->path) == *it))
+      return true;
+  }
+  return false;
+}
+
+bool ImportPathCache::get(const std::string &key, std::string &filename,
+                          bool &found, std::vector<std::string>* missing) {
+  std::unordered_map<std::string, Entry>::iterator it;
+  std::string k = getKey(key);
+  std::unique_lock<std::mutex> l(lock);
+
+  it = paths.find(k);
+  if (it == paths.end())
+    return false;
+
+  if (it->second.checked != generation) {
+    if (isChanged(it->second)) {
+#ifdef WITH_LIBGLOG
+      VLOG(2) << "Directory changed: " << it->second.filename;
+#endif
+      paths.erase(it);
+      return false;
+    }
+    it->second.checked = generation;
+  }
+  
+  found = !it->second.filename.empty();
+  if (found)
+    filename = it->second.filename;
+  if (missing != NULL) {
+    missing->insert(missing->end(), it->second.missing.begin(),
+                    it->second.missing.end());
+  }
+  return true;
+}
+
+void ImportPathCache::put(const std::string &key,
+                          const std::string &filename, bool found,
+                          const std::vector<std::string> &probed) {
+  std::string k = getKey(key);
+  Entry entry;
+  std::string parent;
+  std::vector<std::string>::const_iterator it;
+  std::vector<Directory>::iterator d;
+
+  entry.filename = found ? filename : std::string();
+  for (it = probed.begin(); it != probed.end(); it++) {
+    if (!found || *it != filename)
+      entry.missing.push_back(*it);
+    parent = getParent(*it);
+    
+    for (d = entry.directories.begin(); d != entry.directories.end() &&
+           d->path != parent; d++) {
+    }
+    if (d == entry.directories.end())
+      entry.directories.push_back(getDirectory(parent));
+  }
+  
+  std::unique_lock<std::mutex> l(lock);
+  entry.checked = generation;
+  paths[k] = entry;
+}
+
+void ImportPathCache::check() {
+  std::unique_lock<std::mutex> l(lock);
+  generation++;
+}
+
+void ImportPathCache::clear() {
+  std::unique_lock<std::mutex> l(lock);
+  paths.clear();
+}
@@ -0,0 +1,124 @@
+#ifndef __ImportPathCache_h__
+#define __ImportPathCache_h__
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <ctime>
+
+/**
+ * Process wide cache of the paths LessParser::findFile() found for an
+ * import, so every include path is only probed once for each import
+ * from the same directory. Imports that were not found are cached as
+ * well.
+ *
+ * The key is made up of the directory of the importing file, the
+ * imported uri and the include paths, which together decide what
+ * findFile() finds, along with the working directory the relative
+ * paths start from.
+ *
+ * Along with the path the cache keeps the modification times of the
+ * directories that were probed for it. Creating or deleting a file
+ * changes the time of its directory, so after check() is called an
+ * entry is used again only if those directories are unchanged.
+ *
+ * The cache is thread safe.
+ */
+class ImportPathCache {
+private:
+  struct Directory {
+    std::string path;
+    bool exists;
+    time_t mtime;
+    long mtime_nsec;
+
+    bool operator==(const Directory &d) const;
+  };
+  
+  struct Entry {
+    /**
+     * The path that was found, or an empty string if the file was not
+     * found.
+     */
+    std::string filename;
+    /**
+     * The paths that were probed and did not exist.
+     */
+    std::vector<std::string> missing;
+    /**
+     * The directories of the paths that were probed.
+     */
+    std::vector<Directory> directories;
+    /**
+     * The value of <code>generation</code> when the directories were
+     * last checked.
+     */
+    unsigned int checked;
+  };
+  
+  std::unordered_map<std::string, Entry> paths;
+  std::mutex lock;
+  unsigned int generation;
+
+  ImportPathCache();
+
+  /**
+   * Add the working directory to <code>key</code>.
+   */
+  static std::string getKey(const std::string &key);
+
+  /**
+   * The directory a path is in.
+   */
+  static std::string getParent(const std::string &path);
+  
+  /**
+   * Read the modification time of a directory.
+   */
+  static Directory getDirectory(const std::string &path);
+
+  /**
+   * Check whether a directory of <code>entry</code> changed since the
+   * entry was stored.
+   */
+  static bool isChanged(const Entry &entry);
+
+public:
+  static ImportPathCache& getInstance();
+
+  /**
+   * Look up <code>key</code>.
+   *
+   * @return false if the key is not cached, otherwise true, with
+   *         <code>found</code> set to whether the file exists and
+   *         <code>filename</code> set to its path if it does. If
+   *         <code>missing</code> is not NULL the paths that were
+   *         probed and did not exist are added to it.
+   */
+  bool get(const std::string &key, std::string &filename, bool &found,
+           std::vector<std::string>* missing = NULL);
+
+  /**
+   * Store the result of looking up <code>key</code>. The paths that
+   * were probed are in <code>probed</code>, in order, up to and
+   * including <code>filename</code> if the file was found.
+   */
+  void put(const std::string &key, const std::string &filename,
+           bool found, const std::vector<std::string> &probed);
+
+  /**
+   * Make the next lookup of each entry check that the directories it
+   * was found in haven't changed. Called before every compilation, so
+   * files that were created or deleted since the last one are noticed
+   * without probing every path during a compilation.
+   */
+  void check();
+  
+  /**
+   * Forget every path.
+   */
+  void clear();
+};
+
+#endif
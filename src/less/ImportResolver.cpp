@@ -0,0 +1,238 @@
+#include "ImportResolver.h"
+#include "LessParser.h"
+#include "LessTokenizer.h"
+#include "ImportCache.h"
+
+#include <config.h>
+
+#ifdef WITH_LIBGLOG
+#include <glog/logging.h>
+#endif
+
+ImportResolver::ImportResolver(std::list<const char*>* includePaths,
+                               unsigned int threads) {
+  this->includePaths = includePaths;
+  this->threads = threads;
+  stopping = false;
+}
+
+ImportResolver::~ImportResolver() {
+  std::unordered_map<std::string, Import*>::iterator it;
+  std::vector<Import*>::iterator s_it;
+  std::vector<std::thread>::iterator w_it;
+
+  {
+    std::unique_lock<std::mutex> l(lock);
+    stopping = true;
+  }
+  queued.notify_all();
+
+  for (w_it = workers.begin(); w_it != workers.end(); w_it++)
+    w_it->join();
+
+  for (it = imports.begin(); it != imports.end(); it++) {
+    if (it->second->tokens != NULL)
+      delete it->second->tokens;
+    if (it->second->error != NULL)
+      delete it->second->error;
+    delete it->second;
+  }
+  for (s_it = scans.begin(); s_it != scans.end(); s_it++)
+    delete *s_it;
+}
+
+void ImportResolver::work() {
+  Import* import;
+  
+  std::unique_lock<std::mutex> l(lock);
+
+  while (true) {
+    while (!stopping && queue.empty())
+      queued.wait(l);
+    if (stopping)
+      return;
+
+    import = queue.front();
+    queue.pop_front();
+
+    // take() may have started on it
+    if (import->state != Import::QUEUED)
+      continue;
+    import->state = Import::RUNNING;
+
+    l.unlock();
+    read(*import);
+    l.lock();
+
+    import->state = Import::DONE;
+    done.notify_all();
+  }
+}
+
+void ImportResolver::addWorkers() {
+  while (!stopping && workers.size() < threads &&
+         workers.size() < queue.size()) {
+    workers.push_back(std::thread(&ImportResolver::work, this));
+  }
+}
+
+void ImportResolver::read(Import &import) {
+  BufferedTokenizer* tokens;
+
+#ifdef WITH_LIBGLOG
+  VLOG(2) << "Reading in advance: " << import.source;
+#endif
+
+  if (import.buffer == NULL) {
+    try {
+      import.tokens = ImportCache::getInstance().get(import.filename);
+    } catch (IOException* e) {
+      import.error = e;
+      return;
+    }
+    addImports(*import.tokens->getTokens());
+    
+  } else {
+    tokens = new BufferedTokenizer(import.source);
+    {
+      LessTokenizer tokenizer(*import.buffer, import.source);
+      tokenizer.setInterning(false);
+      tokens->read(tokenizer);
+    }
+    addImports(*tokens->getTokens());
+    delete tokens;
+  }
+}
+
+void ImportResolver::addImports(const std::vector<Token> &tokens) {
+  std::vector<Token>::const_iterator it;
+  std::vector<std::string> filenames;
+  std::vector<std::string>::iterator f_it;
+  std::vector<Import*> added;
+  Token uri;
+  unsigned int directive;
+  std::string filename;
+  Import* import;
+  
+  for (it = tokens.begin(); it != tokens.end(); it++) {
+    if ((*it).type != Token::ATKEYWORD || *it != "@import")
+      continue;
+
+    // @import [ '(' directive [',' directive]* ')' ]? [string | url]
+    directive = 0;
+    for (it++; it != tokens.end() &&
+           ((*it).type == Token::WHITESPACE ||
+            (*it).type == Token::COMMENT); it++) {
+    }
+    if (it != tokens.end() && (*it).type == Token::PAREN_OPEN) {
+      try {
+        for (it++; it != tokens.end() &&
+               (*it).type != Token::PAREN_CLOSED; it++) {
+          if ((*it).type == Token::IDENTIFIER) {
+            uri = *it;
+            directive |= LessParser::parseImportDirective(uri);
+          }
+        }
+      } catch (ParseException* e) {
+        delete e;
+        continue;
+      }
+      if (it == tokens.end())
+        break;
+      for (it++; it != tokens.end() &&
+             ((*it).type == Token::WHITESPACE ||
+              (*it).type == Token::COMMENT); it++) {
+      }
+    }
+    if (it == tokens.end())
+      break;
+    if ((*it).type != Token::STRING && (*it).type != Token::URL)
+      continue;
+
+    uri = *it;
+    filename.clear();
+    if (LessParser::getImportPath(uri, directive) &&
+        LessParser::findFile(uri, includePaths, filename))
+      filenames.push_back(filename);
+  }
+
+  if (filenames.empty())
+    return;
+  
+  std::unique_lock<std::mutex> l(lock);
+
+  for (f_it = filenames.begin(); f_it != filenames.end(); f_it++) {
+    if (imports.find(*f_it) != imports.end())
+      continue;
+
+    import = new Import();
+    import->state = Import::QUEUED;
+    import->filename = *f_it;
+    import->source = import->filename.c_str();
+    import->buffer = NULL;
+    import->tokens = NULL;
+    import->error = NULL;
+    imports[*f_it] = import;
+    added.push_back(import);
+  }
+  queue.insert(queue.begin(), added.begin(), added.end());
+  addWorkers();
+  queued.notify_all();
+}
+
+void ImportResolver::scan(const InputBuffer &in, const char* source) {
+  const char* keyword = "@import";
+  const char* end = in.getData() + in.getLength();
+  Import* import;
+
+  if (std::search(in.getData(), end, keyword, keyword + 7) == end)
+    return;
+  
+  import = new Import();
+  import->state = Import::QUEUED;
+  import->source = source;
+  import->buffer = &in;
+  import->tokens = NULL;
+  import->error = NULL;
+
+  std::unique_lock<std::mutex> l(lock);
+  scans.push_back(import);
+  queue.push_back(import);
+  addWorkers();
+  queued.notify_one();
+}
+
+BufferedTokenizer* ImportResolver::take(const std::string &filename) {
+  std::unordered_map<std::string, Import*>::iterator it;
+  Import* import;
+  BufferedTokenizer* tokens;
+  IOException* error;
+
+  std::unique_lock<std::mutex> l(lock);
+  
+  it = imports.find(filename);
+  if (it == imports.end())
+    return NULL;
+  import = it->second;
+
+  if (import->state == Import::QUEUED) {
+    // the workers are busy with other files, don't wait for them.
+    import->state = Import::RUNNING;
+    l.unlock();
+    read(*import);
+    l.lock();
+    import->state = Import::DONE;
+  } else {
+    while (import->state != Import::DONE)
+      done.wait(l);
+  }
+
+  tokens = import->tokens;
+  error = import->error;
+  import->tokens = NULL;
+  import->error = NULL;
+
+  if (error != NULL)
+    throw error;
+  return tokens;
+}
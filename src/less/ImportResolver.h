@@ -0,0 +1,118 @@
+#ifndef __ImportResolver_h__
+#define __ImportResolver_h__
+
+#include "../css/BufferedTokenizer.h"
+#include "../css/InputBuffer.h"
+#include "../css/IOException.h"
+
+#include <string>
+#include <list>
+#include <deque>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+
+/**
+ * Reads and tokenizes imported files on a pool of worker threads
+ * ahead of the parser. The files are read through the ImportCache.
+ *
+ * When a file has been tokenized its @import statements are resolved
+ * and the files they import are queued, so the whole import tree is
+ * read while the parser works through the first files. The parser
+ * still parses the files one at a time, in the order they are
+ * imported, and decides which imports are skipped, so the stylesheet
+ * is the same as when the files are read by the parser. Files that
+ * were read but are never imported are thrown away.
+ *
+ * The resolver only guesses which files will be imported; if the
+ * parser imports a file that was not queued take() returns NULL and
+ * the parser reads the file itself.
+ */
+class ImportResolver {
+private:
+  /**
+   * A file that is queued, being read or done.
+   */
+  struct Import {
+    enum State {QUEUED, RUNNING, DONE} state;
+    std::string filename;
+    const char* source;
+    /**
+     * The contents of a file that is only scanned for imports, or NULL
+     * if the file is read by the worker.
+     */
+    const InputBuffer* buffer;
+    BufferedTokenizer* tokens;
+    IOException* error;
+  };
+
+  std::list<const char*>* includePaths;
+  
+  std::unordered_map<std::string, Import*> imports;
+  std::vector<Import*> scans;
+  std::deque<Import*> queue;
+  std::vector<std::thread> workers;
+  /**
+   * The most workers to start. They are started as files are queued,
+   * so a stylesheet without imports doesn't start any.
+   */
+  unsigned int threads;
+
+  std::mutex lock;
+  /**
+   * Signalled when a file is queued or the resolver stops.
+   */
+  std::condition_variable queued;
+  /**
+   * Signalled when a worker is done with a file.
+   */
+  std::condition_variable done;
+  bool stopping;
+
+  void work();
+  /**
+   * Start a worker for each queued file, up to <code>threads</code>
+   * workers. Called with <code>lock</code> held.
+   */
+  void addWorkers();
+  void read(Import &import);
+  
+  /**
+   * Queue the files imported by <code>tokens</code>, in front of the
+   * files that are already queued since the parser gets to them
+   * first.
+   */
+  void addImports(const std::vector<Token> &tokens);
+
+public:
+  ImportResolver(std::list<const char*>* includePaths,
+                 unsigned int threads);
+  /**
+   * Stops the workers and deletes the files that were not taken.
+   */
+  virtual ~ImportResolver();
+
+  /**
+   * Queue the imports of a file that the parser reads itself. Files
+   * that don't contain "@import" are not scanned.
+   * <code>in</code> and <code>source</code> have to stay valid until
+   * the resolver is deleted.
+   */
+  void scan(const InputBuffer &in, const char* source);
+
+  /**
+   * Get the tokens of <code>filename</code>. Waits for the file if a
+   * worker is reading it, or reads it on the calling thread if no
+   * worker has started on it yet.
+   *
+   * @return the tokens, which the caller has to delete, or NULL if the
+   *         file was not queued or it was already taken.
+   * @throws IOException if the file could not be read.
+   */
+  BufferedTokenizer* take(const std::string &filename);
+};
+
+#endif
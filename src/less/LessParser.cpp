@@ -1,5 +1,6 @@
 
 #include "LessParser.h"
+#include "../Statistics.h"
 #include <config.h>
 
 #ifdef WITH_LIBGLOG
@@ -94,7 +95,7 @@ bool LessParser::parseAtRuleOrVariable (LessStylesheet &stylesheet) {
 #ifdef WITH_LIBGLOG
     VLOG(2) << "Parse: variable";
 #endif
-    stylesheet.putVariable(token, value);
+    stylesheet.putVariable(token.getSymbol(), value);
     
   } else {
     if (token == "@media") {
@@ -247,7 +248,7 @@ void LessParser::parseRulesetStatements (LessStylesheet &stylesheet,
       skipWhitespace();
       
       if (parseVariable(value)) {
-        ruleset.putVariable(token, value);
+        ruleset.putVariable(token.getSymbol(), value);
         value.clear();
         
       } else if (token == "@media") {
@@ -383,36 +384,50 @@ UnprocessedStatement* LessParser::parseRulesetStatement (LessRuleset &ruleset) {
   return statement;
 }
 
+/**
+ * Move <code>i</code> past whitespace tokens.
+ */
+static void skipWhitespaceTokens(TokenList::iterator &i,
+                                 const TokenList::iterator &end) {
+  while (i != end && (*i).type == Token::WHITESPACE)
+    i++;
+}
+
 bool LessParser::parseImportStatement(TokenList &statement, LessStylesheet &stylesheet) {
   unsigned int directive = 0;
+  TokenList::iterator i;
 
   // parse directives and strip from statement (the statement becomes a valid
   // css import statement.)
   if (statement.size() >= 4 &&
       statement.front().type == Token::PAREN_OPEN) {
-    statement.pop_front();
-    statement.ltrim();
+    i = statement.begin();
+    i++;
+    skipWhitespaceTokens(i, statement.end());
     
-    directive = parseImportDirective(statement.front());
-    statement.pop_front();
-    statement.ltrim();
+    directive = parseImportDirective(*i);
+    i++;
+    skipWhitespaceTokens(i, statement.end());
     
-    while (statement.size() > 0 && statement.front() == ",") {
-      statement.pop_front();
-      statement.ltrim();
+    while (i != statement.end() && *i == ",") {
+      i++;
+      skipWhitespaceTokens(i, statement.end());
       
-      directive |= parseImportDirective(statement.front());
-      statement.pop_front();
-      statement.ltrim();
+      directive |= parseImportDirective(*i);
+      i++;
+      skipWhitespaceTokens(i, statement.end());
     }
 
-    if (statement.size() > 0 &&
-        statement.front().type != Token::PAREN_CLOSED) {
+    if (i != statement.end() &&
+        (*i).type != Token::PAREN_CLOSED) {
+      statement.erase(statement.begin(), i);
       throw new ParseException(statement, ")");
-    } else {
-      statement.pop_front();
-      statement.ltrim();
+    } else if (i != statement.end()) {
+      i++;
+      skipWhitespaceTokens(i, statement.end());
     }
+    // the directives are removed at once
+    statement.erase(statement.begin(), i);
   }
 
   if (statement.size() > 0 &&
@@ -447,14 +462,9 @@ unsigned int LessParser::parseImportDirective(Token &t) {
                              "inline, less, css, once, multiple or optional");
 }
 
-bool LessParser::importFile(Token uri,
-                            LessStylesheet &stylesheet,
-                            unsigned int directive) {
+bool LessParser::getImportPath(Token &uri, unsigned int directive) {
   size_t pathend;
   size_t extension_pos;
-  std::list<const char*>::iterator i;
-  std::string relative_filename;
-  char* relative_filename_cpy;
   std::string extension;
     
   if (uri.type == Token::URL) {
@@ -486,13 +496,31 @@ bool LessParser::importFile(Token uri,
   
   // don't import css, unless specified with directive
   // don't import if css directive is given
-  if ((extension == "css" &&
-       !(directive & IMPORT_LESS)) ||
-      (directive & IMPORT_CSS)) {
+  return !((extension == "css" &&
+            !(directive & IMPORT_LESS)) ||
+           (directive & IMPORT_CSS));
+}
+
+bool LessParser::importFile(Token uri,
+                            LessStylesheet &stylesheet,
+                            unsigned int directive) {
+  std::string relative_filename;
+  BufferedTokenizer* buffered;
+  std::vector<std::string> missing;
+  std::vector<std::string>::iterator m_it;
+  bool found;
+
+  if (!getImportPath(uri, directive))
     return false;
-  }
 
-  if (!findFile(uri, relative_filename)) {
+  found = findFile(uri, includePaths, relative_filename,
+                   dependencies != NULL ? &missing : NULL);
+
+  // a file created at one of these paths changes what is imported
+  for (m_it = missing.begin(); m_it != missing.end(); m_it++)
+    dependencies->push_back(std::make_pair(*m_it, std::string()));
+  
+  if (!found) {
     if (directive & IMPORT_OPTIONAL)
       return true;
     else {
@@ -501,81 +529,112 @@ bool LessParser::importFile(Token uri,
     }
   }
 
-  if (!(directive & IMPORT_MULTIPLE)) {
-    // check if the file has already been imported.
-    for (i = sources.begin(); i != sources.end(); i++) {
-      if (relative_filename == (*i))
-        return true;
-    }
+  if (imported == NULL) {
+    imported = new std::unordered_set<std::string>(sources.begin(),
+                                                   sources.end());
+    ownsImported = true;
   }
   
-  ifstream in(relative_filename.c_str());
+  // check if the file has already been imported.
+  if (!(directive & IMPORT_MULTIPLE) &&
+      imported->find(relative_filename) != imported->end())
+    return true;
 
+  Statistics::Timer fileTimer(relative_filename);
+  {
+    // includes waiting for the threads that read imports
+    Statistics::Timer timer(Statistics::TOKENIZE);
+    
+    if (resolver == NULL ||
+        (buffered = resolver->take(relative_filename)) == NULL) {
 #ifdef WITH_LIBGLOG
-  VLOG(1) << "Opening: " << relative_filename;
+      VLOG(1) << "Opening: " << relative_filename;
 #endif
+      buffered = ImportCache::getInstance().get(relative_filename);
+    }
+  }
 
-  relative_filename_cpy = new char[relative_filename.length() + 1];
-  std::strcpy(relative_filename_cpy, relative_filename.c_str());
-              
-  sources.push_back(relative_filename_cpy);
-  LessTokenizer tokenizer(in, relative_filename_cpy);
-  LessParser parser(tokenizer, sources, (directive & IMPORT_REFERENCE));
+  sources.push_back(buffered->getSource());
+  imported->insert(relative_filename);
+  if (dependencies != NULL) {
+    dependencies->push_back(std::make_pair(relative_filename,
+                                           buffered->getHash()));
+  }
+  LessParser parser(*buffered, sources, (directive & IMPORT_REFERENCE));
 
   parser.includePaths = includePaths;
+  parser.resolver = resolver;
+  parser.dependencies = dependencies;
+  parser.imported = imported;
   
 #ifdef WITH_LIBGLOG
   VLOG(2) << "Parsing";
 #endif
   
   parser.parseStylesheet(stylesheet);
-  in.close();
+  delete buffered;
   return true;
 }
 
-bool LessParser::findFile(Token& uri, std::string& filename) {
-  ifstream* in;
+bool LessParser::findFile(Token& uri,
+                          std::list<const char*>* includePaths,
+                          std::string& filename,
+                          std::vector<std::string>* missing) {
   size_t pos;
-  std::string source;
+  std::string source, directory, key;
+  std::vector<std::string> probed;
   std::list<const char*>::iterator i;
+  bool found;
+  ImportPathCache& cache = ImportPathCache::getInstance();
   
   source = uri.source;
   pos = source.find_last_of("/\\");
 
   // if the current stylesheet is outside of the current working
   //  directory then add the directory to the filename.
-  if (pos != std::string::npos) {
-    filename.append(source.substr(0, pos + 1));
-  }
-  filename.append(uri);
-  
-#ifdef WITH_LIBGLOG
-  VLOG(2) << "Looking for path: " << filename;
-#endif
+  if (pos != std::string::npos) 
+    directory = source.substr(0, pos + 1);
 
-  in = new ifstream(filename.c_str());
-  if (in->good()) {
-    in->close();
-    return true;
+  key = directory;
+  key.push_back('\0');
+  key.append(uri);
+  for (i = includePaths->begin(); i != includePaths->end(); i++) {
+    key.push_back('\0');
+    key.append(*i);
   }
 
-  for (i = includePaths->begin(); i != includePaths->end(); i++) {
+  if (cache.get(key, filename, found, missing))
+    return found;
+  
+  filename = directory;
+  filename.append(uri);
+  found = fileExists(filename);
+  probed.push_back(filename);
+
+  for (i = includePaths->begin(); !found && i != includePaths->end(); i++) {
     filename.clear();
 
     filename.append((*i));
     filename.append(uri);
+    found = fileExists(filename);
+    probed.push_back(filename);
+  }
+
+  cache.put(key, filename, found, probed);
+  if (missing != NULL) {
+    missing->insert(missing->end(), probed.begin(),
+                    found ? probed.end() - 1 : probed.end());
+  }
+  return found;
+}
 
+bool LessParser::fileExists(const std::string &filename) {
 #ifdef WITH_LIBGLOG
-    VLOG(2) << "Looking for path: " << filename;
+  VLOG(2) << "Looking for path: " << filename;
 #endif
 
-    in = new ifstream(filename.c_str());
-    if (in->good()) {
-      in->close();
-      return true;
-    }
-  }
-  return false;
+  ifstream in(filename.c_str());
+  return in.good();
 }
 
 void LessParser::parseLessMediaQuery(Token &mediatoken,
@@ -14,11 +14,17 @@
 #include "../TokenList.h"
 
 #include "LessTokenizer.h"
+#include "ImportResolver.h"
+#include "ImportCache.h"
+#include "ImportPathCache.h"
 
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <list>
+#include <unordered_set>
+#include <vector>
+#include <utility>
   
 /**
  * Extends the css spec with these parts:
@@ -55,29 +61,82 @@ public:
     IMPORT_OPTIONAL = 64;
 
   std::list<const char*>* includePaths;
+
+  /**
+   * Reads imported files in advance on other threads, or NULL if the
+   * imports are read when they are parsed.
+   */
+  ImportResolver* resolver;
+
+  /**
+   * If not NULL the imported files are added to it with the digests of
+   * the contents that were parsed, and the paths that were looked for
+   * and did not exist with an empty digest.
+   */
+  std::vector<std::pair<std::string, std::string> >* dependencies;
   
   LessParser(CssTokenizer &tokenizer,
              std::list<const char*> &source_files):
     CssParser(tokenizer),
+    resolver(NULL),
+    dependencies(NULL),
     sources(source_files),
-    reference(false) {
+    reference(false),
+    imported(NULL),
+    ownsImported(false) {
   }
   LessParser(CssTokenizer &tokenizer,
              std::list<const char*> &source_files,
              bool isreference):
     CssParser(tokenizer),
+    resolver(NULL),
+    dependencies(NULL),
     sources(source_files),
-    reference(isreference) {
+    reference(isreference),
+    imported(NULL),
+    ownsImported(false) {
   }
   virtual ~LessParser () {
+    if (ownsImported)
+      delete imported;
   }
 
   virtual void parseStylesheet(LessStylesheet &stylesheet);
+
+  static unsigned int parseImportDirective(Token &t);
+
+  /**
+   * Turn the url or string of an import statement into the path of
+   * the file, adding the .less extension if it has none.
+   *
+   * @return false if the file is not imported: remote files and css
+   *         files that are not imported with the less directive.
+   */
+  static bool getImportPath(Token &uri, unsigned int directive);
+
+  /**
+   * Look for <code>uri</code> relative to the file it is imported from
+   * and then in the include paths. The result is kept in the
+   * ImportPathCache. If <code>missing</code> is not NULL the paths that
+   * were looked at and did not exist are added to it.
+   */
+  static bool findFile(Token& uri,
+                       std::list<const char*>* includePaths,
+                       std::string& filename,
+                       std::vector<std::string>* missing = NULL);
   
 protected:
   std::list<const char*> &sources;
   bool reference;
 
+  /**
+   * The files in <code>sources</code>, for checking if a file has been
+   * imported. It is created by the first parser that imports a file
+   * and shared with the parsers of the imported files.
+   */
+  std::unordered_set<std::string>* imported;
+  bool ownsImported;
+
   /**
    * Skip comments only if they are LESS comments, not CSS comments.
    */ 
@@ -125,7 +184,6 @@ protected:
   void parseList(std::list<TokenList*>* list, TokenList* tokens);
 
   bool parseImportStatement(TokenList &statement, LessStylesheet &stylesheet);
-  unsigned int parseImportDirective(Token &t);
   bool importFile(Token uri, LessStylesheet &stylesheet, unsigned int directive);
 
   void parseLessMediaQuery(Token &mediatoken,
@@ -136,7 +194,7 @@ private:
   
   std::list<TokenList*>* processArguments(TokenList* arguments);
 
-  bool findFile(Token& uri, std::string& filename);
+  static bool fileExists(const std::string &filename);
 };
 
 #endif
@@ -1,5 +1,6 @@
 
 #include "LessTokenizer.h"
+#include "../css/CharScanner.h"
 
 LessTokenizer::~LessTokenizer() {
 }
@@ -10,7 +11,9 @@ bool LessTokenizer::readComment () {
 
   currentToken.append(lastRead);
   readChar();
-  while (in != NULL && !lastReadEq('\n')) {
+  if (in == NULL && !eof)
+    readUntil(CharScanner::findLineEnd(pos - 1, end));
+  while (!eof && !lastReadEq('\n')) {
     currentToken.append(lastRead);
     readChar();
   }
@@ -13,6 +13,10 @@
 class LessTokenizer: public CssTokenizer {
 public:
   LessTokenizer(istream &in, const char* source) : CssTokenizer(in, source) {};
+  LessTokenizer(const char* buffer, size_t length, const char* source) :
+    CssTokenizer(buffer, length, source) {};
+  LessTokenizer(const InputBuffer &buffer, const char* source) :
+    CssTokenizer(buffer, source) {};
   virtual ~LessTokenizer();
 protected:
   bool readComment();
@@ -4,17 +4,56 @@
 #include <sstream>
 #include <getopt.h>
 #include <cstring>
+#include <cstdlib>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <system_error>
+#include <vector>
+#include <utility>
+#include <new>
+#include <algorithm>
+#include <cstdio>
+#include <cerrno>
+#include <csignal>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/time.h>
+#include <pthread.h>
+#include <map>
+#include <set>
 
 #include "less/LessTokenizer.h"
 #include "less/LessParser.h"
+#include "less/ImportPathCache.h"
+#include "less/CompilationCache.h"
+#include "value/ImageCache.h"
 #include "css/CssWriter.h"
 #include "css/CssPrettyWriter.h"
 #include "stylesheet/Stylesheet.h"
 #include "css/IOException.h"
+#include "css/InputBuffer.h"
 #include "lessstylesheet/LessStylesheet.h"
+#include "Arena.h"
+#include "SymbolTable.h"
+#include "WorkingDirectory.h"
+#include "Statistics.h"
+#include "Sha256.h"
 
 #include <config.h>
 
+#ifdef HAVE_SYS_INOTIFY_H
+#include <sys/inotify.h>
+#include <poll.h>
+#include <time.h>
+#endif
+
 #ifdef WITH_LIBGLOG
 #include <glog/logging.h>
 #endif
@@ -29,6 +68,9 @@ using namespace std;
 void usage () {
   cout <<
     "Usage: lessc [OPTION]... [FILE]\n"
+    "       lessc --batch [OPTION]... FILE...\n"
+    "       lessc --daemon=SOCKET\n"
+    "       lessc --connect=SOCKET [OPTION]... [FILE]\n"
     "\n"
     "   FILE				Less source file. If not given, source \
 is read from stdin.\n"
@@ -49,6 +91,37 @@ map reference in the css output.\n"
     "\n"
     "   -v, --verbose=<LEVEL>	Output log data for debugging. LEVEL is \
 a number in the range 1-3 that defines granularity.\n" 
+    "       --fast-exit		Exit without freeing the stylesheets \
+after the output is written.\n"
+    "\n"
+    "   -b, --batch			Compile several stylesheets. Each FILE is \
+given as INPUT[:OUTPUT]; without OUTPUT the css is written to INPUT with \
+the .less extension replaced by .css. Can't be used with -o.\n"
+    "       --manifest=<FILE>	Compile the stylesheets listed in FILE, \
+one INPUT [OUTPUT] pair per line.\n"
+    "   -j, --jobs=<N>		Use N threads, for compiling stylesheets \
+in batch mode or for reading imports. Defaults to the number of cores.\n"
+    "\n"
+    "       --watch			Compile the stylesheet again every time \
+it or one of its imports changes.\n"
+    "       --cache-dir=<DIR>	Keep compiled stylesheets in DIR and \
+reuse them while the input, imports, images and options stay the same.\n"
+    "       --cache-size=<SIZE>	Remove the least recently used files \
+when the cache grows over SIZE (like 100M, the default; 0 for no \
+limit).\n"
+    "       --cache-stats		Print the hits, misses and size of the \
+cache and exit.\n"
+    "       --stats[=json]		Write the time spent in each phase and \
+file and the number of tokens, rulesets, mixin calls, guards, values, \
+function calls and objects allocated in the stylesheet arena to \
+stderr, as text or json.\n"
+    "       --modify-var=<NAME=VALUE>   Override the value of the \
+variable NAME.\n"
+    "\n"
+    "       --daemon=<SOCKET>	Listen for compile requests on the unix \
+socket SOCKET. Imported files stay cached between requests.\n"
+    "       --connect=<SOCKET>	Have the daemon listening on SOCKET \
+compile the stylesheet, with the other options.\n"
     "\n"
     "Example:\n"
     "   lessc in.less -o out.css\n"
@@ -96,20 +169,78 @@ void parsePathList(const char* path, std::list<const char*>& paths) {
 }
 
 
+/**
+ * Turn a NAME=VALUE argument into a variable declaration.
+ */
+std::string parseVariable(const char* arg) {
+  std::string variable = arg;
+  size_t pos = variable.find('=');
+
+  if (pos == std::string::npos || pos == 0)
+    throw new IOException("modify-var option requires NAME=VALUE.");
+  
+  variable[pos] = ':';
+  if (variable[0] != '@')
+    variable.insert(0, "@");
+  variable.push_back(';');
+  return variable;
+}
+
+/**
+ * Parse the input. If <code>threads</code> is more than zero, that
+ * many threads read the imported files ahead of the parser.
+ *
+ * The <code>variables</code> are parsed after the input so they
+ * override the variables of the same name in the stylesheet. If
+ * <code>dependencies</code> is not NULL the imported files are added
+ * to it with the hashes of their contents.
+ */
 bool parseInput(LessStylesheet &stylesheet,
-                istream &in,
+                InputBuffer &in,
                 const char* source,
                 std::list<const char*> &sources,
-                std::list<const char*> &includePaths){
+                std::list<const char*> &includePaths,
+                unsigned int threads,
+                const std::vector<std::string> &variables,
+                CompilationCache::FileHashes* dependencies = NULL){
   std::list<const char*>::iterator i;
+  std::vector<std::string>::const_iterator v;
+  ImportResolver* resolver = NULL;
   
   LessTokenizer tokenizer(in, source);
   LessParser parser(tokenizer, sources);
   parser.includePaths = &includePaths;
+  parser.dependencies = dependencies;
+
+  if (threads > 0) {
+    resolver = new ImportResolver(&includePaths, threads);
+    resolver->scan(in, source);
+    parser.resolver = resolver;
+  }
   
   try{
-    parser.parseStylesheet(stylesheet);
+    Statistics::Timer timer(Statistics::PARSE);
+    {
+      Statistics::Timer fileTimer(source);
+      parser.parseStylesheet(stylesheet);
+    }
+    if (resolver != NULL) {
+      delete resolver;
+      resolver = NULL;
+    }
+
+    for (v = variables.begin(); v != variables.end(); v++) {
+      LessTokenizer variableTokenizer(v->c_str(), v->size(),
+                                      "--modify-var");
+      LessParser variableParser(variableTokenizer, sources);
+
+      variableParser.includePaths = &includePaths;
+      variableParser.parseStylesheet(stylesheet);
+    }
+    
   } catch(ParseException* e) {
+    if (resolver != NULL)
+      delete resolver;
 #ifdef WITH_LIBGLOG
     LOG(ERROR) << e->getSource() << ": Line " << e->getLineNumber() << ", Column " << 
       e->getColumn() << " Parse Error: " << e->what();
@@ -120,6 +251,8 @@ bool parseInput(LessStylesheet &stylesheet,
     
     return false;
   } catch(exception* e) {
+    if (resolver != NULL)
+      delete resolver;
 #ifdef WITH_LIBGLOG
     LOG(ERROR) << " Error: " << e->what();
 #else
@@ -135,11 +268,14 @@ bool parseInput(LessStylesheet &stylesheet,
 #endif
   return true;
 }
-void writeOutput (LessStylesheet &stylesheet,
-                  CssWriter &writer) {
-  Stylesheet css;
+bool writeOutput (LessStylesheet &stylesheet,
+                  Stylesheet &css,
+                  CssWriter &writer,
+                  bool sourceLocations) {
   ProcessingContext context;
 
+  context.setSourceLocations(sourceLocations);
+
   try{
     stylesheet.process(css, context);
 
@@ -152,7 +288,7 @@ void writeOutput (LessStylesheet &stylesheet,
       e->getColumn() << " Parse Error: " << e->what();
 #endif
 
-    return;
+    return false;
 
   } catch(ValueException* e) {
 #ifdef WITH_LIBGLOG
@@ -163,37 +299,1128 @@ void writeOutput (LessStylesheet &stylesheet,
       e->getColumn() << " Error: " << e->what();
 #endif
     
-    return;
+    return false;
   } catch(exception* e) {
 #ifdef WITH_LIBGLOG
     LOG(ERROR) << "Error: " << e->what();
 #else
     cerr << "Error: " << e->what();
 #endif
-    return;
+    return false;
+  }
+
+  {
+    Statistics::Timer timer(Statistics::WRITE);
+    css.write(writer);
   }
+  return true;
+}
+
+/**
+ * The options that apply to every stylesheet that is compiled.
+ */
+struct CompileOptions {
+  bool formatoutput;
+  /**
+   * The source map file, "-" to write it to the name of the source
+   * with .map appended, or empty for no source map.
+   */
+  std::string sourcemap_file;
+  const char* sourcemap_rootpath;
+  const char* sourcemap_basepath;
+  const char* rootpath;
+  std::list<const char*> includePaths;
+  bool fastexit;
+  /**
+   * The number of threads that read imports ahead of the parser.
+   */
+  unsigned int importThreads;
+  /**
+   * Variable declarations that override the stylesheet's variables.
+   */
+  std::vector<std::string> variables;
+  /**
+   * The cache of compiled stylesheets, or NULL.
+   */
+  CompilationCache* cache;
+};
 
-  css.write(writer);
+/**
+ * The key the output of compiling <code>input</code> is cached under,
+ * the digest of the working directory, the file names and the options
+ * that change the output.
+ */
+std::string getCacheKey(const char* input, const char* output,
+                        const std::string &sourcemap_file,
+                        const CompileOptions &options) {
+  std::string description = PACKAGE_STRING;
+  std::list<const char*>::const_iterator i;
+  std::vector<std::string>::const_iterator v;
+
+  description.push_back('\0');
+  // relative file names and paths depend on it
+  description.append(WorkingDirectory::get());
+  description.push_back('\0');
+  description.append(input);
+  description.push_back('\0');
+  // the source map refers to the output file
+  if (sourcemap_file != "")
+    description.append(output);
+  description.push_back('\0');
+  description.append(options.formatoutput ? "format" : "");
+  description.push_back('\0');
+  description.append(sourcemap_file);
+  description.push_back('\0');
+  if (options.sourcemap_rootpath != NULL)
+    description.append(options.sourcemap_rootpath);
+  description.push_back('\0');
+  if (options.sourcemap_basepath != NULL)
+    description.append(options.sourcemap_basepath);
+  description.push_back('\0');
+  if (options.rootpath != NULL)
+    description.append(options.rootpath);
+  
+  for (i = options.includePaths.begin(); i != options.includePaths.end();
+       i++) {
+    description.append("\0I", 2);
+    description.append(*i);
+  }
+  for (v = options.variables.begin(); v != options.variables.end(); v++) {
+    description.append("\0V", 2);
+    description.append(*v);
+  }
+  return Sha256::hash(description.data(), description.size());
 }
 
-int main(int argc, char * argv[]){
-  istream* in = &cin;
+/**
+ * Compile <code>input</code> and write the css to <code>output</code>.
+ * Either can be "-" for stdin and stdout. If <code>files</code> is
+ * given the names of the files that were read are added to it, even if
+ * the stylesheet could not be compiled.
+ *
+ * @return false if the stylesheet could not be compiled.
+ */
+bool compile(const char* input, const char* output,
+             const CompileOptions &options,
+             std::vector<std::string>* files = NULL) {
+  // All stylesheet nodes and values are allocated from the arena. It
+  // is declared first so it outlives the stylesheets.
+  Arena arena;
+  ArenaScope arenaScope(arena);
+  // the names the stylesheets use, other than the well-known ones
+  SymbolTable symbols;
+  SymbolScope symbolScope(symbols);
+  InputBuffer* in = NULL;
   ostream* out = &cout;
-  bool formatoutput = false;
+  // the stream the css is written to; a buffer if it is cached
+  ostream* css_out;
   char* source = NULL;
-  string output = "-";
   LessStylesheet stylesheet;
+  Stylesheet css;
   std::list<const char*> sources;
+  std::list<const char*>::iterator i;
+  std::list<const char*> includePaths(options.includePaths);
   CssWriter* writer;
-
-  std::string sourcemap_file = "";
+  std::string sourcemap_file = options.sourcemap_file;
+  std::string sourcemap_path;
   ostream* sourcemap_s = NULL;
   SourceMapWriter* sourcemap = NULL;
-  const char* sourcemap_rootpath = NULL;
-  const char* sourcemap_basepath = NULL;
-  const char* rootpath = NULL;
+  bool caching;
+  std::string key;
+  std::string cached_css, cached_map;
+  std::vector<std::string> cached_files;
+  CompilationCache::FileHashes dependencies;
+  bool cached = false;
+  bool success = false;
 
-  std::list<const char*> includePaths;
+#ifdef WITH_LIBGLOG
+  VLOG(1) << "Compiling " << input << " to " << output;
+#endif
+
+  // a daemon may have changed the directory, and files may have been
+  // created or deleted since the last compilation
+  WorkingDirectory::update();
+  ImportPathCache::getInstance().check();
+  
+  try {
+    if (std::strcmp(output, "-") != 0)
+      out = new ofstream(output);
+    
+    if (std::strcmp(input, "-") != 0) {
+      source = new char[std::strlen(input) + 1];
+      std::strcpy(source, input);
+
+    } else if (sourcemap_file == "-") {
+      throw new IOException("source-map option requires that \
+a file name is specified for either the source map or the less \
+source.");
+    } else {
+      source = new char[2];
+      std::strcpy(source, "-");
+      in = new InputBuffer(cin);
+    }
+    
+    if (sourcemap_file == "-") {
+      sourcemap_file = source;
+      sourcemap_file += ".map";
+    }
+    sourcemap_path = sourcemap_file;
+
+    sources.push_back(source);
+
+    // stdin can't be looked up in the cache
+    caching = options.cache != NULL && in == NULL;
+    if (caching) {
+      key = getCacheKey(source, output, sourcemap_file, options);
+      cached = options.cache->get(key, sourcemap_file != "",
+                                  cached_css, cached_map, cached_files);
+    }
+
+    if (cached) {
+      *out << cached_css;
+      if (sourcemap_file != "") {
+        ofstream sourcemap_f(sourcemap_file.c_str());
+        sourcemap_f << cached_map;
+      }
+      success = true;
+      
+    } else {
+      if (in == NULL)
+        in = new InputBuffer(source);
+      if (caching) {
+        dependencies.push_back(std::make_pair(source, Sha256::hash
+                                              (in->getData(),
+                                               in->getLength())));
+      }
+      
+      if (parseInput(stylesheet, *in, source, sources, includePaths,
+                     options.importThreads, options.variables,
+                     caching ? &dependencies : NULL)) {
+        css_out = caching ? new ostringstream() : out;
+        
+        if (sourcemap_file != "") {
+#ifdef WITH_LIBGLOG
+          VLOG(1) << "sourcemap: " << sourcemap_file;
+#endif
+          sourcemap_s = caching ? (ostream*)new ostringstream() :
+            (ostream*)new ofstream(sourcemap_file.c_str());
+          sourcemap = new SourceMapWriter(*sourcemap_s, sources, output,
+                                          options.sourcemap_rootpath,
+                                          options.sourcemap_basepath);
+
+          writer = options.formatoutput ?
+            new CssPrettyWriter(*css_out, *sourcemap) :
+            new CssWriter(*css_out, *sourcemap);
+        } else {
+          writer = options.formatoutput ? new CssPrettyWriter(*css_out) :
+            new CssWriter(*css_out);
+        }
+        writer->rootpath = options.rootpath;
+
+        if (caching)
+          ImageCache::setRecording(&dependencies);
+        success = writeOutput(stylesheet, css, *writer, sourcemap != NULL);
+        ImageCache::setRecording(NULL);
+      
+        if (sourcemap != NULL) {
+          if (options.sourcemap_basepath != NULL &&
+              sourcemap_file.compare(0,
+                                     std::strlen(options.sourcemap_basepath),
+                                     options.sourcemap_basepath) == 0) {
+            sourcemap_file.erase(0, std::strlen(options.sourcemap_basepath));
+          }
+          if (options.sourcemap_rootpath != NULL)
+            sourcemap_file.insert(0, options.sourcemap_rootpath);
+        
+          writer->writeSourceMapUrl(sourcemap_file.c_str());
+          sourcemap->close();
+          delete sourcemap;
+        }
+      
+        delete writer;
+        *css_out << endl;
+
+        if (caching) {
+          cached_css = static_cast<ostringstream*>(css_out)->str();
+          *out << cached_css;
+          delete css_out;
+          
+          if (sourcemap_s != NULL) {
+            cached_map = static_cast<ostringstream*>(sourcemap_s)->str();
+            ofstream sourcemap_f(sourcemap_path.c_str());
+            sourcemap_f << cached_map;
+          }
+          
+          if (success) {
+            options.cache->put(key, dependencies, cached_css,
+                               sourcemap_s != NULL ? &cached_map : NULL);
+          }
+        }
+        if (sourcemap_s != NULL)
+          delete sourcemap_s;
+
+        // Leave the process without running the destructors of the
+        // stylesheets; the system reclaims the memory in one go.
+        if (options.fastexit) {
+          out->flush();
+          std::exit(success ? 0 : 1);
+        }
+      }
+    }
+    
+  } catch (IOException* e) {
+#ifdef WITH_LIBGLOG
+    LOG(ERROR) << " Error: " << e->what();
+#else
+    cerr << " Error: " << e->what();
+#endif
+  }
+
+  if (files != NULL) {
+    if (cached)
+      files->insert(files->end(), cached_files.begin(), cached_files.end());
+    else {
+      for (i = sources.begin(); i != sources.end(); i++)
+        files->push_back(*i);
+    }
+  }
+  
+  if (in != NULL)
+    delete in;
+  if (source != NULL)
+    delete [] source;
+  if (out != &cout)
+    delete out;
+  return success;
+}
+
+/**
+ * Get the output file for <code>input</code> if none is given: the
+ * input file with the .less extension replaced by .css.
+ */
+std::string getDefaultOutput(const std::string &input) {
+  size_t pos = input.rfind('.');
+  
+  if (pos != std::string::npos &&
+      input.find('/', pos) == std::string::npos &&
+      input.compare(pos, std::string::npos, ".less") == 0)
+    return input.substr(0, pos) + ".css";
+  return input + ".css";
+}
+
+/**
+ * Add a job for an argument in the form INPUT[:OUTPUT].
+ */
+void parseJob(const char* arg,
+              std::vector<std::pair<std::string, std::string> > &jobs) {
+  std::string job = arg;
+  size_t pos = job.find(':');
+
+  if (pos == std::string::npos)
+    jobs.push_back(std::make_pair(job, getDefaultOutput(job)));
+  else
+    jobs.push_back(std::make_pair(job.substr(0, pos), job.substr(pos + 1)));
+}
+
+/**
+ * Read the jobs from a manifest file. Each line has an input file,
+ * optionally followed by whitespace and an output file. Empty lines and
+ * lines starting with a '#' are skipped.
+ */
+void parseManifest(const char* filename,
+                   std::vector<std::pair<std::string, std::string> > &jobs) {
+  ifstream manifest(filename);
+  std::string line, input, output;
+  
+  if (!manifest.good())
+    throw new IOException("Error opening manifest");
+
+  while (std::getline(manifest, line)) {
+    istringstream fields(line);
+
+    input.clear();
+    output.clear();
+    fields >> input >> output;
+
+    if (input.empty() || input[0] == '#')
+      continue;
+    if (output.empty())
+      output = getDefaultOutput(input);
+    jobs.push_back(std::make_pair(input, output));
+  }
+}
+
+/**
+ * The jobs of a batch, which the batch threads take in turn.
+ */
+struct Batch {
+  const std::vector<std::pair<std::string, std::string> >* jobs;
+  const CompileOptions* options;
+  std::atomic<size_t> next;
+  std::atomic<size_t> failed;
+};
+
+void runBatch(Batch* batch) {
+  size_t i;
+
+  while ((i = batch->next++) < batch->jobs->size()) {
+    if (!compile((*batch->jobs)[i].first.c_str(),
+                 (*batch->jobs)[i].second.c_str(),
+                 *batch->options))
+      batch->failed++;
+  }
+}
+
+/**
+ * Compile every job on <code>threads</code> threads. The caches of
+ * imported files, include paths and images are shared between the
+ * jobs.
+ *
+ * @return the number of jobs that failed.
+ */
+size_t compileBatch(const std::vector<std::pair<std::string, std::string> >
+                    &jobs,
+                    const CompileOptions &options,
+                    unsigned int threads) {
+  Batch batch;
+  std::vector<std::thread> workers;
+  std::vector<std::thread>::iterator it;
+  unsigned int i;
+
+  batch.jobs = &jobs;
+  batch.options = &options;
+  batch.next = 0;
+  batch.failed = 0;
+
+  if (threads > jobs.size())
+    threads = jobs.size();
+
+  // the calling thread runs jobs as well
+  for (i = 1; i < threads; i++) 
+    workers.push_back(std::thread(runBatch, &batch));
+  runBatch(&batch);
+
+  for (it = workers.begin(); it != workers.end(); it++)
+    it->join();
+  return batch.failed;
+}
+
+/**
+ * Write <code>length</code> bytes to a socket.
+ */
+bool writeData(int fd, const char* data, size_t length) {
+  ssize_t n;
+  
+  while (length > 0) {
+    n = write(fd, data, length);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    data += n;
+    length -= n;
+  }
+  return true;
+}
+
+/**
+ * Read <code>length</code> bytes from a socket.
+ */
+bool readData(int fd, char* data, size_t length) {
+  ssize_t n;
+  
+  while (length > 0) {
+    n = read(fd, data, length);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    data += n;
+    length -= n;
+  }
+  return true;
+}
+
+bool writeNumber(int fd, uint32_t number) {
+  return writeData(fd, (const char*)&number, sizeof(number));
+}
+
+bool readNumber(int fd, uint32_t &number) {
+  return readData(fd, (char*)&number, sizeof(number));
+}
+
+/**
+ * The most strings in a request, and the longest string a request or
+ * a reply may hold. Connections that send more are dropped.
+ */
+const uint32_t MAX_REQUEST_STRINGS = 4096;
+const uint32_t MAX_STRING_LENGTH = 256U << 20;
+
+/**
+ * Strings are sent as their length followed by their contents.
+ */
+bool writeString(int fd, const std::string &str) {
+  return writeNumber(fd, str.size()) &&
+    writeData(fd, str.data(), str.size());
+}
+
+bool readString(int fd, std::string &str) {
+  uint32_t length;
+
+  if (!readNumber(fd, length) || length > MAX_STRING_LENGTH)
+    return false;
+  str.resize(length);
+  return length == 0 || readData(fd, &str[0], length);
+}
+
+/**
+ * Read the rest of a temporary file.
+ */
+std::string readTemporaryFile(FILE* file) {
+  std::string contents;
+  char chunk[8192];
+  size_t n;
+
+  rewind(file);
+  while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0)
+    contents.append(chunk, n);
+  return contents;
+}
+
+int run(int argc, char* argv[], bool served);
+
+/**
+ * Read the request of a client.
+ *
+ * A request is the number of strings that follow, the working
+ * directory of the client, its standard input and its arguments.
+ *
+ * @return false if the request could not be read or is too large.
+ */
+bool readRequest(int client, std::string &cwd, std::string &input,
+                 std::vector<std::string> &args) {
+  uint32_t count, i;
+
+  if (!readNumber(client, count) || count < 2 ||
+      count > MAX_REQUEST_STRINGS ||
+      !readString(client, cwd) ||
+      !readString(client, input))
+    return false;
+  
+  args.push_back("lessc");
+  for (i = 2; i < count; i++) {
+    args.push_back(std::string());
+    if (!readString(client, args.back()))
+      return false;
+  }
+  return true;
+}
+
+/**
+ * How long the daemon waits for a client to send its request or to
+ * read the reply, in seconds.
+ */
+const int CLIENT_TIMEOUT = 10;
+
+/**
+ * The most connections the daemon reads requests from at the same
+ * time.
+ */
+const unsigned int MAX_CONNECTIONS = 16;
+
+/**
+ * The state the connections of a daemon share. Every connection is
+ * read and replied to on its own thread, so a client that is slow to
+ * send its request doesn't hold up the others, but the requests are
+ * compiled one at a time since a compilation redirects the standard
+ * streams and changes the working directory of the process.
+ */
+struct Daemon {
+  /**
+   * The directory requests return to after they are compiled.
+   */
+  int home;
+  std::mutex compiling;
+  
+  std::mutex lock;
+  std::condition_variable finished;
+  unsigned int connections;
+};
+
+/**
+ * Compile a request with the standard streams of the process
+ * redirected to temporary files, and set <code>out</code> and
+ * <code>err</code> to what was written to stdout and stderr.
+ *
+ * @return the exit status of the request.
+ */
+int compileRequest(Daemon &daemon, const std::string &cwd,
+                   std::string &input, std::vector<char*> &argv,
+                   std::string &out, std::string &err) {
+  std::lock_guard<std::mutex> l(daemon.compiling);
+  FILE *in_file = NULL, *out_file = NULL, *err_file = NULL;
+  int saved[3];
+  int status;
+
+  in_file = tmpfile();
+  out_file = tmpfile();
+  err_file = tmpfile();
+  if (in_file == NULL || out_file == NULL || err_file == NULL) {
+    if (in_file != NULL)
+      fclose(in_file);
+    if (out_file != NULL)
+      fclose(out_file);
+    if (err_file != NULL)
+      fclose(err_file);
+    err = " Error: Error creating temporary files";
+    return 1;
+  }
+  fwrite(input.data(), 1, input.size(), in_file);
+  rewind(in_file);
+  input.clear();
+  input.shrink_to_fit();
+  
+  cout.flush();
+  cerr.flush();
+  fflush(stdout);
+  fflush(stderr);
+  saved[0] = dup(0);
+  saved[1] = dup(1);
+  saved[2] = dup(2);
+  dup2(fileno(in_file), 0);
+  dup2(fileno(out_file), 1);
+  dup2(fileno(err_file), 2);
+  clearerr(stdin);
+  cin.clear();
+  
+  if (chdir(cwd.c_str()) != 0) {
+    cerr << " Error: " << std::strerror(errno) << ": " << cwd;
+    status = 1;
+  } else {
+    try {
+      status = run(argv.size() - 1, &argv[0], true);
+    } catch (ParseException* e) {
+      cerr << e->getSource() << ": Line " << e->getLineNumber() <<
+        ", Column " << e->getColumn() << " Parse Error: " << e->what();
+      status = 1;
+    } catch (ValueException* e) {
+      cerr << e->getSource() << ": Line " << e->getLineNumber() <<
+        ", Column " << e->getColumn() << " Error: " << e->what();
+      status = 1;
+    } catch (IOException* e) {
+      cerr << " Error: " << e->what();
+      status = 1;
+    } catch (exception* e) {
+      cerr << " Error: " << e->what();
+      status = 1;
+    } catch (std::bad_alloc &e) {
+      cerr << " Error: " << e.what();
+      status = 1;
+    }
+  }
+
+  cout.flush();
+  cerr.flush();
+  fflush(stdout);
+  fflush(stderr);
+  dup2(saved[0], 0);
+  dup2(saved[1], 1);
+  dup2(saved[2], 2);
+  close(saved[0]);
+  close(saved[1]);
+  close(saved[2]);
+  clearerr(stdin);
+  cin.clear();
+  cout.clear();
+  cerr.clear();
+  if (fchdir(daemon.home) != 0)
+    cerr << " Error: " << std::strerror(errno);
+
+  try {
+    out = readTemporaryFile(out_file);
+    err = readTemporaryFile(err_file);
+  } catch (std::bad_alloc &e) {
+    out.clear();
+    err = " Error: ";
+    err.append(e.what());
+    status = 1;
+  }
+  
+  fclose(in_file);
+  fclose(out_file);
+  fclose(err_file);
+  return status;
+}
+
+/**
+ * Read the request of a client, compile it and send back the exit
+ * status and what was written to stdout and stderr. The connection is
+ * dropped if the request can't be read in time or the daemon runs out
+ * of memory. Runs on its own thread and closes the connection.
+ */
+void serve(int client, Daemon* daemon) {
+  std::string cwd, input, out, err;
+  std::vector<std::string> args;
+  std::vector<char*> argv;
+  int status;
+  size_t i;
+
+  try {
+    if (readRequest(client, cwd, input, args)) {
+      for (i = 0; i < args.size(); i++)
+        argv.push_back(&args[i][0]);
+      argv.push_back(NULL);
+
+      status = compileRequest(*daemon, cwd, input, argv, out, err);
+
+      writeNumber(client, status) &&
+        writeString(client, out) &&
+        writeString(client, err);
+    }
+  } catch (std::bad_alloc &e) {
+    // the client sees the connection close without a reply
+  }
+  close(client);
+
+  std::lock_guard<std::mutex> l(daemon->lock);
+  daemon->connections--;
+  daemon->finished.notify_all();
+}
+
+volatile sig_atomic_t daemonStopped = 0;
+
+void stopDaemon(int signal) {
+  (void)signal;
+  daemonStopped = 1;
+}
+
+/**
+ * Fill in the address of the socket at <code>path</code>.
+ */
+void getAddress(const char* path, struct sockaddr_un &address) {
+  if (std::strlen(path) >= sizeof(address.sun_path))
+    throw new IOException("Socket path is too long");
+  
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  std::strcpy(address.sun_path, path);
+}
+
+/**
+ * Listen on the socket at <code>path</code> and compile the requests
+ * of clients until the process is interrupted or terminated. The
+ * caches of imported files, include paths and images are kept between
+ * the requests, so only the files that changed are read again.
+ */
+int runDaemon(const char* path) {
+  struct sockaddr_un address;
+  struct sigaction action;
+  struct timeval timeout;
+  sigset_t signals, mask_signals;
+  Daemon daemon;
+  int server, client;
+  mode_t mask;
+  bool bound;
+
+  getAddress(path, address);
+
+  server = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (server < 0)
+    throw new IOException("Error creating socket");
+
+  // only the user that runs the daemon can connect to it
+  mask = umask(077);
+  bound = bind(server, (struct sockaddr*)&address, sizeof(address)) == 0;
+  if (!bound && errno == EADDRINUSE) {
+    // a socket that no daemon listens on is left over
+    client = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (client >= 0 &&
+        connect(client, (struct sockaddr*)&address, sizeof(address)) != 0 &&
+        errno == ECONNREFUSED) {
+      unlink(path);
+      bound = bind(server, (struct sockaddr*)&address,
+                   sizeof(address)) == 0;
+    }
+    if (client >= 0)
+      close(client);
+  }
+  umask(mask);
+  
+  if (!bound || listen(server, SOMAXCONN) != 0) {
+    close(server);
+    throw new IOException("Error listening on socket");
+  }
+
+  // without SA_RESTART accept() returns when the daemon is stopped
+  std::memset(&action, 0, sizeof(action));
+  action.sa_handler = stopDaemon;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGINT, &action, NULL);
+  sigaction(SIGTERM, &action, NULL);
+  signal(SIGPIPE, SIG_IGN);
+
+  // requests change the working directory; this is where to return to
+  daemon.home = open(".", O_RDONLY);
+  daemon.connections = 0;
+
+  // the signals stop the accept() of this thread, so the connection
+  // threads block them
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+
+  timeout.tv_sec = CLIENT_TIMEOUT;
+  timeout.tv_usec = 0;
+
+#ifdef WITH_LIBGLOG
+  VLOG(1) << "Listening on " << path;
+#endif
+  
+  while (!daemonStopped) {
+    client = accept(server, NULL, NULL);
+    if (client < 0) {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+      break;
+    }
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    {
+      std::unique_lock<std::mutex> l(daemon.lock);
+      while (daemon.connections >= MAX_CONNECTIONS)
+        daemon.finished.wait(l);
+      daemon.connections++;
+    }
+
+    pthread_sigmask(SIG_BLOCK, &signals, &mask_signals);
+    try {
+      std::thread(serve, client, &daemon).detach();
+    } catch (std::system_error &e) {
+      close(client);
+      std::lock_guard<std::mutex> l(daemon.lock);
+      daemon.connections--;
+    }
+    pthread_sigmask(SIG_SETMASK, &mask_signals, NULL);
+  }
+
+  // let the requests that are in progress finish
+  {
+    std::unique_lock<std::mutex> l(daemon.lock);
+    while (daemon.connections > 0)
+      daemon.finished.wait(l);
+  }
+  
+  if (daemon.home >= 0)
+    close(daemon.home);
+  close(server);
+  unlink(path);
+  return 0;
+}
+
+/**
+ * Send the arguments to the daemon listening on <code>path</code> and
+ * write out the reply as if the stylesheet was compiled by this
+ * process. Standard input is sent along if the input is read from it.
+ * The arguments in <code>skip</code>, the --connect option, are not
+ * sent.
+ *
+ * @return the exit status of the request.
+ */
+int runClient(const char* path, int argc, char* argv[], bool readInput,
+              const std::vector<char*> &skip) {
+  struct sockaddr_un address;
+  std::string input, out, err;
+  uint32_t status;
+  int fd, i;
+  bool sent;
+
+  getAddress(path, address);
+
+  if (readInput) {
+    InputBuffer in(cin);
+    input.assign(in.getData(), in.getLength());
+  }
+
+  fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0 ||
+      connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+    if (fd >= 0)
+      close(fd);
+    throw new IOException("Error connecting to daemon");
+  }
+
+  signal(SIGPIPE, SIG_IGN);
+  sent = writeNumber(fd, argc + 1 - skip.size()) &&
+    writeString(fd, WorkingDirectory::get()) &&
+    writeString(fd, input);
+  for (i = 1; sent && i < argc; i++) {
+    if (std::find(skip.begin(), skip.end(), argv[i]) == skip.end())
+      sent = writeString(fd, argv[i]);
+  }
+  
+  if (!sent ||
+      !readNumber(fd, status) ||
+      !readString(fd, out) ||
+      !readString(fd, err)) {
+    close(fd);
+    throw new IOException("Error communicating with daemon");
+  }
+  close(fd);
+
+  cout << out;
+  cerr << err;
+  return status;
+}
+
+#ifdef HAVE_SYS_INOTIFY_H
+/**
+ * The directories of the files a watched stylesheet depends on. A
+ * directory is watched instead of the files in it so the files that
+ * editors replace by renaming a new file over them are still noticed.
+ */
+struct WatchedFiles {
+  int fd;
+  /**
+   * The watch descriptors of the directories and the names of the
+   * files in them that the stylesheet depends on.
+   */
+  std::map<int, std::set<std::string> > names;
+};
+
+/**
+ * Watch the directories of <code>files</code> and stop watching the
+ * directories that have none of the files left, so imports that are
+ * added or removed are followed.
+ */
+void updateWatches(WatchedFiles &watched,
+                   const std::vector<std::string> &files) {
+  std::vector<std::string>::const_iterator it;
+  std::map<int, std::set<std::string> >::iterator n_it;
+  std::string directory;
+  size_t pos;
+  int wd;
+  
+  for (n_it = watched.names.begin(); n_it != watched.names.end(); n_it++)
+    n_it->second.clear();
+
+  for (it = files.begin(); it != files.end(); it++) {
+    pos = it->rfind('/');
+    directory = pos == std::string::npos ? "." :
+      pos == 0 ? "/" : it->substr(0, pos);
+
+    wd = inotify_add_watch(watched.fd, directory.c_str(),
+                           IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE |
+                           IN_DELETE | IN_MOVED_FROM);
+    if (wd < 0) {
+      cerr << " Error: Can't watch " << directory << ": " <<
+        std::strerror(errno) << endl;
+      continue;
+    }
+    watched.names[wd].insert(pos == std::string::npos ? *it :
+                             it->substr(pos + 1));
+  }
+
+  for (n_it = watched.names.begin(); n_it != watched.names.end(); ) {
+    if (n_it->second.empty()) {
+      inotify_rm_watch(watched.fd, n_it->first);
+      watched.names.erase(n_it++);
+    } else
+      n_it++;
+  }
+}
+
+/**
+ * Check if one of <code>files</code> was modified at or after
+ * <code>time</code>, a time of the coarse clock the file system takes
+ * modification times from.
+ */
+bool isModifiedSince(const std::vector<std::string> &files,
+                     const struct timespec &time) {
+  std::vector<std::string>::const_iterator it;
+  struct stat st;
+
+  for (it = files.begin(); it != files.end(); it++) {
+    if (stat(it->c_str(), &st) != 0)
+      continue;
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+    if (st.st_mtim.tv_sec > time.tv_sec ||
+        (st.st_mtim.tv_sec == time.tv_sec &&
+         st.st_mtim.tv_nsec >= time.tv_nsec))
+      return true;
+#else
+    if (st.st_mtime >= time.tv_sec)
+      return true;
+#endif
+  }
+  return false;
+}
+
+/**
+ * Read the pending events and check if any of them is about a watched
+ * file. If <code>created</code> is set a file appearing anywhere in the
+ * directories counts as well, for when an import could not be found.
+ */
+bool readEvents(WatchedFiles &watched, bool created) {
+  char buffer[4096]
+    __attribute__ ((aligned(__alignof__(struct inotify_event))));
+  const struct inotify_event* event;
+  std::map<int, std::set<std::string> >::iterator n_it;
+  ssize_t length;
+  char* pos;
+  bool changed = false;
+
+  length = read(watched.fd, buffer, sizeof(buffer));
+  if (length < 0 && errno != EINTR)
+    throw new IOException("Error watching files");
+  if (length <= 0)
+    return false;
+
+  for (pos = buffer; pos < buffer + length;
+       pos += sizeof(struct inotify_event) + event->len) {
+    event = (const struct inotify_event*)pos;
+    n_it = watched.names.find(event->wd);
+    
+    if (n_it == watched.names.end() || event->len == 0)
+      continue;
+    if (n_it->second.count(event->name) > 0 ||
+        (created && (event->mask & (IN_CREATE | IN_MOVED_TO)) != 0))
+      changed = true;
+  }
+  return changed;
+}
+
+/**
+ * Compile <code>input</code> and compile it again every time it or one
+ * of the files it imports changes, until the process is interrupted.
+ *
+ * Every compilation records the files that were read, so the imports
+ * that are added or removed are followed. The tokens of the imports
+ * that didn't change come from the ImportCache; the stylesheet itself
+ * is parsed again as mixins and variables can be used across files.
+ */
+int runWatch(const char* input, const char* output,
+             const CompileOptions &options) {
+  WatchedFiles watched;
+  std::vector<std::string> files;
+  struct pollfd pfd;
+  struct timespec started;
+  bool success;
+
+  if (std::strcmp(input, "-") == 0)
+    throw new IOException("watch option requires an input file.");
+  
+  watched.fd = inotify_init();
+  if (watched.fd < 0)
+    throw new IOException("Error watching files");
+  pfd.fd = watched.fd;
+  pfd.events = POLLIN;
+
+  while (true) {
+    files.clear();
+    files.push_back(input);
+    
+    clock_gettime(CLOCK_REALTIME_COARSE, &started);
+    success = compile(input, output, options, &files);
+    if (!success)
+      cerr << endl;
+    cout.flush();
+
+    updateWatches(watched, files);
+
+    // a file that changed after it was read but before its directory
+    // was watched has no event
+    if (isModifiedSince(files, started))
+      continue;
+
+    // wait for a change, then for the writes that follow it
+    while (!readEvents(watched, !success)) {
+    }
+    while (poll(&pfd, 1, 50) > 0)
+      readEvents(watched, !success);
+  }
+  return 0;
+}
+#endif
+
+/**
+ * Parse a size in bytes, optionally followed by K, M or G.
+ */
+unsigned long long parseSize(const char* arg) {
+  char* end;
+  unsigned long long size = std::strtoull(arg, &end, 10);
+
+  switch (*end) {
+  case 'G': case 'g':
+    size <<= 10;
+    // fall through
+  case 'M': case 'm':
+    size <<= 10;
+    // fall through
+  case 'K': case 'k':
+    size <<= 10;
+    end++;
+    break;
+  }
+  if (end == arg || *end != '\0')
+    throw new IOException("cache-size option requires a size like 100M.");
+  return size;
+}
+
+void printCacheStats(const CompilationCache &cache) {
+  unsigned long long hits, misses, size;
+  size_t entries;
+
+  cache.getStats(hits, misses, entries, size);
+  cout << "hits: " << hits << "\n"
+    "misses: " << misses << "\n"
+    "stylesheets: " << entries << "\n"
+    "size: " << size << " bytes\n";
+}
+
+/**
+ * Free the paths allocated while parsing the options.
+ */
+void freeOptions(CompileOptions &options) {
+  std::list<const char*>::iterator i;
+
+  if (options.sourcemap_rootpath != NULL)
+    delete [] options.sourcemap_rootpath;
+  if (options.sourcemap_basepath != NULL)
+    delete [] options.sourcemap_basepath;
+  if (options.rootpath != NULL)
+    delete [] options.rootpath;
+  for (i = options.includePaths.begin(); i != options.includePaths.end();
+       i++)
+    delete [] *i;
+  if (options.cache != NULL)
+    delete options.cache;
+}
+
+/**
+ * Parse the arguments and do what they ask for. <code>served</code> is
+ * set for the requests that a daemon serves, which can't start another
+ * daemon or connect to one.
+ *
+ * @return the exit status.
+ */
+int run(int argc, char* argv[], bool served) {
+  string output = "-";
+  CompileOptions options;
+  bool batch = false, watch = false, cache_stats = false,
+    output_set = false;
+  const char* cache_dir = NULL;
+  const char* stats = NULL;
+  // 100MB
+  unsigned long long cache_size = 100ULL << 20;
+  const char* daemon = NULL;
+  const char* connect = NULL;
+  std::vector<char*> connect_args;
+  std::vector<std::pair<std::string, std::string> > jobs;
+  int i, status = -1;
+  // by default the main thread parses and the other cores read
+  // imports, or compile stylesheets in batch mode.
+  unsigned int threads = std::thread::hardware_concurrency();
 
   static struct option long_options[] = {
     {"version",    no_argument,       0, 1},
@@ -206,14 +1433,27 @@ int main(int argc, char * argv[]){
     {"source-map-basepath", required_argument, 0, 3},
     {"include-path", required_argument,        0, 'I'},
     {"rootpath", required_argument,  0, 4},
+    {"fast-exit", no_argument,       0, 5},
+    {"batch",      no_argument,       0, 'b'},
+    {"manifest",   required_argument, 0, 6},
+    {"jobs",       required_argument, 0, 'j'},
+    {"daemon",     required_argument, 0, 7},
+    {"connect",    required_argument, 0, 8},
+    {"modify-var", required_argument, 0, 9},
+    {"watch",      no_argument,       0, 10},
+    {"cache-dir",  required_argument, 0, 11},
+    {"cache-size", required_argument, 0, 12},
+    {"cache-stats", no_argument,      0, 13},
+    {"stats",      optional_argument, 0, 14},
     {0,0,0,0}
   };
-  
-#ifdef WITH_LIBGLOG
-  FLAGS_logtostderr = 1;
-  google::InitGoogleLogging(argv[0]);
-  VLOG(1) << "Start.";
-#endif
+
+  options.formatoutput = false;
+  options.sourcemap_rootpath = NULL;
+  options.sourcemap_basepath = NULL;
+  options.rootpath = NULL;
+  options.fastexit = false;
+  options.cache = NULL;
   
   try {
     int c, option_index;
@@ -221,22 +1461,33 @@ int main(int argc, char * argv[]){
     VLOG(3) << "argc: " << argc;
 #endif
 
-    while((c = getopt_long(argc, argv, ":o:hfv:m::I:", long_options, &option_index)) != -1) {
+    // a daemon parses the arguments of every request; 0 makes getopt
+    // start over.
+    optind = 0;
+    
+    while(status < 0 &&
+          (c = getopt_long(argc, argv, ":o:hfv:m::I:bj:", long_options, &option_index)) != -1) {
       switch (c) {
       case 1:
         version();
-        return 0;
+        status = 0;
+        break;
       case 'h':
         usage();
-        return 0;
+        status = 0;
+        break;
       case 'o':
         output = optarg;
-        out = new ofstream(optarg);
+        output_set = true;
         break;
       case 'f':
-        formatoutput = true;
+        options.formatoutput = true;
         break;
       case 'v':
+        // the verbosity is global, so it would outlast the request
+        if (served)
+          throw new IOException("verbose option can't be used by the \
+daemon.");
 #ifdef WITH_LIBGLOG
         FLAGS_v = atoi(optarg);
 #else
@@ -245,108 +1496,190 @@ int main(int argc, char * argv[]){
         break;
       case 'm':
         if (optarg)
-          sourcemap_file = optarg;
+          options.sourcemap_file = optarg;
         else
-          sourcemap_file = "-";
+          options.sourcemap_file = "-";
         break;
         
       case 2:
-        sourcemap_rootpath = createPath(optarg, std::strlen(optarg));
+        options.sourcemap_rootpath = createPath(optarg, std::strlen(optarg));
         break;
       case 3:
-        sourcemap_basepath = createPath(optarg, std::strlen(optarg));
+        options.sourcemap_basepath = createPath(optarg, std::strlen(optarg));
         break;
 
       case 'I':
-        parsePathList(optarg, includePaths);
+        parsePathList(optarg, options.includePaths);
         break;
 
       case 4:
-        rootpath = createPath(optarg, std::strlen(optarg));
+        options.rootpath = createPath(optarg, std::strlen(optarg));
+        break;
+
+      case 5:
+        options.fastexit = true;
+        break;
+
+      case 'b':
+        batch = true;
+        break;
+      case 6:
+        batch = true;
+        parseManifest(optarg, jobs);
+        break;
+      case 'j':
+        threads = atoi(optarg);
         break;
 
+      case 7:
+        daemon = optarg;
+        break;
+      case 8:
+        connect = optarg;
+        // getopt reorders argv, so remember the arguments themselves
+        if (optarg == argv[optind - 1])
+          connect_args.push_back(argv[optind - 2]);
+        connect_args.push_back(argv[optind - 1]);
+        break;
+      case 9:
+        options.variables.push_back(parseVariable(optarg));
+        break;
+      case 10:
+        watch = true;
+        break;
+      case 11:
+        cache_dir = optarg;
+        break;
+      case 12:
+        cache_size = parseSize(optarg);
+        break;
+      case 13:
+        cache_stats = true;
+        break;
+      case 14:
+        if (optarg == NULL || std::strcmp(optarg, "text") == 0)
+          stats = "text";
+        else if (std::strcmp(optarg, "json") == 0)
+          stats = "json";
+        else
+          throw new IOException("stats option requires text or json.");
+        break;
       }
     }
-    
-    if(argc - optind >= 1){
-#ifdef WITH_LIBGLOG
-      VLOG(1) << argv[optind];
-#endif
-      
-      source = new char[std::strlen(argv[optind]) + 1];
-      std::strcpy(source, argv[optind]);
-      
-      in = new ifstream(source);
-      if (in->fail() || in->bad())
-        throw new IOException("Error opening file");
 
-    } else if (sourcemap_file == "-") {
-      throw new IOException("source-map option requires that \
-a file name is specified for either the source map or the less \
-source.");
-    } else {
-      source = new char[2];
-      std::strcpy(source, "-");
+    if (status < 0 && cache_dir != NULL)
+      options.cache = new CompilationCache(cache_dir, cache_size);
+
+    if (status < 0 && cache_stats) {
+      if (options.cache == NULL)
+        throw new IOException("cache-stats option requires cache-dir.");
+      printCacheStats(*options.cache);
+      status = 0;
     }
-    
-    if (sourcemap_file == "-") {
-      sourcemap_file = source;
-      sourcemap_file += ".map";
+
+    if (status < 0 && (daemon != NULL || connect != NULL)) {
+      if (served)
+        throw new IOException("daemon and connect options can't be used \
+by the daemon.");
+      // a client passes --daemon on, and the daemon rejects it
+      if (connect != NULL)
+        status = runClient(connect, argc, argv,
+                           !batch && argc - optind < 1,
+                           connect_args);
+      else
+        status = runDaemon(daemon);
     }
 
-    sources.push_back(source);
-    
-    if (parseInput(stylesheet, *in, source, sources, includePaths)) {
-      if (sourcemap_file != "") {
-#ifdef WITH_LIBGLOG
-        VLOG(1) << "sourcemap: " << sourcemap_file;
+    if (status < 0 && batch) {
+      // the outputs of a batch are named by its jobs
+      if (output_set)
+        throw new IOException("output option can't be used in batch \
+mode; use INPUT:OUTPUT instead.");
+      if (jobs.empty() && argc - optind < 1)
+        throw new IOException("batch mode requires at least one \
+stylesheet.");
+    }
+
+    if (status < 0 && watch) {
+      if (served || batch)
+        throw new IOException("watch option can't be used in batch mode \
+or by the daemon.");
+#ifdef HAVE_SYS_INOTIFY_H
+      options.importThreads = threads > 1 ? threads - 1 : 0;
+      options.fastexit = false;
+      status = runWatch(argc - optind >= 1 ? argv[optind] : "-",
+                        output.c_str(), options);
+#else
+      throw new IOException("watch option is not supported on this \
+system.");
 #endif
-        sourcemap_s = new ofstream(sourcemap_file.c_str());
-        sourcemap = new SourceMapWriter(*sourcemap_s, sources, output.c_str(),
-                                        sourcemap_rootpath,
-                                        sourcemap_basepath);
-
-        writer = formatoutput ? new CssPrettyWriter(*out, *sourcemap) :
-          new CssWriter(*out, *sourcemap);
-      } else {
-        writer = formatoutput ? new CssPrettyWriter(*out) :
-          new CssWriter(*out);
-      }
-      writer->rootpath = rootpath;
-      
-      writeOutput(stylesheet, *writer);
-      
-      if (sourcemap != NULL) {
-        if (sourcemap_basepath != NULL &&
-            sourcemap_file.compare(0, std::strlen(sourcemap_basepath),
-                                   sourcemap_basepath) == 0) {
-          sourcemap_file.erase(0, std::strlen(sourcemap_basepath));
-        }
-        if (sourcemap_rootpath != NULL)
-          sourcemap_file.insert(0, sourcemap_rootpath);
-        
-        writer->writeSourceMapUrl(sourcemap_file.c_str());
-        sourcemap->close();
-        delete sourcemap;
-        if (sourcemap_s != NULL)
-          delete sourcemap_s;
-      }
-      
-      delete writer;
-      *out << endl;
-    } else
-      return 1;
-    delete source;
-    
+    }
   } catch (IOException* e) {
 #ifdef WITH_LIBGLOG
     LOG(ERROR) << " Error: " << e->what();
 #else
     cerr << " Error: " << e->what();
 #endif
-    return 1;
+    status = 1;
   }
-		
-  return 0;
+
+  if (status >= 0) {
+    freeOptions(options);
+    return status;
+  }
+  
+  if (threads < 1)
+    threads = 1;
+
+  // the daemon has to stay up after the request, and the statistics
+  // are written after the compilation.
+  if (served || stats != NULL)
+    options.fastexit = false;
+
+  if (stats != NULL)
+    Statistics::setEnabled(true);
+
+  if (batch) {
+    for (i = optind; i < argc; i++)
+      parseJob(argv[i], jobs);
+
+    // every job writes its source map next to its source, and there
+    // is no point in leaving early after the first job.
+    if (options.sourcemap_file != "")
+      options.sourcemap_file = "-";
+    options.fastexit = false;
+    options.importThreads = 0;
+    
+    status = compileBatch(jobs, options, threads) > 0 ? 1 : 0;
+  } else {
+    options.importThreads = threads - 1;
+  
+#ifdef WITH_LIBGLOG
+    if (argc - optind >= 1)
+      VLOG(1) << argv[optind];
+#endif
+    status = compile(argc - optind >= 1 ? argv[optind] : "-",
+                     output.c_str(), options) ? 0 : 1;
+  }
+
+  if (stats != NULL) {
+    Statistics::setEnabled(false);
+    if (std::strcmp(stats, "json") == 0)
+      Statistics::getInstance().writeJson(cerr);
+    else
+      Statistics::getInstance().write(cerr);
+  }
+  
+  freeOptions(options);
+  return status;
 }
 
+int main(int argc, char * argv[]){
+#ifdef WITH_LIBGLOG
+  FLAGS_logtostderr = 1;
+  google::InitGoogleLogging(argv[0]);
+  VLOG(1) << "Start.";
+#endif
+
+  return run(argc, argv, false);
+}
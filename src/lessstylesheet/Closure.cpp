@@ -67,11 +67,11 @@ LessSelector* Closure::getLessSelector() const {
 }
 
 
-const TokenList* Closure::getVariable(const std::string &key) const {
+const TokenList* Closure::getVariable(Symbol key) const {
   return ruleset->getVariable(key);
 }
 
-const TokenList* Closure::getInheritedVariable(const std::string &key,
+const TokenList* Closure::getInheritedVariable(Symbol key,
                                                const MixinCall &stack) const {
   const TokenList* t;
   
@@ -6,6 +6,7 @@
 #include "LessRuleset.h"
 #include "Mixin.h"
 #include "../stylesheet/Ruleset.h"
+#include <list>
 
 class ProcessingContext;
 class MixinCall;
@@ -31,9 +32,9 @@ public:
   
   virtual LessSelector* getLessSelector() const;
 
-  virtual const TokenList* getVariable(const std::string &key) const;
-  virtual const TokenList* getInheritedVariable(const std::string
-  &key, const MixinCall &stack) const;
+  virtual const TokenList* getVariable(Symbol key) const;
+  virtual const TokenList* getInheritedVariable(Symbol key, const
+                                                MixinCall &stack) const;
 
   bool isInStack(const LessRuleset &ruleset);
 
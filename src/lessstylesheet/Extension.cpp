@@ -20,6 +20,9 @@ Extension::~Extension() {
 Selector& Extension::getTarget() {
   return target;
 }
+const Selector& Extension::getTarget() const {
+  return target;
+}
 Selector& Extension::getExtension() {
   return extension;
 }
@@ -44,37 +47,37 @@ void Extension::updateSelector(Selector &s) const {
 }
 void Extension::replaceInSelector(Selector &s) const {
   Selector t = target;
-  Selector::const_iterator end, pos, first, last;
+  size_t first, last, pos, matchEnd, i;
   t.pop_back();
   t.rtrim();
 
-  end = s.end();
-
-  for (first = s.begin(); first != end;) {
-    last = s.findComma(first, end);
-    pos = s.find(t, first, last);
+  // Tokens are appended to s while it is scanned, so positions are
+  // kept as offsets. The appended selectors are scanned as well.
+  for (first = 0; first < s.size();) {
+    last = s.findComma(s.cbegin() + first, s.cend()) - s.cbegin();
+    pos = s.find(t, s.cbegin() + first, s.cbegin() + last) - s.cbegin();
 
     if (pos != last) {
 #ifdef WITH_LIBGLOG
       VLOG(2) << "Extending " << s.toString() << " with " << extension.toString() ;
 #endif
-      
+      matchEnd = s.walk(t, s.cbegin() + pos) - s.cbegin();
+
+      // reserve the space up front so the tokens that are copied
+      // from s are not moved while they are read
+      s.reserve(s.size() + 1 + (pos - first) + extension.size() +
+                (last - matchEnd));
       s.push_back(Token::BUILTIN_COMMA);
 
-      // fix position of <code>last</code>. If <code>last ==
-      // end</code> it moves up as tokens are inserted, and we want it
-      // to stay where it is.
-      if (last == end)
-        last--;
-      
-      s.insert(s.end(), first, pos);
+      for (i = first; i < pos; i++)
+        s.push_back(s[i]);
       s.insert(s.end(), extension.begin(), extension.end());
-      pos = s.walk(t, pos);
-      s.insert(s.end(), pos, last);
+      for (i = matchEnd; i < last; i++)
+        s.push_back(s[i]);
     }
     
     first = last;
-    if (first != end)
+    if (first < s.size())
       first++;
   }
 }
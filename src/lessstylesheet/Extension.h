@@ -19,6 +19,7 @@ public:
   virtual ~Extension();
 
   Selector& getTarget();
+  const Selector& getTarget() const;
   Selector& getExtension();
 
   void setExtension(Selector &selector);
@@ -0,0 +1,161 @@
+#include "ExtensionIndex.h"
+
+ExtensionIndex::ExtensionIndex() {
+  matcherBuilt = false;
+}
+
+ExtensionIndex::Key ExtensionIndex::getKey(const Token &token) {
+  return ((Key)token.type << 32) | token.getSymbol();
+}
+
+ExtensionIndex::Key ExtensionIndex::getClassKey(const Token &name) {
+  return (1ULL << 63) | name.getSymbol();
+}
+
+ExtensionIndex::Key ExtensionIndex::getKey(TokenList::const_iterator first,
+                                           TokenList::const_iterator last) {
+  TokenList::const_iterator next = first + 1;
+  
+  if (*first == "." && next != last && (*next).type == Token::IDENTIFIER)
+    return getClassKey(*next);
+  return getKey(*first);
+}
+
+void ExtensionIndex::addCandidates(Key key,
+                                   std::set<size_t> &candidates) const {
+  std::unordered_map<Key, std::vector<size_t> >::const_iterator b_it;
+
+  b_it = buckets.find(key);
+  if (b_it != buckets.end())
+    candidates.insert(b_it->second.begin(), b_it->second.end());
+}
+
+void ExtensionIndex::getKeys(TokenList::const_iterator first,
+                             TokenList::const_iterator last,
+                             std::vector<Key> &keys) {
+  for (; first != last; first++) {
+    if ((*first).type != Token::WHITESPACE && *first != ">")
+      keys.push_back(getKey(*first));
+  }
+}
+
+void ExtensionIndex::add(const Extension &extension) {
+  const Selector& target = extension.getTarget();
+  TokenList::const_iterator first, last;
+  std::vector<Key> keys;
+  std::vector<Key>::iterator k_it;
+  std::vector<size_t>* bucket;
+  size_t n = extensions.size();
+
+  extensions.push_back(&extension);
+
+  if (target.empty()) {
+    wildcards.push_back(n);
+    return;
+  }
+  
+  if (target.back() == "all") {
+    getKeys(target.begin(), target.end() - 1, keys);
+    if (keys.empty())
+      wildcards.push_back(n);
+    else
+      matcher.add(keys, n);
+    return;
+  }
+
+  // Split the target the same way Selector::match() does.
+  for (first = target.begin(); first != target.end(); ) {
+    last = target.findComma(first);
+
+    // an empty part matches empty parts
+    if (first == last) {
+      wildcards.push_back(n);
+      return;
+    }
+    keys.push_back(getKey(first, last));
+
+    first = last;
+    if (first != target.end()) {
+      first++;
+      while (first != target.end() && (*first).type == Token::WHITESPACE)
+        first++;
+    }
+  }
+
+  for (k_it = keys.begin(); k_it != keys.end(); k_it++) {
+    bucket = &buckets[*k_it];
+    if (bucket->empty() || bucket->back() != n)
+      bucket->push_back(n);
+  }
+}
+
+bool ExtensionIndex::getCandidates(const Selector &s,
+                                   std::set<size_t> &candidates) const {
+  TokenList::const_iterator first, last, next;
+  std::vector<Key> keys;
+
+  for (first = s.begin(); first != s.end(); ) {
+    last = s.findComma(first);
+
+    if (first == last)
+      return false;
+
+    addCandidates(getKey(*first), candidates);
+
+    // Selector::walk() compares the token after the '.' with the class
+    // name, skipping a '>' in between.
+    if (*first == ".") {
+      next = first + 1;
+      if (next != s.end() && *next == ">") {
+        next++;
+        if (next != s.end() && (*next).type == Token::WHITESPACE)
+          next++;
+      }
+      if (next != s.end())
+        addCandidates(getClassKey(*next), candidates);
+    }
+
+    first = last;
+    if (first != s.end()) {
+      first++;
+      while (first != s.end() && (*first).type == Token::WHITESPACE)
+        first++;
+    }
+  }
+
+  if (!matcher.empty()) {
+    getKeys(s.begin(), s.end(), keys);
+    matcher.find(keys, candidates);
+  }
+  return true;
+}
+
+void ExtensionIndex::updateSelector(Selector &s) {
+  std::set<size_t> candidates(wildcards.begin(), wildcards.end());
+  std::set<size_t>::iterator it;
+  size_t next = 0, size, i;
+
+  if (!matcherBuilt) {
+    matcher.build();
+    matcherBuilt = true;
+  }
+
+  if (getCandidates(s, candidates)) {
+    while ((it = candidates.lower_bound(next)) != candidates.end()) {
+      next = *it + 1;
+      size = s.size();
+
+      extensions[*it]->updateSelector(s);
+
+      // the selectors added by the extension can match later
+      // extensions.
+      if (s.size() != size && !getCandidates(s, candidates))
+        break;
+    }
+    if (it == candidates.end())
+      return;
+  }
+
+  for (i = next; i < extensions.size(); i++)
+    extensions[i]->updateSelector(s);
+}
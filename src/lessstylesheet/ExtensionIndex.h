@@ -0,0 +1,82 @@
+#ifndef __ExtensionIndex_h__
+#define __ExtensionIndex_h__
+
+#include "../stylesheet/Selector.h"
+#include "Extension.h"
+#include "TokenMatcher.h"
+
+#include <vector>
+#include <set>
+#include <unordered_map>
+
+/**
+ * Index of the extensions that are applied to the output selectors.
+ *
+ * A selector only matches the target of an extension if one of its
+ * comma separated parts starts with the same tokens as one of the
+ * parts of the target, so the extensions are filed under the first
+ * token of each part of their target, or the class name if the part
+ * starts with a class.
+ *
+ * Extensions with <code>all</code> can match anywhere in a selector.
+ * Their targets are added to a TokenMatcher, which finds all the
+ * targets that occur in a selector in one scan. Selector::walk() skips
+ * the '>' combinators, so the tokens are compared without the '>' and
+ * whitespace tokens.
+ *
+ * updateSelector() only applies the extensions that can match the
+ * selector, in the order they were added, which gives the same result
+ * as applying every extension.
+ */
+class ExtensionIndex {
+private:
+  typedef TokenMatcher::Key Key;
+
+  std::vector<const Extension*> extensions;
+  std::unordered_map<Key, std::vector<size_t> > buckets;
+  std::vector<size_t> wildcards;
+  TokenMatcher matcher;
+  bool matcherBuilt;
+
+  static Key getKey(const Token &token);
+  /**
+   * The key of a class: a '.' followed by <code>name</code>.
+   */
+  static Key getClassKey(const Token &name);
+  /**
+   * The key a part of a target is filed under.
+   */
+  static Key getKey(TokenList::const_iterator first,
+                    TokenList::const_iterator last);
+  void addCandidates(Key key, std::set<size_t> &candidates) const;
+  /**
+   * Get the keys of the tokens from <code>first</code> to
+   * <code>last</code>, leaving out the '>' and whitespace tokens.
+   */
+  static void getKeys(TokenList::const_iterator first,
+                      TokenList::const_iterator last,
+                      std::vector<Key> &keys);
+
+  /**
+   * Add the extensions filed under the parts of <code>s</code> to
+   * <code>candidates</code>.
+   *
+   * @return false if the selector has an empty part, which the index
+   *         can't narrow down.
+   */
+  bool getCandidates(const Selector &s,
+                     std::set<size_t> &candidates) const;
+
+public:
+  ExtensionIndex();
+  
+  void add(const Extension &extension);
+
+  /**
+   * Apply the extensions to <code>s</code> in the order they were
+   * added. Extensions can't be added after this is called.
+   */
+  void updateSelector(Selector &s);
+};
+
+#endif
@@ -27,9 +27,9 @@ public:
   virtual void getLocalFunctions(std::list<const Function*> &functionList,
                                  const Mixin &mixin) const = 0;
 
-  virtual const TokenList* getVariable(const std::string &key) const = 0;
-  virtual const TokenList* getInheritedVariable(const std::string
-  &key, const MixinCall &stack) const
+  virtual const TokenList* getVariable(Symbol key) const = 0;
+  virtual const TokenList* getInheritedVariable(Symbol key, const
+                                                MixinCall &stack) const
   = 0;
 
   void saveReturnValues(ProcessingContext &context);
@@ -26,7 +26,7 @@ void LessMediaQuery::getFunctions(std::list<const Function*> &functionList,
   getLessStylesheet()->getFunctions(functionList, mixin);
 }
 
-const TokenList* LessMediaQuery::getVariable(const std::string &key) const {
+const TokenList* LessMediaQuery::getVariable(Symbol key) const {
   const TokenList* t = LessStylesheet::getVariable(key);
   if (t == NULL)
     t = getLessStylesheet()->getVariable(key);
@@ -32,7 +32,7 @@ public:
 
   virtual void getFunctions(std::list<const Function*> &functionList,
                             const Mixin &mixin) const;
-  virtual const TokenList* getVariable(const std::string &key) const;
+  virtual const TokenList* getVariable(Symbol key) const;
   
   virtual ProcessingContext* getContext();
   virtual void process(Stylesheet &s);
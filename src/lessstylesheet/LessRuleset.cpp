@@ -12,11 +12,15 @@
 LessRuleset::LessRuleset() : Ruleset() {
   parent = NULL;
   lessStylesheet = NULL;
+  extends = false;
+  mixinCallsParsed = false;
   selector = NULL;
 }
 LessRuleset::LessRuleset(const Selector &selector) : Ruleset() {
   parent = NULL;
   lessStylesheet = NULL;
+  extends = false;
+  mixinCallsParsed = false;
   setSelector(selector);
 }
 LessRuleset::~LessRuleset() {
@@ -43,6 +47,7 @@ UnprocessedStatement* LessRuleset::createUnprocessedStatement() {
   Ruleset::addStatement(*s);
   s->setLessRuleset(*this);
   unprocessedStatements.push_back(s);
+  mixinCallsParsed = false;
   return s;
 }
 
@@ -86,13 +91,14 @@ void LessRuleset::deleteUnprocessedStatement(UnprocessedStatement
                                              &statement) {
   unprocessedStatements.remove(&statement);
   deleteStatement(statement);
+  mixinCallsParsed = false;
 }
 
 const std::list<LessRuleset*>& LessRuleset::getNestedRules() const {
   return nestedRules;
 }
 
-void LessRuleset::putVariable(const std::string &key, const TokenList &value) {
+void LessRuleset::putVariable(Symbol key, const TokenList &value) {
   variables[key] = value;  
 }
 
@@ -100,10 +106,10 @@ VariableMap& LessRuleset::getVariables() {
   return variables;
 }
 
-const TokenList* LessRuleset::getVariable(const std::string &key) const {
+const TokenList* LessRuleset::getVariable(Symbol key) const {
   return variables.getVariable(key);
 }
-const TokenList* LessRuleset::getInheritedVariable (const std::string &key,
+const TokenList* LessRuleset::getInheritedVariable (Symbol key,
                                                     const MixinCall &stack) const {
   
   const TokenList* t;
@@ -169,11 +175,34 @@ void LessRuleset::processExtensions(ProcessingContext& context,
 bool LessRuleset::call(Mixin &mixin, Ruleset &target,
                          ProcessingContext &context) const {
   bool ret = false;
+  const MixinExpansion* expansion;
+  size_t statementCount, declarationCount;
 
   if (putArguments(mixin, *context.getStackArguments()) &&
       matchConditions(context)) {
 
-    processStatements(target, context);
+    // Only leaf mixins, which add nothing but declarations to the
+    // target, are cached. Nested rules and mixin calls also add
+    // rulesets to the stylesheet and closures and extensions to the
+    // context, which an expansion does not record.
+    if (!nestedRules.empty() || callsMixins(context)) {
+      processCall(*target.getStylesheet(), &target, context);
+      
+    } else if ((expansion = context.getExpansion(*this)) != NULL) {
+#ifdef WITH_LIBGLOG
+      VLOG(2) << "Reusing expansion of " << getSelector().toString();
+#endif
+      expansion->insert(target);
+      
+    } else if (context.startExpansion(*this)) {
+      statementCount = target.getStatements().size();
+      declarationCount = target.getDeclarations().size();
+      
+      processStatements(target, context);
+      context.endExpansion(*this, target, statementCount,
+                           declarationCount);
+    } else
+      processStatements(target, context);
 
     addClosures(context);
     // process variables and add to context.variables
@@ -191,7 +220,7 @@ bool LessRuleset::call(Mixin &mixin, Stylesheet &target,
   if (putArguments(mixin, *context.getStackArguments()) &&
       matchConditions(context)) {
 
-    processStatements(target, context);
+    processCall(target, NULL, context);
 
     addClosures(context);
     // process variables and add to context.variables
@@ -279,6 +308,144 @@ void LessRuleset::processStatements(Stylesheet &target,
   insertNestedRules(target, NULL, context);
 }
 
+void LessRuleset::processCall(Stylesheet &s, Ruleset* target,
+                              ProcessingContext &context) const {
+  unsigned int depth = 0;
+  Mixin caller;
+
+  caller.setLessStylesheet(*getLessStylesheet());
+
+  while (processIteration(s, target, context))
+    depth++;
+
+  // insert the nested rules of the innermost call first, like the
+  // recursive calls would.
+  while (true) {
+    if (target != NULL)
+      insertNestedRules(s, &target->getSelector(), context);
+    else
+      insertNestedRules(s, NULL, context);
+    
+    if (depth == 0)
+      return;
+
+    addClosures(context);
+    context.addVariables(variables);
+    caller.endCall(context, unprocessedStatements.back()->getLessRuleset());
+    depth--;
+  }
+}
+
+bool LessRuleset::processIteration(Stylesheet &s, Ruleset* target,
+                                   ProcessingContext &context) const {
+  const list<RulesetStatement*>& statements = getStatements();
+  list<RulesetStatement*>::const_iterator it;
+  list<UnprocessedStatement*>::const_iterator up_it;
+  UnprocessedStatement* last = NULL;
+  Mixin mixin;
+
+  // only the final statement can be a tail call
+  if (!unprocessedStatements.empty() &&
+      (target == NULL || statements.back() == unprocessedStatements.back()))
+    last = unprocessedStatements.back();
+
+  if (target != NULL) {
+    for (it = statements.begin(); it != statements.end(); it++) {
+      if (*it != last)
+        (*it)->process(*target);
+    }
+  } else {
+    for (up_it = unprocessedStatements.begin();
+         up_it != unprocessedStatements.end();
+         up_it++) {
+      if (*up_it != last)
+        (*up_it)->process(s);
+    }
+  }
+
+  if (last == NULL)
+    return false;
+  
+  if (!isTailCall(*last, mixin, context)) {
+    if (target != NULL)
+      last->process(*target);
+    else
+      last->process(s);
+    return false;
+  }
+
+#ifdef WITH_LIBGLOG
+  VLOG(2) << "Tail call: " << mixin.name.toString();
+#endif
+
+  mixin.processArguments(context);
+  mixin.beginCall(*this, context);
+
+  if (putArguments(mixin, *context.getStackArguments()) &&
+      matchConditions(context))
+    return true;
+
+  mixin.endCall(context, last->getLessRuleset());
+  return false;
+}
+
+bool LessRuleset::isTailCall(UnprocessedStatement &statement, Mixin &mixin,
+                             ProcessingContext &context) const {
+  list<const Function*> functionList;
+
+  if (!selector->needsArguments() ||
+      statement.getTokens()->front().type == Token::ATKEYWORD ||
+      statement.isExtends())
+    return false;
+
+  mixin.setLessStylesheet(*getLessStylesheet());
+  mixin.parse(*statement.getTokens());
+  context.getFunctions(functionList, mixin);
+  
+  return (functionList.size() == 1 && functionList.front() == this);
+}
+
+bool LessRuleset::callsMixins(ProcessingContext &context) const {
+  list<Mixin>::const_iterator it;
+  list<const Function*> functionList;
+
+  if (!mixinCallsParsed)
+    parseMixinCalls();
+
+  if (extends)
+    return true;
+
+  for (it = mixinCalls.cbegin(); it != mixinCalls.cend(); it++) {
+    context.getFunctions(functionList, *it);
+    if (!functionList.empty())
+      return true;
+  }
+  return false;
+}
+
+void LessRuleset::parseMixinCalls() const {
+  list<UnprocessedStatement*>::const_iterator it;
+
+  mixinCalls.clear();
+  extends = false;
+  
+  for (it = unprocessedStatements.cbegin();
+       it != unprocessedStatements.cend();
+       it++) {
+    if ((*it)->getTokens()->front().type == Token::ATKEYWORD)
+      continue;
+    
+    if ((*it)->isExtends()) {
+      extends = true;
+      break;
+    }
+
+    mixinCalls.push_back(Mixin());
+    mixinCalls.back().parse(*(*it)->getTokens());
+  }
+  mixinCallsParsed = true;
+}
+
 void LessRuleset::saveReturnValues(ProcessingContext &context) {
   // move closures from context to this->closures
   context.saveClosures(this->closures);
@@ -430,7 +597,8 @@ bool LessRuleset::putArguments(const Mixin &mixin,
     if (variable == NULL || variable->empty()) 
       return false;
     
-    scope.insert(pair<std::string, TokenList>(*pit, *variable));
+    scope.insert(pair<Symbol, TokenList>(SymbolTable::intern(*pit),
+                                        *variable));
 
     argsCombined.insert(argsCombined.end(),
                         variable->begin(), variable->end());
@@ -454,9 +622,12 @@ bool LessRuleset::putArguments(const Mixin &mixin,
     }
     
     restVar.trim();
-    scope.insert(pair<std::string,TokenList>(selector->getRestIdentifier(), restVar));
+    scope.insert(pair<Symbol, TokenList>
+                 (SymbolTable::intern(selector->getRestIdentifier()),
+                  restVar));
   }
   
-  scope.insert(pair<std::string,TokenList>("@arguments", argsCombined));
+  scope.insert(pair<Symbol, TokenList>(SymbolTable::intern("@arguments"),
+                                      argsCombined));
   return true;
 }
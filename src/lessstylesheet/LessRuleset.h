@@ -27,7 +27,7 @@ class LessStylesheet;
 class MediaQueryRuleset;
 class Closure;
 
-class LessRuleset: public Ruleset, Function {
+class LessRuleset: public Ruleset, public Function {
   
 protected:
   VariableMap variables;  
@@ -42,11 +42,56 @@ protected:
 
   ProcessingContext* context;
 
+  /**
+   * The statements that may call a mixin, parsed once by
+   * parseMixinCalls() so callsMixins() only has to look them up.
+   */
+  mutable std::list<Mixin> mixinCalls;
+  mutable bool extends;
+  mutable bool mixinCallsParsed;
+
   void processVariables();
   void insertNestedRules(Stylesheet &s, Selector* prefix,
                          ProcessingContext &context) const;
 
   void addClosures(ProcessingContext &context) const;
+
+  /**
+   * Returns true if a statement would call a mixin or extend a
+   * selector when the ruleset is processed in <code>context</code>.
+   * Only rulesets that don't can reuse a saved expansion.
+   */
+  bool callsMixins(ProcessingContext &context) const;
+  void parseMixinCalls() const;
+
+  /**
+   * Process the statements and nested rules of a call.
+   *
+   * Loops call the same ruleset again in their last statement. Such a
+   * tail call is not made recursively; the arguments are put in a new
+   * MixinCall and the statements are processed again by
+   * processIteration(), so the depth of a loop doesn't grow the C++
+   * stack. The nested rules of each iteration are inserted after the
+   * loop is done, in the order the recursive calls would have
+   * inserted them. Statements are added to <code>target</code>, or to
+   * <code>s</code> if <code>target</code> is NULL.
+   */
+  void processCall(Stylesheet &s, Ruleset* target,
+                   ProcessingContext &context) const;
+  /**
+   * Process the statements of one iteration.
+   *
+   * @return true if the last statement called this ruleset again and
+   *         the call matched. The call is then on top of the stack.
+   */
+  bool processIteration(Stylesheet &s, Ruleset* target,
+                        ProcessingContext &context) const;
+  /**
+   * Returns true if <code>statement</code> calls this ruleset and no
+   * other function. The call is parsed into <code>mixin</code>.
+   */
+  bool isTailCall(UnprocessedStatement &statement, Mixin &mixin,
+                  ProcessingContext &context) const;
   
 public:
   LessRuleset();
@@ -67,11 +112,11 @@ public:
   const list<UnprocessedStatement*>& getUnprocessedStatements() const;
   const list<LessRuleset*>& getNestedRules() const;
 
-  void putVariable(const std::string &key, const TokenList &value);
+  void putVariable(Symbol key, const TokenList &value);
   VariableMap& getVariables();
 
-  const TokenList* getVariable(const std::string &key) const;
-  const TokenList* getInheritedVariable(const std::string &key,
+  const TokenList* getVariable(Symbol key) const;
+  const TokenList* getInheritedVariable(Symbol key,
                                         const MixinCall &stack) const;
 
   const list<Closure*>& getClosures() const;
@@ -8,9 +8,9 @@
 #endif
 
 LessSelector::LessSelector(const Selector &original) {
-  list<Selector> parts;
-  list<Selector>::iterator it;
-  Selector* old_selector;
+  std::list<Selector> parts;
+  std::list<Selector>::iterator it;
+  TokenList::const_iterator i, part_end;
   Selector new_selector;
 
   original.split(parts);
@@ -21,30 +21,32 @@ LessSelector::LessSelector(const Selector &original) {
 #ifdef WITH_LIBGLOG
   VLOG(2) << "Parsing less selector";
 #endif
-  
+
+  // the parts are read from front to back and then discarded
   for (it = parts.begin(); it != parts.end(); it++) {
-    old_selector = &(*it);
+    i = (*it).begin();
+    part_end = (*it).end();
     
-    while(!old_selector->empty()) {
+    while(i != part_end) {
       
-      if (parseExtension(*old_selector, new_selector)) {
+      if (parseExtension(i, part_end, new_selector)) {
         
       } else if (parts.size() == 1 &&
                  !new_selector.empty()) {
 
         if ((new_selector.front().type == Token::HASH ||
              new_selector.front() == ".") &&
-            parseArguments(*old_selector)) {
+            parseArguments(i, part_end)) {
           _needsArguments = true;
-          old_selector->ltrim();
+          skipWhitespace(i, part_end);
           
-        } else if (!parseConditions(*old_selector)) {
-          new_selector.push_back(old_selector->front());
-          old_selector->pop_front();
+        } else if (!parseConditions(i, part_end)) {
+          new_selector.push_back(*i);
+          i++;
         }
       } else {
-        new_selector.push_back(old_selector->front());
-        old_selector->pop_front();
+        new_selector.push_back(*i);
+        i++;
       }
       
     }
@@ -64,38 +66,43 @@ LessSelector::LessSelector(const Selector &original) {
 LessSelector::~LessSelector() {
 }
 
-bool LessSelector::parseExtension(Selector &selector, Selector &extension) {
+void LessSelector::skipWhitespace(TokenList::const_iterator &i,
+                                  const TokenList::const_iterator &end) {
+  while (i != end && (*i).type == Token::WHITESPACE)
+    i++;
+}
+
+bool LessSelector::parseExtension(TokenList::const_iterator &i,
+                                  const TokenList::const_iterator &end,
+                                  Selector &extension) {
   int parentheses = 1;
-  TokenList::iterator i;
+  TokenList::const_iterator j = i;
   Extension e;
 
-  i = selector.begin();
-
   // ":", "extend", "("
-  if (selector.size() < 3 ||
-      (*i).type != Token::COLON ||
-      (*++i).type != Token::IDENTIFIER ||
-      (*i) != "extend" ||
-      (*++i).type != Token::PAREN_OPEN)
+  if (j == end || (*j).type != Token::COLON ||
+      ++j == end || (*j).type != Token::IDENTIFIER ||
+      (*j) != "extend" ||
+      ++j == end || (*j).type != Token::PAREN_OPEN)
     return false;
 
-  i++;
+  j++;
  
-  for(; i != selector.end() && parentheses > 0; i++) {
-    if ((*i).type == Token::PAREN_OPEN) 
+  for(; j != end && parentheses > 0; j++) {
+    if ((*j).type == Token::PAREN_OPEN) 
       parentheses++;
-    else if ((*i).type == Token::PAREN_CLOSED)
+    else if ((*j).type == Token::PAREN_CLOSED)
       parentheses--;
     
     if (parentheses > 0) {
-      e.getTarget().push_back(*i);
+      e.getTarget().push_back(*j);
     }
   }
   
   e.setExtension(extension);
   extensions.push_back(e);
 
-  selector.erase(selector.begin(), i);
+  i = j;
   
 #ifdef WITH_LIBGLOG
   VLOG(2) << "Extension: " << extension.toString();
@@ -104,51 +111,54 @@ bool LessSelector::parseExtension(Selector &selector, Selector &extension) {
   return true; 
 }
 
-bool LessSelector::parseArguments(TokenList &selector) {
-  string delimiter;
-  TokenList::iterator i;
+bool LessSelector::parseArguments(TokenList::const_iterator &i,
+                                  const TokenList::const_iterator &end) {
+  string delimiter = ",";
+  TokenList::const_iterator j;
+  std::string rest;
 
-  if (selector.front().type != Token::PAREN_OPEN)
+  if ((*i).type != Token::PAREN_OPEN)
     return false;
 
-  if (selector.contains(Token::DELIMITER, ";"))
-    delimiter = ";";
-  else
-    delimiter = ",";
+  for (j = i; j != end; j++) {
+    if ((*j).type == Token::DELIMITER && *j == ";") {
+      delimiter = ";";
+      break;
+    }
+  }
 
 #ifdef WITH_LIBGLOG
   VLOG(3) << "Parameter delimiter: " << delimiter;
 #endif
   
-  if (!validateArguments(selector, delimiter))
+  if (!validateArguments(i, end, delimiter))
     return false;
 
-  selector.pop_front();
+  j = i;
+  j++;
 
-  selector.ltrim();
+  skipWhitespace(j, end);
 
-  while (parseParameter(selector, delimiter)) {
-    selector.ltrim();
+  while (parseParameter(j, end, delimiter)) {
+    skipWhitespace(j, end);
   }
 
-  i = selector.begin();
-  
-  if (selector.size() > 3  &&
-      (*i) == "." &&
-      (*++i) == "." &&
-      (*++i) == ".") {
+  if (end - j > 3  &&
+      *j == "." &&
+      *(j + 1) == "." &&
+      *(j + 2) == ".") {
     _unlimitedArguments = true;
-    i++;
-    selector.erase(selector.begin(), i);
+    j += 3;
   }
 
-  selector.ltrim();
+  skipWhitespace(j, end);
 
-  if (selector.front().type != Token::PAREN_CLOSED) {
-    throw new ParseException(selector.toString(),
-                             "matching parentheses.", 0, 0, "");
+  if (j == end || (*j).type != Token::PAREN_CLOSED) {
+    for (; j != end; j++)
+      rest.append(*j);
+    throw new ParseException(rest, "matching parentheses.", 0, 0, "");
   }
-  selector.pop_front();
+  i = j + 1;
 
 #ifdef WITH_LIBGLOG
   VLOG(3) << "Done parsing parameters";
@@ -158,21 +168,20 @@ bool LessSelector::parseArguments(TokenList &selector) {
 }
 
 
-bool LessSelector::validateArguments(const TokenList &arguments,
+bool LessSelector::validateArguments(TokenList::const_iterator i,
+                                     const TokenList::const_iterator &end,
                                      const std::string &delimiter) {
-  TokenList::const_iterator i = arguments.begin();
-
   if ((*i).type != Token::PAREN_OPEN)
     return false;
 
   i++;
   
-  while(i != arguments.end() &&
+  while(i != end &&
         (*i).type == Token::WHITESPACE) {
     i++;
   }
 
-  while(i != arguments.end()) {
+  while(i != end) {
     if ((*i).type == Token::IDENTIFIER) {
       // switch
       i++;
@@ -181,20 +190,20 @@ bool LessSelector::validateArguments(const TokenList &arguments,
       // variable
       i++;
       
-      if ((*i).type == Token::COLON) {
+      if (i != end && (*i).type == Token::COLON) {
         // default value
         i++;
-        while (i != arguments.end() &&
+        while (i != end &&
                (*i).type != Token::PAREN_CLOSED &&
                *i != delimiter) {
           i++;
         }
       
-      } else if (*i == ".") {
+      } else if (i != end && *i == ".") {
         i++;
         // rest
-        if (i == arguments.end() || *i != "." ||
-            ++i == arguments.end()  || *i != ".") {
+        if (i == end || *i != "." ||
+            ++i == end  || *i != ".") {
           return false;
         }
         i++;
@@ -203,29 +212,29 @@ bool LessSelector::validateArguments(const TokenList &arguments,
     } else 
       break;
         
-    if (*i != delimiter)
+    if (i == end || *i != delimiter)
       break;
     i++;
     
-    while(i != arguments.end() && (*i).type == Token::WHITESPACE) {
+    while(i != end && (*i).type == Token::WHITESPACE) {
       i++;
     }
   }
   
-  while(i != arguments.end() && (*i).type == Token::WHITESPACE) {
+  while(i != end && (*i).type == Token::WHITESPACE) {
     i++;
   }
 
   // rest
-  if (*i == ".") {
+  if (i != end && *i == ".") {
     i++;
-    if (i == arguments.end() || *i != "." ||
-        ++i == arguments.end() || *i != ".") {
+    if (i == end || *i != "." ||
+        ++i == end || *i != ".") {
       return false;
     }
     i++;
   }
-  if ((*i).type != Token::PAREN_CLOSED) 
+  if (i == end || (*i).type != Token::PAREN_CLOSED) 
     return false;
 
 #ifdef WITH_LIBGLOG
@@ -235,35 +244,33 @@ bool LessSelector::validateArguments(const TokenList &arguments,
   return true;
 }
 
-bool LessSelector::parseParameter(TokenList &selector, const std::string &delimiter) {
+bool LessSelector::parseParameter(TokenList::const_iterator &i,
+                                  const TokenList::const_iterator &end,
+                                  const std::string &delimiter) {
   string keyword;
   TokenList value;
-  TokenList::iterator i;
 
-  if (selector.empty())
+  if (i == end)
     return false;
 
-  if (selector.front().type == Token::IDENTIFIER) {
-    keyword = selector.front();
-    selector.pop_front();
+  if ((*i).type == Token::IDENTIFIER) {
+    keyword = *i;
+    i++;
 
-  } else if (selector.front().type == Token::ATKEYWORD) {
+  } else if ((*i).type == Token::ATKEYWORD) {
 
-    keyword = selector.front();
-    selector.pop_front();
+    keyword = *i;
+    i++;
 
-    i = selector.begin();
-    
-    if (parseDefaultValue(selector, delimiter, value)) {
+    if (parseDefaultValue(i, end, delimiter, value)) {
       // default value
       
-    } else if (selector.size() > 3 &&
-               (*i) == "." &&
-               (*++i) == "." &&
-               (*++i) == ".") {
-      i++;
+    } else if (end - i > 3 &&
+               *i == "." &&
+               *(i + 1) == "." &&
+               *(i + 2) == ".") {
       // rest argument
-      selector.erase(selector.begin(), i);
+      i += 3;
       
       restIdentifier = keyword;
       _unlimitedArguments = true;
@@ -272,11 +279,10 @@ bool LessSelector::parseParameter(TokenList &selector, const std::string &delimi
   } else
     return false;
 
-  selector.ltrim();
+  skipWhitespace(i, end);
   
-  if (!selector.empty() &&
-      selector.front() == delimiter)
-    selector.pop_front();
+  if (i != end && *i == delimiter)
+    i++;
 
 #ifdef WITH_LIBGLOG
   VLOG(2) << "Parameter: " << keyword << " default: " << value.toString();
@@ -287,28 +293,29 @@ bool LessSelector::parseParameter(TokenList &selector, const std::string &delimi
   return true;
 }
 
-bool LessSelector::parseDefaultValue(TokenList &arguments,
+bool LessSelector::parseDefaultValue(TokenList::const_iterator &i,
+                                     const TokenList::const_iterator &end,
                                      const std::string &delimiter,
                                      TokenList &value) {
   unsigned int parentheses = 0;
   
-  if (arguments.front().type != Token::COLON)
+  if (i == end || (*i).type != Token::COLON)
     return false;
   
-  arguments.pop_front();
+  i++;
     
-  while (!arguments.empty() &&
+  while (i != end &&
          (parentheses > 0 ||
-          (arguments.front().type != Token::PAREN_CLOSED &&
-           arguments.front() != delimiter))) {
+          ((*i).type != Token::PAREN_CLOSED &&
+           *i != delimiter))) {
     
-    if (arguments.front().type == Token::PAREN_OPEN)
+    if ((*i).type == Token::PAREN_OPEN)
       parentheses++;
-    if (arguments.front().type == Token::PAREN_CLOSED)
+    if ((*i).type == Token::PAREN_CLOSED)
       parentheses--;
 
-    value.push_back(arguments.front());
-    arguments.pop_front();
+    value.push_back(*i);
+    i++;
   }
 
   value.trim();
@@ -321,28 +328,28 @@ bool LessSelector::parseDefaultValue(TokenList &arguments,
   return true;
 }
 
-bool LessSelector::parseConditions (TokenList &selector) {
+bool LessSelector::parseConditions (TokenList::const_iterator &i,
+                                    const TokenList::const_iterator &end) {
   TokenList condition;
   
-  if (selector.empty() ||
-      selector.front() != "when")
+  if (i == end || *i != "when")
     return false;
 
 #ifdef WITH_LIBGLOG
   VLOG(3) << "Parsing conditions";
 #endif
   
-  selector.pop_front();
-  selector.ltrim();
+  i++;
+  skipWhitespace(i, end);
   
-  while (!selector.empty()) {
+  while (i != end) {
     
-    while(!selector.empty() && selector.front() != ",") {
-      condition.push_back(selector.front());
-      selector.pop_front();
+    while(i != end && *i != ",") {
+      condition.push_back(*i);
+      i++;
     }
-    if (!selector.empty() && selector.front() == ",")
-      selector.pop_front();
+    if (i != end && *i == ",")
+      i++;
 
 #ifdef WITH_LIBGLOG
     VLOG(2) << "Condition: " << condition.toString();
@@ -24,14 +24,29 @@ private:
   bool _needsArguments;
   std::string restIdentifier;
 
-  bool parseExtension(Selector &selector, Selector &extension);
-  bool parseArguments(TokenList &selector);
-  bool validateArguments(const TokenList &arguments, const std::string &delimiter);
-  bool parseParameter(TokenList &selector, const std::string &delimiter);
-  bool parseDefaultValue(TokenList &arguments,
+  /**
+   * The parse methods read the tokens from <code>i</code> and move it
+   * past the tokens they used.
+   */
+  static void skipWhitespace(TokenList::const_iterator &i,
+                             const TokenList::const_iterator &end);
+  bool parseExtension(TokenList::const_iterator &i,
+                      const TokenList::const_iterator &end,
+                      Selector &extension);
+  bool parseArguments(TokenList::const_iterator &i,
+                      const TokenList::const_iterator &end);
+  bool validateArguments(TokenList::const_iterator i,
+                         const TokenList::const_iterator &end,
+                         const std::string &delimiter);
+  bool parseParameter(TokenList::const_iterator &i,
+                      const TokenList::const_iterator &end,
+                      const std::string &delimiter);
+  bool parseDefaultValue(TokenList::const_iterator &i,
+                         const TokenList::const_iterator &end,
                          const std::string &delimiter,
                          TokenList &value);
-  bool parseConditions (TokenList &selector);
+  bool parseConditions (TokenList::const_iterator &i,
+                        const TokenList::const_iterator &end);
   
 public:
   LessSelector(const Selector &original);
@@ -1,5 +1,6 @@
 #include "LessStylesheet.h"
 #include "LessMediaQuery.h"
+#include "../Statistics.h"
 
 #include <config.h>
 
@@ -8,6 +9,7 @@
 #endif
 
 LessStylesheet::LessStylesheet() {
+  mixinIndexValid = false;
 }
 
 LessStylesheet::~LessStylesheet() {
@@ -22,6 +24,7 @@ LessRuleset* LessStylesheet::createLessRuleset() {
   
   addRuleset(*r);
   lessrulesets.push_back(r);
+  mixinIndexValid = false;
   r->setLessStylesheet(*this);
   return r;
 }
@@ -59,6 +62,7 @@ LessMediaQuery* LessStylesheet::createLessMediaQuery() {
 
 void LessStylesheet::deleteLessRuleset(LessRuleset &ruleset) {
   lessrulesets.remove(&ruleset);
+  mixinIndexValid = false;
   deleteStatement(ruleset);
 }
 
@@ -69,12 +73,16 @@ void LessStylesheet::deleteMixin(Mixin &mixin) {
 void LessStylesheet::getFunctions(std::list<const Function*> &rulesetList,
                                   const Mixin &mixin) const {
   std::list<LessRuleset*>::const_iterator i;
-  
-  for (i = lessrulesets.cbegin(); i != lessrulesets.cend();
-       i++) {
 
-    (*i)->getFunctions(rulesetList, mixin, mixin.name.begin());
+  if (!mixinIndexValid) {
+    mixinIndex.clear();
+    for (i = lessrulesets.cbegin(); i != lessrulesets.cend(); i++) {
+      mixinIndex.add(**i);
+    }
+    mixinIndexValid = true;
   }
+  
+  mixinIndex.getFunctions(rulesetList, mixin);
 }
 
 void LessStylesheet::setContext(ProcessingContext* context) {
@@ -84,10 +92,10 @@ ProcessingContext* LessStylesheet::getContext() {
   return context;
 }
 
-void LessStylesheet::putVariable(const std::string &key, const TokenList &value) {
+void LessStylesheet::putVariable(Symbol key, const TokenList &value) {
   variables[key] = value;
 }
-const TokenList* LessStylesheet::getVariable(const std::string &key) const {
+const TokenList* LessStylesheet::getVariable(Symbol key) const {
   return variables.getVariable(key);
 }
 
@@ -95,10 +103,12 @@ const TokenList* LessStylesheet::getVariable(const std::string &key) const {
 
 void LessStylesheet::process(Stylesheet &s, ProcessingContext &context) {
   std::list<Extension>* extensions;
+  ExtensionIndex extensionIndex;
   
   std::list<Ruleset*>::iterator r_it;
   std::list<Extension>::iterator e_it;
   std::list<Closure*> closureScope;
+  Statistics::Timer timer(Statistics::PROCESS);
   
   this->context = &context;
 
@@ -110,14 +120,19 @@ void LessStylesheet::process(Stylesheet &s, ProcessingContext &context) {
   // post processing
   extensions = &context.getExtensions();
 
+  if (extensions->empty())
+    return;
+
+  Statistics::Timer extendTimer(Statistics::EXTEND);
+  
+  for (e_it = extensions->begin(); e_it != extensions->end(); e_it++) {
+    extensionIndex.add(*e_it);
+  }
+  
   for (r_it = s.getRulesets().begin();
        r_it != s.getRulesets().end();
        r_it++) {
-    for (e_it = extensions->begin();
-         e_it != extensions->end();
-         e_it++) {
-      (*e_it).updateSelector((*r_it)->getSelector());
-    }
+    extensionIndex.updateSelector((*r_it)->getSelector());
   }
 }
 
@@ -12,6 +12,8 @@
 #include "UnprocessedStatement.h"
 #include "ProcessingContext.h"
 #include "LessAtRule.h"
+#include "MixinIndex.h"
+#include "ExtensionIndex.h"
 
 #include <list>
 #include <map>
@@ -24,6 +26,13 @@ private:
   std::list<LessRuleset*> lessrulesets;
   std::list<Closure*> closures;
 
+  /**
+   * Index of lessrulesets for getFunctions(). Rebuilt on the next
+   * lookup after a ruleset is created or deleted.
+   */
+  mutable MixinIndex mixinIndex;
+  mutable bool mixinIndexValid;
+
   VariableMap variables;
   ProcessingContext* context;
   
@@ -42,12 +51,12 @@ public:
   void setContext(ProcessingContext* context);
   virtual ProcessingContext* getContext();
   
-  void putVariable(const std::string &key, const TokenList &value);
+  void putVariable(Symbol key, const TokenList &value);
 
   virtual void getFunctions(std::list<const Function*> &functionList,
                             const Mixin &mixin) const;
 
-  virtual const TokenList* getVariable(const std::string &key) const;
+  virtual const TokenList* getVariable(Symbol key) const;
   
   virtual void process(Stylesheet &s, ProcessingContext &context);
   void saveReturnValues(ProcessingContext &context);
@@ -30,12 +30,11 @@ void MediaQueryRuleset::process(Stylesheet &s, Selector* prefix, ProcessingConte
   context.processValue(selector);
 
   if (query->getSelector().size() > 0) {
-    selector.pop_front();
-
     query->getSelector().push_back(Token::BUILTIN_SPACE);
     query->getSelector().push_back(BUILTIN_AND);
+    // without the first token of the selector
     query->getSelector().insert(query->getSelector().end(),
-                                 selector.begin(),
+                                 selector.begin() + 1,
                                  selector.end());
   } else
     query->setSelector(selector);
@@ -1,6 +1,7 @@
 #include "Mixin.h"
 #include "LessStylesheet.h"
 #include "LessRuleset.h"
+#include "../Statistics.h"
 
 #include <config.h>
 
@@ -9,9 +10,11 @@
 #endif
 
 Mixin::Mixin() {
+  lessStylesheet = NULL;
 }
 
 Mixin::Mixin(const Selector &name) {
+  lessStylesheet = NULL;
   this->name = name;
 }
 
@@ -60,8 +63,6 @@ bool Mixin::parse(const Selector &selector) {
 bool Mixin::call(Stylesheet &s, ProcessingContext &context,
                    Ruleset* target, LessRuleset* parent) {
 
-  vector<TokenList>::iterator arg_i;
-  map<string, TokenList>::iterator argn_i;
   list<const Function*>::iterator i;
   list<const Function*> functionList;
   const Function* function;
@@ -77,21 +78,8 @@ bool Mixin::call(Stylesheet &s, ProcessingContext &context,
 
   if (functionList.empty())
     return false;
-  
-  for (arg_i = arguments.begin(); arg_i != arguments.end(); arg_i++) {
-#ifdef WITH_LIBGLOG
-    VLOG(3) << "Mixin Arg: " << (*arg_i).toString();
-#endif
-    context.processValue(*arg_i);
-  }
 
-  for (argn_i = namedArguments.begin();
-       argn_i != namedArguments.end(); argn_i++) {
-#ifdef WITH_LIBGLOG
-    VLOG(3) << "Mixin Arg " << argn_i->first << ": " << argn_i->second.toString();
-#endif
-    context.processValue(argn_i->second);
-  }
+  processArguments(context);
   
   for (i = functionList.begin(); i != functionList.end(); i++) {
     function = *i;
@@ -102,28 +90,57 @@ bool Mixin::call(Stylesheet &s, ProcessingContext &context,
 
     if (function->getLessSelector()->needsArguments() ||
         !context.isInStack(*function)) {
-      context.pushMixinCall(*function);
+      beginCall(*function, context);
       
       if (target != NULL)
         function->call(*this, *target, context);
       else
         function->call(*this, s, context);
 
-      context.popMixinCall();
-      if (parent != NULL)  {
-        if (context.isSavePoint()) 
-          parent->saveReturnValues(context);
-        
-      } else {
-        getLessStylesheet()->saveReturnValues(context);
-      }
-
+      endCall(context, parent);
     }
   }
 
   return true;
 }
 
+void Mixin::beginCall(const Function &function, ProcessingContext &context) {
+  Statistics::count(Statistics::MIXIN_CALLS);
+  context.pushMixinCall(function);
+}
+
+void Mixin::endCall(ProcessingContext &context, LessRuleset* parent) {
+  context.popMixinCall();
+  
+  if (parent != NULL)  {
+    if (context.isSavePoint()) 
+      parent->saveReturnValues(context);
+        
+  } else {
+    getLessStylesheet()->saveReturnValues(context);
+  }
+}
+
+void Mixin::processArguments(ProcessingContext &context) {
+  vector<TokenList>::iterator arg_i;
+  map<string, TokenList>::iterator argn_i;
+
+  for (arg_i = arguments.begin(); arg_i != arguments.end(); arg_i++) {
+#ifdef WITH_LIBGLOG
+    VLOG(3) << "Mixin Arg: " << (*arg_i).toString();
+#endif
+    context.processValue(*arg_i);
+  }
+
+  for (argn_i = namedArguments.begin();
+       argn_i != namedArguments.end(); argn_i++) {
+#ifdef WITH_LIBGLOG
+    VLOG(3) << "Mixin Arg " << argn_i->first << ": " << argn_i->second.toString();
+#endif
+    context.processValue(argn_i->second);
+  }
+}
+
 void Mixin::setLessStylesheet(LessStylesheet &s) {
   lessStylesheet = &s;
   stylesheet = &s;
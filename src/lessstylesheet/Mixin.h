@@ -42,7 +42,23 @@ public:
 
   bool call(Stylesheet &s, ProcessingContext &context,
               Ruleset* ruleset, LessRuleset* parent);
+  /**
+   * Push a call to <code>function</code> on the stack of
+   * <code>context</code>. Each call is ended with endCall().
+   */
+  void beginCall(const Function &function, ProcessingContext &context);
+  /**
+   * Pop the call from the stack and save the variables and closures it
+   * returned in <code>parent</code>, or in the stylesheet if
+   * <code>parent</code> is NULL.
+   */
+  void endCall(ProcessingContext &context, LessRuleset* parent);
   bool parse(const Selector &selector);
+  /**
+   * Replace the variables and operations in the arguments with their
+   * values.
+   */
+  void processArguments(ProcessingContext &context);
 
   virtual void setLessStylesheet(LessStylesheet &stylesheet);
   LessStylesheet* getLessStylesheet();
@@ -7,10 +7,14 @@ MixinCall::MixinCall(MixinCall* parent, const Function& function, bool
   savepoint) {
   this->parent = parent;
   this->function = &function;
+  if (parent != NULL && parent->function == &function)
+    outer = parent->outer;
+  else
+    outer = parent;
   this->savepoint = savepoint;
 }
 
-const TokenList* MixinCall::getVariable(const std::string &key) const {
+const TokenList* MixinCall::getVariable(Symbol key) const {
   VariableMap::const_iterator mit;
   const TokenList* t;
   
@@ -35,8 +39,8 @@ void MixinCall::getFunctions (std::list<const Function*> &functionList,
   if (!functionList.empty())
     return;
 
-  if (parent != NULL)
-    parent->getFunctions(functionList, mixin);
+  if (outer != NULL)
+    outer->getFunctions(functionList, mixin);
 }
 
 bool MixinCall::isInStack(const Function &function) const {
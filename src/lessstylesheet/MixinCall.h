@@ -4,6 +4,7 @@
 
 #include "../TokenList.h"
 #include "../VariableMap.h"
+#include <list>
 
 class Function;
 class Mixin;
@@ -11,6 +12,12 @@ class Mixin;
 class MixinCall {
 public:
   MixinCall* parent;
+  /**
+   * The nearest call below this one that has a different function.
+   * Calls of the same function, like the iterations of a loop, have
+   * the same functions in scope, so getFunctions() skips them.
+   */
+  MixinCall* outer;
   const Function* function;
   VariableMap arguments;
   bool savepoint;
@@ -18,7 +25,7 @@ public:
   MixinCall(MixinCall* parent, const Function& function, bool
             savepoint = false);
 
-  const TokenList* getVariable(const std::string &key) const;
+  const TokenList* getVariable(Symbol key) const;
   void getFunctions (std::list<const Function*> &functionList,
                      const Mixin& mixin) const;
   bool isInStack(const Function &function) const;
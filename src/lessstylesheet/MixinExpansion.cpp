@@ -0,0 +1,87 @@
+#include "MixinExpansion.h"
+#include "../stylesheet/Declaration.h"
+
+#include <list>
+#include <iterator>
+
+bool MixinExpansion::equals(const TokenList &t1, const TokenList &t2,
+                            bool locations) {
+  TokenList::const_iterator i1, i2;
+
+  if (!(t1 == t2))
+    return false;
+  if (!locations)
+    return true;
+
+  for (i1 = t1.begin(), i2 = t2.begin(); i1 != t1.end(); i1++, i2++) {
+    if ((*i1).line != (*i2).line ||
+        (*i1).column != (*i2).column ||
+        (*i1).source != (*i2).source)
+      return false;
+  }
+  return true;
+}
+
+void MixinExpansion::addRead(Symbol key, const TokenList* value) {
+  std::vector<Symbol>::iterator it;
+
+  for (it = keys.begin(); it != keys.end(); it++) {
+    if (*it == key)
+      return;
+  }
+
+  keys.push_back(key);
+  defined.push_back(value != NULL);
+  if (value != NULL)
+    values.push_back(*value);
+  else
+    values.push_back(TokenList());
+}
+
+bool MixinExpansion::save(Ruleset &target, size_t statementCount,
+                          size_t declarationCount) {
+  std::list<Declaration*>& targetDeclarations = target.getDeclarations();
+  std::list<Declaration*>::iterator it;
+  size_t added = targetDeclarations.size() - declarationCount;
+
+  if (target.getStatements().size() - statementCount != added)
+    return false;
+
+  it = targetDeclarations.end();
+  std::advance(it, -(long)added);
+
+  for (; it != targetDeclarations.end(); it++) {
+    declarations.push_back(std::pair<Token, TokenList>
+                           ((*it)->getProperty(), (*it)->getValue()));
+  }
+  return true;
+}
+
+bool MixinExpansion::matches(const ValueScope &scope, bool locations) const {
+  const TokenList* value;
+  size_t i;
+
+  for (i = 0; i < keys.size(); i++) {
+    value = scope.getVariable(keys[i]);
+
+    if (value == NULL) {
+      if (defined[i])
+        return false;
+    } else if (!defined[i] || !equals(*value, values[i], locations))
+      return false;
+  }
+  return true;
+}
+
+Statistics::Recording* MixinExpansion::getStatistics() {
+  return &statistics;
+}
+
+void MixinExpansion::insert(Ruleset &target) const {
+  std::vector<std::pair<Token, TokenList> >::const_iterator it;
+
+  for (it = declarations.begin(); it != declarations.end(); it++) {
+    target.createDeclaration(it->first)->setValue(it->second);
+  }
+  Statistics::replay(statistics);
+}
@@ -0,0 +1,76 @@
+#ifndef __MixinExpansion_h__
+#define __MixinExpansion_h__
+
+#include "../Token.h"
+#include "../TokenList.h"
+#include "../SymbolTable.h"
+#include "../value/ValueScope.h"
+#include "../stylesheet/Ruleset.h"
+#include "../Statistics.h"
+
+#include <vector>
+#include <utility>
+
+/**
+ * The declarations a mixin call inserted into its target, together
+ * with the variables the call read to produce them.
+ *
+ * Processing the statements of a mixin without nested rules or mixin
+ * calls only depends on the variables in scope, so a later call of the
+ * same mixin that reads the same values produces the same declarations
+ * and can insert a copy of them instead.
+ */
+class MixinExpansion {
+private:
+  std::vector<Symbol> keys;
+  /**
+   * The value of each key when it was first read, or an empty list if
+   * it was not defined.
+   */
+  std::vector<TokenList> values;
+  std::vector<bool> defined;
+
+  std::vector<std::pair<Token, TokenList> > declarations;
+  Statistics::Recording statistics;
+
+  static bool equals(const TokenList &t1, const TokenList &t2,
+                     bool locations);
+
+public:
+  /**
+   * Record that the variable <code>key</code> was read and resolved to
+   * <code>value</code>. Only the first read of a variable is kept.
+   */
+  void addRead(Symbol key, const TokenList* value);
+
+  /**
+   * Copy the declarations that were added to the end of
+   * <code>target</code> after it had <code>statementCount</code>
+   * statements and <code>declarationCount</code> declarations.
+   *
+   * @return false if anything besides declarations was added.
+   */
+  bool save(Ruleset &target, size_t statementCount,
+            size_t declarationCount);
+
+  /**
+   * Check that every recorded variable resolves to the same value in
+   * <code>scope</code>. If <code>locations</code> is true the tokens
+   * also have to come from the same place in the source.
+   */
+  bool matches(const ValueScope &scope, bool locations) const;
+
+  /**
+   * The values and function calls counted while the expansion was
+   * recorded.
+   */
+  Statistics::Recording* getStatistics();
+
+  /**
+   * Add a copy of the saved declarations to <code>target</code>, and
+   * count the values and function calls that produced them again.
+   */
+  void insert(Ruleset &target) const;
+};
+
+#endif
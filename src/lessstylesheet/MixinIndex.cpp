@@ -0,0 +1,106 @@
+#include "MixinIndex.h"
+#include "LessSelector.h"
+#include "Mixin.h"
+
+bool MixinIndex::getKey(TokenList::const_iterator first,
+                        TokenList::const_iterator last,
+                        Key &key) {
+  TokenList::const_iterator next;
+
+  if (first == last)
+    return false;
+
+  key = (Key)(*first).getSymbol() << 32;
+
+  // a class selector is a '.' followed by the class name.
+  if (*first == ".") {
+    next = first + 1;
+    if (next == last || (*next).type != Token::IDENTIFIER)
+      return false;
+    key |= (*next).getSymbol();
+  }
+  return true;
+}
+
+void MixinIndex::add(const Function &function) {
+  const Selector* selector = function.getLessSelector();
+  TokenList::const_iterator first, last;
+  std::vector<Key> keys;
+  std::vector<Key>::iterator k_it;
+  std::vector<size_t>* bucket;
+  size_t n = functions.size();
+  Key key;
+
+  functions.push_back(&function);
+
+  // Split the selector the same way Selector::walk() does.
+  for (first = selector->begin(); first != selector->end(); ) {
+    last = selector->findComma(first);
+
+    // empty parts never match
+    if (first != last) {
+      if (!getKey(first, last, key)) {
+        wildcards.push_back(n);
+        return;
+      }
+      keys.push_back(key);
+    }
+
+    first = last;
+    if (first != selector->end()) {
+      first++;
+      while (first != selector->end() &&
+             (*first).type == Token::WHITESPACE)
+        first++;
+    }
+  }
+
+  for (k_it = keys.begin(); k_it != keys.end(); k_it++) {
+    bucket = &buckets[*k_it];
+    if (bucket->empty() || bucket->back() != n)
+      bucket->push_back(n);
+  }
+}
+
+void MixinIndex::clear() {
+  functions.clear();
+  buckets.clear();
+  wildcards.clear();
+}
+
+bool MixinIndex::empty() const {
+  return functions.empty();
+}
+
+void MixinIndex::getFunctions(std::list<const Function*> &functionList,
+                              const Mixin &mixin) const {
+  std::unordered_map<Key, std::vector<size_t> >::const_iterator b_it;
+  std::vector<const Function*>::const_iterator f_it;
+  const std::vector<size_t>* bucket = NULL;
+  size_t i = 0, j = 0, n;
+  Key key;
+
+  if (!getKey(mixin.name.begin(), mixin.name.end(), key)) {
+    for (f_it = functions.begin(); f_it != functions.end(); f_it++) {
+      (*f_it)->getFunctions(functionList, mixin, mixin.name.begin());
+    }
+    return;
+  }
+
+  b_it = buckets.find(key);
+  if (b_it != buckets.end())
+    bucket = &b_it->second;
+
+  // merge the bucket with the wildcards to keep the original order
+  while ((bucket != NULL && i < bucket->size()) ||
+         j < wildcards.size()) {
+    if (j == wildcards.size() ||
+        (bucket != NULL && i < bucket->size() &&
+         (*bucket)[i] < wildcards[j])) {
+      n = (*bucket)[i++];
+    } else
+      n = wildcards[j++];
+
+    functions[n]->getFunctions(functionList, mixin, mixin.name.begin());
+  }
+}
@@ -0,0 +1,58 @@
+#ifndef __MixinIndex_h__
+#define __MixinIndex_h__
+
+#include "../TokenList.h"
+#include "Function.h"
+
+#include <list>
+#include <vector>
+#include <unordered_map>
+
+class Mixin;
+
+/**
+ * Index of the functions (rulesets and closures) in a scope that a
+ * mixin call can match.
+ *
+ * A mixin name only matches a selector if it starts with the same
+ * tokens as one of the comma separated parts of the selector, so the
+ * functions are filed under the leading segment of each part: the
+ * first token, or '.' and the class name. Parts without such a segment
+ * are filed as wildcards and are tried for every mixin. getFunctions()
+ * only walks the functions filed under the key of the mixin name, in
+ * the order they were added, so it returns the same functions as
+ * walking the whole scope.
+ */
+class MixinIndex {
+private:
+  typedef unsigned long long Key;
+
+  std::vector<const Function*> functions;
+  std::unordered_map<Key, std::vector<size_t> > buckets;
+  std::vector<size_t> wildcards;
+
+  /**
+   * Get the key of the segment starting at <code>first</code>.
+   *
+   * @return false if the tokens don't start with a segment that can be
+   *         used as a key.
+   */
+  static bool getKey(TokenList::const_iterator first,
+                     TokenList::const_iterator last,
+                     Key &key);
+
+public:
+  void add(const Function &function);
+  void clear();
+  bool empty() const;
+
+  /**
+   * Add the functions that match <code>mixin</code> to
+   * <code>functionList</code>, in the order they were added to the
+   * index.
+   */
+  void getFunctions(std::list<const Function*> &functionList,
+                    const Mixin &mixin) const;
+};
+
+#endif
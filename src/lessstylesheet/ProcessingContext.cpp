@@ -14,6 +14,14 @@
 ProcessingContext::ProcessingContext() {
   stack = NULL;
   contextStylesheet = NULL;
+  recording = NULL;
+  sourceLocations = true;
+}
+
+ProcessingContext::~ProcessingContext() {
+  // processing stopped with an error while an expansion was recorded
+  if (recording != NULL)
+    Statistics::setRecording(NULL);
 }
 
 void ProcessingContext::setLessStylesheet(LessStylesheet &stylesheet) {
@@ -23,13 +31,19 @@ LessStylesheet* ProcessingContext::getLessStylesheet() {
   return contextStylesheet;
 }
 
-const TokenList* ProcessingContext::getVariable(const std::string &key) const {
+const TokenList* ProcessingContext::getVariable(Symbol key) const {
+  const TokenList* t;
+  
   if (stack != NULL)
-    return stack->getVariable(key);
+    t = stack->getVariable(key);
   else if (contextStylesheet != NULL)
-    return contextStylesheet->getVariable(key);
+    t = contextStylesheet->getVariable(key);
   else
-    return NULL;
+    t = NULL;
+
+  if (recording != NULL)
+    recording->addRead(key, t);
+  return t;
 }
 
 void ProcessingContext::pushMixinCall(const Function &function, bool
@@ -78,6 +92,51 @@ bool ProcessingContext::isInStack(const Function &function) const {
     return NULL;
 }
 
+void ProcessingContext::setSourceLocations(bool keep) {
+  sourceLocations = keep;
+}
+
+const MixinExpansion* ProcessingContext::getExpansion(const LessRuleset
+                                                      &ruleset) const {
+  std::unordered_map<const LessRuleset*,
+                     std::list<MixinExpansion> >::const_iterator it;
+  std::list<MixinExpansion>::const_iterator e_it;
+
+  it = expansions.find(&ruleset);
+  if (it == expansions.end())
+    return NULL;
+
+  for (e_it = it->second.begin(); e_it != it->second.end(); e_it++) {
+    if ((*e_it).matches(*this, sourceLocations))
+      return &(*e_it);
+  }
+  return NULL;
+}
+
+bool ProcessingContext::startExpansion(const LessRuleset &ruleset) {
+  std::list<MixinExpansion>& saved = expansions[&ruleset];
+
+  if (recording != NULL || saved.size() >= MAX_EXPANSIONS)
+    return false;
+  
+  saved.push_back(MixinExpansion());
+  recording = &saved.back();
+  Statistics::setRecording(recording->getStatistics());
+  return true;
+}
+
+void ProcessingContext::endExpansion(const LessRuleset &ruleset,
+                                     Ruleset &target,
+                                     size_t statementCount,
+                                     size_t declarationCount) {
+  std::list<MixinExpansion>& saved = expansions[&ruleset];
+
+  recording = NULL;
+  Statistics::setRecording(NULL);
+  if (!saved.back().save(target, statementCount, declarationCount))
+    saved.pop_back();
+}
+
 void ProcessingContext::addExtension(Extension& extension){
   extensions.push_back(extension);
 }
@@ -89,11 +148,13 @@ void ProcessingContext::addClosure(const LessRuleset &ruleset) {
   if (stack != NULL) {
     Closure* c = new Closure(ruleset, *stack);
     closures.push_back(c);
+    closureIndex.add(*c);
   }
 }
 void ProcessingContext::saveClosures(std::list<Closure*> &closures) {
   closures.insert(closures.end(), this->closures.begin(), this->closures.end());
   this->closures.clear();
+  closureIndex.clear();
 }
 
 void ProcessingContext::addVariables(const VariableMap &variables) {
@@ -106,11 +167,7 @@ void ProcessingContext::saveVariables(VariableMap &variables) {
 
 void ProcessingContext::getClosures(std::list<const Function*> &closureList,
                                         const Mixin &mixin) const {
-  std::list<Closure*>::const_iterator it;
-  
-  for (it = closures.cbegin(); it != closures.cend(); it++) {
-    (*it)->getFunctions(closureList, mixin, mixin.name.begin());
-  }
+  closureIndex.getFunctions(closureList, mixin);
 }
 
 ValueProcessor* ProcessingContext::getValueProcessor() {
@@ -120,13 +177,17 @@ ValueProcessor* ProcessingContext::getValueProcessor() {
 void ProcessingContext::interpolate(TokenList &tokens) {
   processor.interpolate(tokens, *this);
 }
-void ProcessingContext::interpolate(std::string &str) {
-  processor.interpolate(str, *this);
+void ProcessingContext::interpolate(Token &token) {
+  processor.interpolate(token, *this);
 }
 
 void ProcessingContext::processValue(TokenList& value) {
   processor.processValue(value, *this);
 }
+void ProcessingContext::processValue(TokenList& value,
+                                     const CompiledValue &compiled) {
+  processor.processValue(value, compiled, *this);
+}
 
 bool ProcessingContext::validateCondition(TokenList &value) {
   return processor.validateCondition(value, *this);
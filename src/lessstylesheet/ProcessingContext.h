@@ -14,6 +14,10 @@
 #include "MixinCall.h"
 #include "Function.h"
 #include "Closure.h"
+#include "MixinIndex.h"
+#include "MixinExpansion.h"
+
+#include <unordered_map>
 
 class LessRuleset;
 class Function;
@@ -32,15 +36,28 @@ private:
   
   // return values
   std::list<Closure*> closures;
+  MixinIndex closureIndex;
   VariableMap variables;  
 
+  /**
+   * Saved expansions of mixins without nested rules, and the expansion
+   * that is being recorded.
+   */
+  std::unordered_map<const LessRuleset*,
+                     std::list<MixinExpansion> > expansions;
+  MixinExpansion* recording;
+  bool sourceLocations;
+
+  static const size_t MAX_EXPANSIONS = 16;
+
 public:
   ProcessingContext();
+  virtual ~ProcessingContext();
 
   void setLessStylesheet(LessStylesheet &stylesheet);
   LessStylesheet* getLessStylesheet();
   
-  virtual const TokenList* getVariable(const std::string &key) const;
+  virtual const TokenList* getVariable(Symbol key) const;
   
   void pushMixinCall(const Function &function, bool savepoint = false);
   void popMixinCall();
@@ -60,14 +77,43 @@ public:
   void addClosure(const LessRuleset &ruleset);
   void addVariables(const VariableMap &variables);
   
+  /**
+   * Whether processed values have to keep the source locations of the
+   * tokens they are made of, which is only needed when a source map is
+   * written. When true, a saved mixin expansion is only reused if the
+   * variables it read come from the same place in the source. Defaults
+   * to true.
+   */
+  void setSourceLocations(bool keep);
+
+  /**
+   * Returns a saved expansion of <code>ruleset</code> that read the
+   * same variables as the current scope has, or NULL.
+   */
+  const MixinExpansion* getExpansion(const LessRuleset &ruleset) const;
+  /**
+   * Start recording the variables read to expand
+   * <code>ruleset</code>. Returns false if enough expansions of the
+   * ruleset are already saved.
+   */
+  bool startExpansion(const LessRuleset &ruleset);
+  /**
+   * Stop recording and save the declarations added to
+   * <code>target</code> since it had <code>statementCount</code>
+   * statements and <code>declarationCount</code> declarations.
+   */
+  void endExpansion(const LessRuleset &ruleset, Ruleset &target,
+                    size_t statementCount, size_t declarationCount);
+  
   void addExtension(Extension& extension);
   std::list<Extension>& getExtensions();
 
   ValueProcessor* getValueProcessor();
 
   void interpolate(TokenList &tokens);
-  void interpolate(std::string &str);
+  void interpolate(Token &token);
   void processValue(TokenList& value);
+  void processValue(TokenList& value, const CompiledValue &compiled);
   bool validateCondition(TokenList &value);
 };
 
@@ -0,0 +1,86 @@
+#include "TokenMatcher.h"
+
+#include <deque>
+
+TokenMatcher::TokenMatcher() {
+  // the root state
+  transitions.push_back(std::unordered_map<Key, size_t>());
+  output.push_back(std::vector<size_t>());
+}
+
+void TokenMatcher::add(const std::vector<Key> &pattern, size_t id) {
+  std::vector<Key>::const_iterator it;
+  std::unordered_map<Key, size_t>::iterator t_it;
+  size_t state = 0;
+
+  for (it = pattern.begin(); it != pattern.end(); it++) {
+    t_it = transitions[state].find(*it);
+
+    if (t_it != transitions[state].end()) {
+      state = t_it->second;
+    } else {
+      transitions[state][*it] = transitions.size();
+      state = transitions.size();
+      transitions.push_back(std::unordered_map<Key, size_t>());
+      output.push_back(std::vector<size_t>());
+    }
+  }
+  output[state].push_back(id);
+}
+
+void TokenMatcher::build() {
+  std::deque<size_t> queue;
+  std::unordered_map<Key, size_t>::const_iterator t_it;
+  size_t state, target, f;
+
+  failure.assign(transitions.size(), 0);
+
+  for (t_it = transitions[0].begin(); t_it != transitions[0].end(); t_it++)
+    queue.push_back(t_it->second);
+
+  // breadth first, so the failure state of a state is done before it
+  while (!queue.empty()) {
+    state = queue.front();
+    queue.pop_front();
+
+    for (t_it = transitions[state].begin();
+         t_it != transitions[state].end();
+         t_it++) {
+      target = t_it->second;
+      f = next(failure[state], t_it->first);
+
+      failure[target] = f;
+      output[target].insert(output[target].end(),
+                            output[f].begin(), output[f].end());
+      queue.push_back(target);
+    }
+  }
+}
+
+bool TokenMatcher::empty() const {
+  return transitions.size() == 1;
+}
+
+size_t TokenMatcher::next(size_t state, Key key) const {
+  std::unordered_map<Key, size_t>::const_iterator t_it;
+
+  while (true) {
+    t_it = transitions[state].find(key);
+    if (t_it != transitions[state].end())
+      return t_it->second;
+    if (state == 0)
+      return 0;
+    state = failure[state];
+  }
+}
+
+void TokenMatcher::find(const std::vector<Key> &text,
+                        std::set<size_t> &ids) const {
+  std::vector<Key>::const_iterator it;
+  size_t state = 0;
+
+  for (it = text.begin(); it != text.end(); it++) {
+    state = next(state, *it);
+    ids.insert(output[state].begin(), output[state].end());
+  }
+}
@@ -0,0 +1,49 @@
+#ifndef __TokenMatcher_h__
+#define __TokenMatcher_h__
+
+#include <vector>
+#include <set>
+#include <unordered_map>
+#include <cstddef>
+
+/**
+ * Finds which of a set of patterns occur in a sequence of token keys,
+ * scanning the sequence once for all patterns (Aho-Corasick).
+ *
+ * Patterns are added with add() and build() links the states; after
+ * that find() can be called any number of times.
+ */
+class TokenMatcher {
+public:
+  typedef unsigned long long Key;
+
+private:
+  std::vector<std::unordered_map<Key, size_t> > transitions;
+  /**
+   * The state for the longest proper suffix of each state that is
+   * also the prefix of a pattern.
+   */
+  std::vector<size_t> failure;
+  /**
+   * The ids of the patterns that end in each state, including the
+   * patterns that end in its failure states.
+   */
+  std::vector<std::vector<size_t> > output;
+
+  size_t next(size_t state, Key key) const;
+
+public:
+  TokenMatcher();
+
+  void add(const std::vector<Key> &pattern, size_t id);
+  void build();
+  bool empty() const;
+
+  /**
+   * Add the ids of the patterns that occur in <code>text</code> to
+   * <code>ids</code>.
+   */
+  void find(const std::vector<Key> &text, std::set<size_t> &ids) const;
+};
+
+#endif
@@ -12,6 +12,11 @@
 
 UnprocessedStatement::UnprocessedStatement() {
   property_i = 0;
+  compiledValue = NULL;
+}
+
+UnprocessedStatement::~UnprocessedStatement() {
+  delete compiledValue;
 }
 
 Selector* UnprocessedStatement::getTokens(){
@@ -99,7 +104,15 @@ void UnprocessedStatement::process(Ruleset &r) {
 #endif
 
       getLessRuleset()->getContext()->interpolate(declaration->getProperty());
-      getLessRuleset()->getContext()->processValue(declaration->getValue());
+
+      // mixins process the same statements over and over; parse the
+      // value only once.
+      if (compiledValue == NULL) {
+        compiledValue = getLessRuleset()->getContext()->getValueProcessor()
+          ->compileValue(declaration->getValue());
+      }
+      getLessRuleset()->getContext()->processValue(declaration->getValue(),
+                                                   *compiledValue);
 
 #ifdef WITH_LIBGLOG
       VLOG(2) << "Processed declaration: " <<
@@ -171,6 +184,7 @@ bool UnprocessedStatement::getExtension(TokenList &extension) {
 bool UnprocessedStatement::processDeclaration (Declaration* declaration) {
   TokenList property;
   Token keyword;
+  TokenList::iterator i;
 
 #ifdef WITH_LIBGLOG
   VLOG(3) << "Declaration";
@@ -178,23 +192,26 @@ bool UnprocessedStatement::processDeclaration (Declaration* declaration) {
   
   getValue(declaration->getValue());
 
+  TokenList &value = declaration->getValue();
+  i = value.begin();
+  
   // fix: If there's a Token (not empty) and if this token is a space
-  if (declaration->getValue().empty() == false &&
-      declaration->getValue().front().type == Token::WHITESPACE) {
+  if (i != value.end() && (*i).type == Token::WHITESPACE) {
     // Then we dismiss it to process the next token which should be a colon
-    declaration->getValue().pop_front();
+    i++;
   }
   
-  if (declaration->getValue().empty() ||
-      declaration->getValue().front().type != Token::COLON) {
+  if (i == value.end() || (*i).type != Token::COLON) {
     return NULL;
   }
-    
-  declaration->getValue().pop_front();
+
+  // the space and the colon are removed at once
+  i++;
+  value.erase(value.begin(), i);
   
   getProperty(property);
   keyword = property.front();
-  keyword.assign(property.toString());
+  keyword = property.toString();
   
   declaration->setProperty(keyword);
   
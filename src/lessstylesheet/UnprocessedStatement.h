@@ -20,6 +20,12 @@ class UnprocessedStatement: public RulesetStatement {
 private:
   Selector tokens;
   LessRuleset* lessRuleset;
+
+  /**
+   * The declaration value, compiled the first time the statement is
+   * processed as a declaration.
+   */
+  CompiledValue* compiledValue;
   
 protected:
   bool processDeclaration (Declaration* declaration);
@@ -28,7 +34,7 @@ public:
   size_t property_i;
   
   UnprocessedStatement();
-  ~UnprocessedStatement() {}
+  ~UnprocessedStatement();
 
   Selector* getTokens();
 
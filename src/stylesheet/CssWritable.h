@@ -3,8 +3,9 @@
 #define __CssWritable_h__
 
 #include "../css/CssWriter.h"
+#include "../Arena.h"
 
-class CssWritable {
+class CssWritable: public ArenaObject {
 public:
   virtual void write(CssWriter &css) = 0; 
 };
@@ -9,6 +9,7 @@
 
 #include "../Token.h"
 #include "../TokenList.h"
+#include <list>
 
 #include "../css/CssWriter.h"
 
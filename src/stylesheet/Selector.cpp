@@ -11,10 +11,10 @@ Selector::~Selector() {
 }
 
 void Selector::addPrefix(const Selector &prefix) {
-  list<Selector> prefixParts;
-  list<Selector> sepParts;
-  list<Selector>::iterator prefixIt;
-  list<Selector>::iterator sepIt;
+  std::list<Selector> prefixParts;
+  std::list<Selector> sepParts;
+  std::list<Selector>::iterator prefixIt;
+  std::list<Selector>::iterator sepIt;
   Selector::iterator prefixPartIt;
 
   Selector* tmp, *prefixPart;
@@ -66,16 +66,16 @@ void Selector::addPrefix(const Selector &prefix) {
 
 void Selector::split(std::list<Selector> &l) const {
   TokenList::const_iterator first, last;
-  Selector current;
     
   for (first = begin(); first != end(); ) {
     last = findComma(first);
 
-    current.assign(first, last);
+    // construct the part in place instead of copying it into the list
+    l.push_back(Selector());
+    l.back().assign(first, last);
 #ifdef WITH_LIBGLOG
-    VLOG(3) << "Split: " << current.toString(); 
+    VLOG(3) << "Split: " << l.back().toString(); 
 #endif
-    l.push_back(current);
     
     first = last;
     if (first != end())
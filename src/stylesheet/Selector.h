@@ -10,6 +10,11 @@
  */
 class Selector: public TokenList {
 public:
+  Selector() {}
+  Selector(const Selector &) = default;
+  Selector(Selector &&) = default;
+  Selector& operator=(const Selector &) = default;
+  Selector& operator=(Selector &&) = default;
   virtual ~Selector();
 
   void addPrefix(const Selector &prefix);
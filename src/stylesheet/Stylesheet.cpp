@@ -1,5 +1,6 @@
 
 #include "Stylesheet.h"
+#include "../Statistics.h"
 
 #include <config.h>
 
@@ -38,6 +39,8 @@ void Stylesheet::addAtRule(AtRule &rule) {
 Ruleset* Stylesheet::createRuleset() {
   Ruleset* r = new Ruleset();
 
+  Statistics::count(Statistics::RULESETS);
+
 #ifdef WITH_LIBGLOG
   VLOG(3) << "Creating ruleset";
 #endif
@@ -50,6 +53,8 @@ Ruleset* Stylesheet::createRuleset() {
 Ruleset* Stylesheet::createRuleset(const Selector &selector) {
   Ruleset* r = new Ruleset(selector);
 
+  Statistics::count(Statistics::RULESETS);
+
 #ifdef WITH_LIBGLOG
   VLOG(3) << "Creating ruleset: " << selector.toString();
 #endif
@@ -151,5 +156,6 @@ void Stylesheet::write(CssWriter &writer) {
   for (i = statements.begin(); i != statements.end(); i++) {
     (*i)->write(writer);
   }
+  writer.flush();
 }
 
@@ -35,11 +35,12 @@ double Color::minArray(double* array, const size_t len) const {
   return ret;
 }
 
-void Color::updateTokens() {
+void Color::updateTokens() const {
   ostringstream stm;
   string sColor[3];
   string hash;
   int i;
+  Token location = tokens.front();
 
   tokens.clear();
 
@@ -93,25 +94,41 @@ void Color::updateTokens() {
 
     tokens.push_back(Token(hash, Token::HASH, 0,0,"generated"));
   }
+  tokens.front().setLocation(location);
+  tokensValid = true;
+  
 #ifdef WITH_LIBGLOG
   VLOG(3) << tokens.toString();
 #endif
 
 }
 
+void Color::invalidateTokens() {
+  tokens.clear();
+  tokens.push_back(Token("", Token::HASH, 0, 0, "generated"));
+  tokensValid = false;
+}
+
+const TokenList* Color::getTokens() const {
+  if (!tokensValid)
+    updateTokens();
+  return &tokens;
+}
+
 Color::Color(): Value() {
   type = Value::COLOR;
   color[RGB_RED] = 0;
   color[RGB_GREEN] = 0;
   color[RGB_BLUE] = 0;
   alpha = 1.0;
-  updateTokens();
+  invalidateTokens();
 }
 
-Color::Color(Token &token): Value() {
+Color::Color(const Token &token): Value() {
   int len;
 
   this->tokens.push_back(token);
+  tokensValid = true;
     
   type = Value::COLOR;
   
@@ -138,7 +155,7 @@ Color::Color(unsigned int red, unsigned int green, unsigned int blue): Value() {
   color[RGB_GREEN] = green;
   color[RGB_BLUE] = blue;
   alpha = 1;
-  updateTokens();
+  invalidateTokens();
 }
 Color::Color(unsigned int red, unsigned int green, unsigned int blue,
              double alpha): Value() { 
@@ -147,7 +164,7 @@ Color::Color(unsigned int red, unsigned int green, unsigned int blue,
   color[RGB_GREEN] = green;
   color[RGB_BLUE] = blue;
   this->alpha = alpha;
-  updateTokens();
+  invalidateTokens();
 }
 
 Color* Color::fromHSL(double hue, double saturation, double lightness) {
@@ -207,7 +224,16 @@ Color::Color(const Color &color) {
   this->color[RGB_GREEN] = color.getGreen();
   this->color[RGB_BLUE] = color.getBlue();
   alpha = color.getAlpha();
-  updateTokens();
+  invalidateTokens();
+}
+
+Color& Color::operator=(const Color &color) {
+  this->color[RGB_RED] = color.getRed();
+  this->color[RGB_GREEN] = color.getGreen();
+  this->color[RGB_BLUE] = color.getBlue();
+  alpha = color.getAlpha();
+  invalidateTokens();
+  return *this;
 }
 
 Color::~Color() {
@@ -355,11 +381,11 @@ void Color::setRGB(unsigned int red, unsigned int green, unsigned int blue) {
   color[RGB_RED] = red;
   color[RGB_GREEN] = green;
   color[RGB_BLUE] = blue;
-  updateTokens();
+  invalidateTokens();
 }
 void Color::setAlpha(double alpha) {
   this->alpha = min(max(alpha, 0.0), 1.0);
-  updateTokens();
+  invalidateTokens();
 }
 double Color::getAlpha() const {
   return alpha;
@@ -375,9 +401,9 @@ unsigned int Color::getBlue() const {
   return color[RGB_BLUE];
 }
 
-double* Color::getHSL() const {
+void Color::getHSL(double hsl[3]) const {
   double max, min, c;
-  double rgb[3], * hsl = new double[3];
+  double rgb[3];
 
   for (int i = 0; i < 3; i++)
     rgb[i] = (double)color[i] / 255;
@@ -409,7 +435,6 @@ double* Color::getHSL() const {
     hsl[1] = c / (max + min);
   else
     hsl[1] = c / (2.0 - max - min);
-  return hsl;
 }
 
 
@@ -458,31 +483,39 @@ Value* Color::rgba(const vector<const Value*> &arguments) {
   }
 }
 Value* Color::lighten(const vector<const Value*> &arguments) {
-  double* hsl = ((const Color*)arguments[0])->getHSL();
+  double hsl[3];
   double value = ((const NumberValue*)arguments[1])->getValue();
 
+  ((const Color*)arguments[0])->getHSL(hsl);
+
   return Color::fromHSL(hsl[0], hsl[1] * 100,
                         min(hsl[2] * 100 + value, 100.00));
 }
 Value* Color::darken(const vector<const Value*> &arguments) {
-  double* hsl = ((const Color*)arguments[0])->getHSL();
+  double hsl[3];
   double value = ((const NumberValue*)arguments[1])->getValue();
-  
+
+  ((const Color*)arguments[0])->getHSL(hsl);
+
   return Color::fromHSL(hsl[0], hsl[1] * 100,
                          max(hsl[2] * 100 - value, 0.00));
 }
 Value* Color::saturate(const vector<const Value*> &arguments) {
-  double* hsl = ((const Color*)arguments[0])->getHSL();
+  double hsl[3];
   double value = ((const NumberValue*)arguments[1])->getValue();
 
+  ((const Color*)arguments[0])->getHSL(hsl);
+
   return Color::fromHSL(hsl[0],
                         min(hsl[1] * 100 + value, 100.00),
                         hsl[2] * 100);
 }
 Value* Color::desaturate(const vector<const Value*> &arguments) {
-  double* hsl = ((const Color*)arguments[0])->getHSL();
+  double hsl[3];
   double value = ((const NumberValue*)arguments[1])->getValue();
-  
+
+  ((const Color*)arguments[0])->getHSL(hsl);
+
   return Color::fromHSL(hsl[0],
                         max(hsl[1] * 100 - value, 0.00),
                         hsl[2] * 100);
@@ -511,9 +544,11 @@ Value* Color::fadeout(const vector<const Value*> &arguments) {
 }
 
 Value* Color::spin(const vector<const Value*> &arguments) {
-  double* hsl = ((const Color*)arguments[0])->getHSL();
+  double hsl[3];
   double degrees = ((const NumberValue*)arguments[1])->getValue();
 
+  ((const Color*)arguments[0])->getHSL(hsl);
+
   return Color::fromHSL(std::floor(hsl[0] + degrees),
                          hsl[1] * 100,
                          hsl[2] * 100);
@@ -526,19 +561,25 @@ Value* Color::hsl(const vector<const Value*> &arguments) {
 }
 
 Value* Color::hue(const vector<const Value*> &arguments) {
-  double* hsl = ((const Color*)arguments[0])->getHSL();
+  double hsl[3];
+
+  ((const Color*)arguments[0])->getHSL(hsl);
 
   return new NumberValue(hsl[0]);
 }
 
 Value* Color::saturation(const vector<const Value*> &arguments) {
-  double* hsl = ((const Color*)arguments[0])->getHSL();
+  double hsl[3];
+
+  ((const Color*)arguments[0])->getHSL(hsl);
 
   return new NumberValue(hsl[1] * 100, Token::PERCENTAGE, NULL);
 }
 
 Value* Color::lightness(const vector<const Value*> &arguments) {
-  double* hsl = ((const Color*)arguments[0])->getHSL();
+  double hsl[3];
+
+  ((const Color*)arguments[0])->getHSL(hsl);
 
   return new NumberValue(hsl[2] * 100, Token::PERCENTAGE, NULL);
 }
@@ -19,19 +19,31 @@ class Color: public Value {
 private:
   unsigned int color[3];
   double alpha;
+  mutable bool tokensValid;
   
   double maxArray(double* array, const size_t len) const;
   double minArray(double* array, const size_t len) const;
 
-  void updateTokens();
+  /**
+   * Write the tokens for the current color. Keeps the location of the
+   * first token.
+   */
+  void updateTokens() const;
+
+  /**
+   * Mark the tokens as out of date after the color has changed. They
+   * are written again when getTokens() is called.
+   */
+  void invalidateTokens();
   
 public:
   Color();
-  Color(Token &token);
+  Color(const Token &token);
   Color(unsigned int red, unsigned int green, unsigned int blue);
   Color(unsigned int red, unsigned int green, unsigned int blue,
         double alpha);
   Color(const Color &color);
+  Color& operator=(const Color &color);
 
   /**
    * The HSL to RGB conversion on
@@ -44,6 +56,8 @@ public:
 
   virtual ~Color();
 
+  virtual const TokenList* getTokens() const;
+
   virtual Value* add(const Value &v) const;
   virtual Value* substract(const Value &v) const;
   virtual Value* multiply(const Value &v) const;
@@ -56,8 +70,11 @@ public:
    * Converts the internal RGB value to HSL. The source of the
    * calculations is http://en.wikipedia.org/wiki/HSL_and_HSV except
    * for the saturation value, which did not work.
+   *
+   * @param hsl  array of three doubles that is filled with the hue
+   *             (0-360), saturation (0-1) and lightness (0-1).
    */
-  double* getHSL() const;
+  void getHSL(double hsl[3]) const;
 
   /**
    * Change the color to a new rgb value.
@@ -0,0 +1,30 @@
+#include "Expression.h"
+
+Expression::Expression(Type type, const Token &token): token(token) {
+  this->type = type;
+  interpolate = false;
+  op = 0;
+  left = right = NULL;
+}
+
+Expression::~Expression() {
+  std::vector<Expression*>::iterator it;
+
+  delete left;
+  delete right;
+  for (it = arguments.begin(); it != arguments.end(); it++)
+    delete *it;
+}
+
+CompiledValue::CompiledValue() {
+  valid = true;
+  processing = true;
+  folded = false;
+}
+
+CompiledValue::~CompiledValue() {
+  std::vector<Expression*>::iterator it;
+
+  for (it = statements.begin(); it != statements.end(); it++)
+    delete *it;
+}
@@ -0,0 +1,155 @@
+#ifndef __Expression_h__
+#define __Expression_h__
+
+#include "../Token.h"
+#include "../TokenList.h"
+#include <vector>
+
+/**
+ * Node of a parsed value expression.
+ *
+ * The ValueProcessor compiles a value into a tree of expressions once
+ * and then evaluates the tree against a scope every time the value is
+ * processed, instead of parsing the tokens again. The tree is built by
+ * the same grammar that processes the tokens directly, and evaluated
+ * by the same code that builds the values. The tree only
+ * records what can be decided from the tokens; anything that depends
+ * on the scope, like the value of a variable or whether a function
+ * accepts its arguments, is decided during evaluation.
+ */
+class Expression {
+public:
+  enum Type{
+    /** HASH token; a color. */
+    COLOR,
+    /** NUMBER, PERCENTAGE or DIMENSION token. */
+    NUMBER,
+    /** Identifier that is a unit. */
+    UNIT,
+    /** The identifier 'true'. */
+    BOOLEAN,
+    /** Any other identifier, or a function argument that is not a
+        value. */
+    IDENTIFIER,
+    /** STRING token. */
+    STRING,
+    /** URL token. */
+    URL,
+    /** Escaped string: '~' followed by a string. */
+    ESCAPE,
+    /** ATKEYWORD token; the value of a variable. */
+    VARIABLE,
+    /** '@' followed by an ATKEYWORD token; a variable named by the
+        value of another variable. */
+    DEEP_VARIABLE,
+    /** A function call with arguments. */
+    FUNCTION,
+    /** Two operands and an operator. */
+    OPERATION,
+    /** A statement in parentheses. */
+    SUBSTATEMENT,
+    /** A negated constant. */
+    NEGATIVE,
+    /** Tokens that are copied to the output unprocessed. Only used at
+        the top level of a CompiledValue. */
+    RAW,
+    /** A statement that does not depend on the scope and was evaluated
+        when it was compiled. Only used at the top level of a
+        CompiledValue. */
+    CONSTANT
+  } type;
+
+  /**
+   * The token the expression starts with. Used to create the value and
+   * to set the location of the result.
+   */
+  Token token;
+
+  /**
+   * For STRING, URL and ESCAPE expressions: true if the token contains
+   * a variable that has to be interpolated.
+   */
+  bool interpolate;
+
+  /**
+   * The ValueProcessor::Operator of OPERATION expressions.
+   */
+  int op;
+
+  /**
+   * Operand of SUBSTATEMENT and NEGATIVE expressions, and the first
+   * operand of OPERATION expressions.
+   */
+  Expression* left;
+
+  /**
+   * The second operand of OPERATION expressions.
+   */
+  Expression* right;
+
+  /**
+   * The arguments of FUNCTION expressions.
+   */
+  std::vector<Expression*> arguments;
+
+  /**
+   * For RAW expressions: the tokens to copy. For CONSTANT: the tokens
+   * of the value. For DEEP_VARIABLE: the '@' and ATKEYWORD tokens.
+   */
+  TokenList tokens;
+
+  Expression(Type type, const Token &token);
+  virtual ~Expression();
+
+private:
+  // not copyable
+  Expression(const Expression &e);
+  Expression& operator=(const Expression &e);
+};
+
+/**
+ * A value compiled with ValueProcessor::compileValue(). It is a list
+ * of statements and raw tokens in the order they appear in the value.
+ */
+class CompiledValue {
+public:
+  /**
+   * False if the value could not be compiled; for example because it
+   * contains a syntax error. The value is then processed from its
+   * tokens every time.
+   */
+  bool valid;
+
+  /**
+   * False if the value does not contain anything that needs to be
+   * processed (see ValueProcessor::needsProcessing()).
+   */
+  bool processing;
+
+  /**
+   * True if every statement in the value is constant. The processed
+   * value is then stored in <code>result</code> and processing only
+   * copies it.
+   */
+  bool folded;
+  TokenList result;
+
+  /**
+   * The functions that were called to fold constants, recorded when
+   * the statistics are enabled. They are counted as calls every time
+   * the value is processed.
+   */
+  std::vector<std::string> functions;
+
+  std::vector<Expression*> statements;
+
+  CompiledValue();
+  virtual ~CompiledValue();
+
+private:
+  // not copyable
+  CompiledValue(const CompiledValue &v);
+  CompiledValue& operator=(const CompiledValue &v);
+};
+
+#endif
@@ -1,23 +1,123 @@
-
 #include "FunctionLibrary.h"
+#include "NumberValue.h"
+#include "Color.h"
+#include "StringValue.h"
+#include "UrlValue.h"
+
+#include <climits>
+
+FunctionLibrary::FunctionLibrary() {
+  NumberValue::loadFunctions(*this);
+  Color::loadFunctions(*this);
+  StringValue::loadFunctions(*this);
+  UrlValue::loadFunctions(*this);
+  buildTable();
+}
+
+FunctionLibrary::~FunctionLibrary() {
+  std::vector<FuncInfo*>::iterator it;
+
+  for (it = functions.begin(); it != functions.end(); it++)
+    delete *it;
+}
+
+const FunctionLibrary& FunctionLibrary::getInstance() {
+  static const FunctionLibrary library;
+  return library;
+}
+
+size_t FunctionLibrary::hash(const char* str, unsigned int seed) {
+  // FNV-1a
+  size_t h = 2166136261u ^ seed;
+
+  for (; *str != '\0'; str++) {
+    h ^= (unsigned char)*str;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+void FunctionLibrary::buildTable() {
+  size_t size = 1;
+  unsigned int s;
+
+  while (size < functions.size() * 2)
+    size <<= 1;
+
+  for (;; size <<= 1) {
+    for (s = 0; s < 256; s++) {
+      if (fillTable(size, s))
+        return;
+    }
+  }
+}
+
+bool FunctionLibrary::fillTable(size_t size, unsigned int seed) {
+  std::vector<FuncInfo*>::const_iterator it;
+  const FuncInfo** slot;
+
+  table.assign(size, NULL);
+  this->seed = seed;
+  
+  for (it = functions.begin(); it != functions.end(); it++) {
+    slot = &table[hash((*it)->name.c_str(), seed) & (size - 1)];
+    if (*slot != NULL)
+      return false;
+    *slot = *it;
+  }
+  return true;
+}
 
 const FuncInfo* FunctionLibrary::getFunction(const char* functionName) const {
-  std::map<std::string, FuncInfo*>::const_iterator i =
-    map.find(functionName);
+  const FuncInfo* fi;
 
-  if (i != map.end())
-    return i->second;
+  if (table.empty())
+    return NULL;
+  
+  fi = table[hash(functionName, seed) & (table.size() - 1)];
+  if (fi != NULL && fi->name.compare(functionName) == 0)
+    return fi;
   else
     return NULL;
 }
 
 void FunctionLibrary::push(string name, const char* parameterTypes,
-                           Value* (*func)(const vector<const Value*> &arguments))
+                           Value* (*func)(const vector<const Value*> &arguments),
+                           bool pure)
 {
+  std::vector<FuncInfo*>::iterator it;
   FuncInfo* fi = new FuncInfo();
+  unsigned int i, len = strlen(parameterTypes);
+  
+  fi->name = name;
   fi->parameterTypes = parameterTypes;
   fi->func = func;
-  map[name] = fi;
+  fi->pure = pure;
+  fi->minArguments = fi->maxArguments = 0;
+
+  for (i = 0; i < len; i++) {
+    if (i + 1 < len && parameterTypes[i + 1] == '+') {
+      fi->maxArguments = UINT_MAX;
+      i++;
+      continue;
+    }
+    if (i + 1 < len && parameterTypes[i + 1] == '?')
+      i++;
+    else
+      fi->minArguments++;
+    if (fi->maxArguments != UINT_MAX)
+      fi->maxArguments++;
+  }
+
+  // a function pushed again replaces the earlier one
+  for (it = functions.begin(); it != functions.end(); it++) {
+    if ((*it)->name == name) {
+      delete *it;
+      *it = fi;
+      return;
+    }
+  }
+  functions.push_back(fi);
 }
 
 bool FunctionLibrary::checkArguments(const FuncInfo* fi,
@@ -25,8 +125,13 @@ bool FunctionLibrary::checkArguments(const FuncInfo* fi,
                                      &arguments) const {
   const char* types = fi->parameterTypes;
   vector<const Value*>::const_iterator it = arguments.begin();
-  unsigned int i, len = strlen(types);
-  
+  unsigned int i, len;
+
+  if (arguments.size() < fi->minArguments ||
+      arguments.size() > fi->maxArguments)
+    return false;
+
+  len = strlen(types);
   for (i = 0; i < len; i++) {
     if (it == arguments.end()) {
       if (i + 1 < len && 
@@ -63,7 +168,7 @@ bool FunctionLibrary::checkArguments(const FuncInfo* fi,
   return true;
 }
 
-const char* FunctionLibrary::functionDefToString (const char* functionName, const FuncInfo* fi) {
+const char* FunctionLibrary::functionDefToString (const char* functionName, const FuncInfo* fi) const {
   
   if (fi == NULL)
     fi = getFunction(functionName);
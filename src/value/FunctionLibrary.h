@@ -1,32 +1,73 @@
-
 #ifndef __FunctionLibrary_h__
 #define __FunctionLibrary_h__
 
-#include <map>
 #include <vector>
+#include <string>
 #include <cstring>
 #include "Value.h"
 
 typedef struct FuncInfo {
+  std::string name;
   const char* parameterTypes;
   Value* (*func)(const vector<const Value*> &arguments);
+  /**
+   * False if the result depends on anything besides the arguments,
+   * like the contents of a file. Only pure functions are evaluated
+   * when a value is compiled.
+   */
+  bool pure;
+  /**
+   * The number of arguments the parameter types allow. maxArguments is
+   * UINT_MAX if the last parameter is repeated ('+').
+   */
+  unsigned int minArguments, maxArguments;
 } FuncInfo;
 
+/**
+ * The LESS functions, shared by all compilations in the process.
+ *
+ * The library is built once on first use and can't be changed after
+ * that. Names are looked up in a table indexed by a seeded hash; the
+ * seed and table size are chosen when the library is built so no two
+ * names share a slot, which makes a lookup one hash and one string
+ * comparison.
+ */
 class FunctionLibrary {
 private:
-  std::map<std::string, FuncInfo*> map;
+  std::vector<FuncInfo*> functions;
+  std::vector<const FuncInfo*> table;
+  unsigned int seed;
+
+  FunctionLibrary();
+
+  static size_t hash(const char* str, unsigned int seed);
 
+  /**
+   * Find a seed and a table size for which every function has a slot
+   * to itself.
+   */
+  void buildTable();
+  bool fillTable(size_t size, unsigned int seed);
 
 public:
+  virtual ~FunctionLibrary();
+
+  /**
+   * Returns the library, loading the functions of NumberValue, Color,
+   * StringValue and UrlValue the first time it is called.
+   */
+  static const FunctionLibrary& getInstance();
+
   const FuncInfo* getFunction(const char* functionName) const;
 
   void push(string name, const char* parameterTypes,
-            Value* (*func)(const vector<const Value*> &arguments));
-  
+            Value* (*func)(const vector<const Value*> &arguments),
+            bool pure = true);
+
   bool checkArguments(const FuncInfo* fi,
                       const vector<const Value*> &arguments) const;
   const char* functionDefToString(const char* functionName,
-                                  const FuncInfo* fi = NULL);
+                                  const FuncInfo* fi = NULL) const;
 };
 
 #endif
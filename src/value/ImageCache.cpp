@@ -0,0 +1,70 @@
+#include "ImageCache.h"
+#include "../WorkingDirectory.h"
+
+#include <config.h>
+
+thread_local std::vector<std::pair<std::string, std::string> >*
+ImageCache::recording = NULL;
+
+ImageCache::ImageCache() {
+}
+
+ImageCache& ImageCache::getInstance() {
+  static ImageCache cache;
+  return cache;
+}
+
+long ImageCache::getNsec(const struct stat &st) {
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+  return st.st_mtim.tv_nsec;
+#else
+  (void)st;
+  return 0;
+#endif
+}
+
+bool ImageCache::get(const std::string &path, const struct stat &st,
+                     bool &loaded, UrlValue_Img &img,
+                     std::string &hash) {
+  std::unordered_map<std::string, Entry>::iterator it;
+  std::string key = WorkingDirectory::getKey(path);
+  std::unique_lock<std::mutex> l(lock);
+
+  it = entries.find(key);
+  if (it == entries.end() ||
+      it->second.mtime != st.st_mtime ||
+      it->second.mtime_nsec != getNsec(st) ||
+      it->second.size != st.st_size)
+    return false;
+
+  loaded = it->second.loaded;
+  img = it->second.img;
+  hash = it->second.hash;
+  return true;
+}
+
+void ImageCache::put(const std::string &path, const struct stat &st,
+                     bool loaded, const UrlValue_Img &img,
+                     const std::string &hash) {
+  std::string key = WorkingDirectory::getKey(path);
+  std::unique_lock<std::mutex> l(lock);
+  Entry &entry = entries[key];
+
+  entry.loaded = loaded;
+  entry.img = img;
+  entry.mtime = st.st_mtime;
+  entry.mtime_nsec = getNsec(st);
+  entry.size = st.st_size;
+  entry.hash = hash;
+}
+
+void ImageCache::setRecording(std::vector<std::pair<std::string,
+                              std::string> >* paths) {
+  recording = paths;
+}
+
+void ImageCache::record(const std::string &path,
+                        const std::string &hash) {
+  if (recording != NULL)
+    recording->push_back(std::make_pair(path, hash));
+}
@@ -0,0 +1,76 @@
+#ifndef __ImageCache_h__
+#define __ImageCache_h__
+
+#include "UrlValue.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <utility>
+#include <mutex>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+/**
+ * Process wide cache of the size and background color of the images
+ * that imgwidth(), imgheight() and imgbackground() look at, so an
+ * image is decoded once for all the stylesheets compiled by the
+ * process. An entry is dropped when the modification time or size of
+ * the file changes. Files that exist but could not be loaded as an
+ * image are cached too. Relative paths are cached per working
+ * directory.
+ *
+ * The cache is thread safe.
+ */
+class ImageCache {
+private:
+  struct Entry {
+    bool loaded;
+    UrlValue_Img img;
+    time_t mtime;
+    long mtime_nsec;
+    off_t size;
+    std::string hash;
+  };
+  
+  std::unordered_map<std::string, Entry> entries;
+  std::mutex lock;
+  static thread_local std::vector<std::pair<std::string,
+                                            std::string> >* recording;
+
+  ImageCache();
+  
+  static long getNsec(const struct stat &st);
+
+public:
+  static ImageCache& getInstance();
+
+  /**
+   * Look up the image at <code>path</code>, where <code>st</code> is
+   * the current status of the file.
+   *
+   * @return false if the image is not cached or it has changed,
+   *         otherwise true, with <code>loaded</code> set to whether the
+   *         image could be loaded, <code>img</code> to its details and
+   *         <code>hash</code> to the digest of the file it was
+   *         loaded from.
+   */
+  bool get(const std::string &path, const struct stat &st,
+           bool &loaded, UrlValue_Img &img, std::string &hash);
+
+  void put(const std::string &path, const struct stat &st,
+           bool loaded, const UrlValue_Img &img,
+           const std::string &hash);
+
+  /**
+   * Add the paths of the images looked at on this thread, and the
+   * digests of their contents, to <code>paths</code> from now on, or
+   * stop if it is NULL. Images that don't exist get an empty digest. A compilation uses this to find the images its
+   * output depends on.
+   */
+  static void setRecording(std::vector<std::pair<std::string,
+                           std::string> >* paths);
+  static void record(const std::string &path, const std::string &hash);
+};
+
+#endif
@@ -1,8 +1,20 @@
 
 #include "NumberValue.h"
 
+#include <cstdio>
+#include <cstdlib>
+
+/**
+ * True if c can be part of the number at the start of a token.
+ */
+static inline bool isNumberChar(char c) {
+  return isdigit(c) || c == '.' || c == '-';
+}
+
 NumberValue::NumberValue(const Token &token) {
   tokens.push_back(token);
+  tokensValid = true;
+  parseNumber(token);
   
   switch(token.type) {
   case Token::NUMBER:
@@ -26,6 +38,7 @@ NumberValue::NumberValue(double value) {
 }
 NumberValue::NumberValue(double value, Token::Type type, const
                          std::string* unit) {
+  tokensValid = true;
   if (type != Token::NUMBER &&
       type != Token::PERCENTAGE &&
       type != Token::DIMENSION) {
@@ -40,29 +53,27 @@ NumberValue::NumberValue(double value, Token::Type type, const
   switch(type) {
   case Token::NUMBER:
     this->type = NUMBER;
+    setNumber(value, "");
     break;
   case Token::PERCENTAGE:
     this->type = PERCENTAGE;
+    setNumber(value, "%");
     break;
   case Token::DIMENSION:
     this->type = DIMENSION;
+    setNumber(value, *unit);
     break;
   default:
     break;
   }
-
-  ostringstream stm;
-  stm << setprecision(10) << value;
-  if (type == Token::DIMENSION)
-    stm << *unit;
-  else if (type == Token::PERCENTAGE)
-    stm << "%";
-  tokens.front() = stm.str();
 }
 
 NumberValue::NumberValue(const NumberValue &n) {
   tokens.push_back(n.getTokens()->front());
+  tokensValid = true;
   this->type = n.type;
+  value = n.value;
+  unitString = n.unitString;
 }
 
 NumberValue::~NumberValue() {
@@ -247,41 +258,14 @@ void NumberValue::setType(const NumberValue &n) {
 }
 
 double NumberValue::getValue() const {
-  string number;
-  istringstream stm;
-  double ret;
-  char c;
-
-  for (unsigned int i = 0; i < tokens.front().size(); i++) {
-    c = tokens.front()[i];
-    if (!isdigit(c) && c != '.' && c != '-') {
-      number = tokens.front().substr(0, i);
-      break;
-    }
-  }
-  if (number == "")
-    number = tokens.front();
-  stm.str(number);
-  stm >>ret;
-  return ret;
+  return value;
 }
 string NumberValue::getUnit () const {
-  char c;
-  unsigned int i;
-  
-  for (i = 0; i < tokens.front().size(); i++) {
-    c = tokens.front()[i];
-    if (!isdigit(c) && c != '.' && c != '-')
-      return tokens.front().substr(i);
-  }
-  return string("");
+  return unitString;
 }
 
 void NumberValue::setUnit(string unit) {
-  ostringstream stm;
-  stm << setprecision(10) << getValue();
-  stm << unit;
-  tokens.front() = stm.str();
+  setNumber(getValue(), unit);
   
   if (unit.length() == 0) {
     type = NUMBER;
@@ -293,13 +277,68 @@ void NumberValue::setUnit(string unit) {
 }
 
 void NumberValue::setValue(double d) {
-  ostringstream stm;
-  stm << setprecision(10) << d;
   if (type == DIMENSION)
-    stm << getUnit();
+    setNumber(d, getUnit());
   else if (type == PERCENTAGE)
-    stm << "%";
-  tokens.front() = stm.str();
+    setNumber(d, "%");
+  else
+    setNumber(d, "");
+}
+
+void NumberValue::parseNumber(const std::string &str) {
+  char buffer[64];
+  istringstream stm;
+  size_t i;
+
+  for (i = 0; i < str.size() && isNumberChar(str[i]); i++);
+
+  unitString = str.substr(i);
+  
+  if (i > 0 && i < sizeof(buffer)) {
+    str.copy(buffer, i);
+    buffer[i] = '\0';
+    value = strtod(buffer, NULL);
+  } else {
+    if (i > 0)
+      stm.str(str.substr(0, i));
+    else
+      stm.str(str);
+    if (!(stm >> value))
+      value = 0;
+  }
+}
+
+void NumberValue::setNumber(double d, const std::string &suffix) {
+  char buffer[32];
+  const char* c;
+
+  snprintf(buffer, sizeof(buffer), "%.10g", d);
+
+  for (c = buffer; *c != '\0' && isNumberChar(*c); c++);
+
+  if (*c == '\0' &&
+      (suffix.empty() || !isNumberChar(suffix[0]))) {
+    value = strtod(buffer, NULL);
+    unitString = suffix;
+    tokensValid = false;
+  } else {
+    // Exponents, 'inf' and 'nan' end up in the unit when the token is
+    // read back.
+    tokens.front() = std::string(buffer) + suffix;
+    parseNumber(tokens.front());
+    tokensValid = true;
+  }
+}
+
+const TokenList* NumberValue::getTokens() const {
+  char buffer[32];
+
+  if (!tokensValid) {
+    snprintf(buffer, sizeof(buffer), "%.10g", value);
+    tokens.front() = std::string(buffer) + unitString;
+    tokensValid = true;
+  }
+  return &tokens;
 }
 
 bool NumberValue::isNumber(const Value &val) {
@@ -9,9 +9,32 @@
 #include <cmath>
 class FunctionLibrary;
 
+/**
+ * Number, percentage or dimension.
+ *
+ * The number and unit are kept as a double and a string; the token is
+ * only written when getTokens() is called, so a chain of operations
+ * does not format and parse the number at every step.
+ */
 class NumberValue: public Value {
+  double value;
+  std::string unitString;
+  mutable bool tokensValid;
+
   static bool isNumber(const Value &val);
 
+  /**
+   * Set the number and unit to those of the token text
+   * <code>str</code>.
+   */
+  void parseNumber(const std::string &str);
+
+  /**
+   * Set the number to <code>d</code>, rounded the way it is when it
+   * is written to a token, followed by <code>suffix</code>.
+   */
+  void setNumber(double d, const std::string &suffix);
+
   void verifyUnits(const NumberValue &n);
   double convert(const std::string &unit) const;
   
@@ -22,6 +45,8 @@ public:
               const std::string* unit);
   NumberValue(const NumberValue &n);
   virtual ~NumberValue();
+
+  virtual const TokenList* getTokens() const;
   
   virtual Value* add(const Value &v) const;
   virtual Value* substract(const Value &v) const;
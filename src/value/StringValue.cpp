@@ -181,7 +181,7 @@ void StringValue::loadFunctions(FunctionLibrary &lib) {
   lib.push("%", "S.+", &StringValue::format);
   lib.push("replace", "SSSS?", &StringValue::replace);
   lib.push("color", "S", &StringValue::color);
-  lib.push("data-uri", "SS?", &StringValue::data_uri);
+  lib.push("data-uri", "SS?", &StringValue::data_uri, false);
 }
 
 Value* StringValue::escape(const vector<const Value*> &arguments) {
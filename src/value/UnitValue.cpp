@@ -1,7 +1,7 @@
 
 #include "UnitValue.h"
 
-UnitValue::UnitValue(Token &token) {
+UnitValue::UnitValue(const Token &token) {
   tokens.push_back(token);
   type = UNIT;
 }
@@ -13,7 +13,7 @@ class UnitValue: public Value {
 public:
   enum UnitGroup {NO_GROUP, LENGTH, TIME, ANGLE};
   
-  UnitValue(Token &token);
+  UnitValue(const Token &token);
   virtual ~UnitValue();
 
   const char* getUnit() const;
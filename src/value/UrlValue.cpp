@@ -1,5 +1,7 @@
 
 #include "UrlValue.h"
+#include "ImageCache.h"
+#include "../Sha256.h"
 
 #include <config.h>
 
@@ -10,6 +12,28 @@
 
 #ifdef WITH_LIBPNG
 #include <png.h>
+#include <cstring>
+
+/**
+ * The part of an InputBuffer that libpng has not read yet.
+ */
+struct urlvalue_png_source {
+  const char* data;
+  size_t length;
+};
+
+static void urlvalue_png_read(png_structp png_ptr, png_bytep data,
+                              png_size_t length) {
+  urlvalue_png_source* source =
+    (urlvalue_png_source*)png_get_io_ptr(png_ptr);
+
+  if (length > source->length)
+    png_error(png_ptr, "Read past the end of the file");
+  
+  std::memcpy(data, source->data, length);
+  source->data += length;
+  source->length -= length;
+}
 #endif
 
 #ifdef WITH_LIBJPEG
@@ -117,34 +141,61 @@ BooleanValue* UrlValue::equals(const Value &v) const {
 }
 
 bool UrlValue::loadImg(UrlValue_Img &img) const {
-  return loadPng(img) || loadJpeg(img);
+  std::string path = getRelativePath();
+  ImageCache &cache = ImageCache::getInstance();
+  struct stat st;
+  bool loaded;
+  // a file that can't be read hashes like an empty file; neither is
+  // an image
+  std::string hash = Sha256::hash(NULL, 0);
+
+  // the loaders can't open it either. It is recorded as missing, so
+  // an image created at the path is noticed.
+  if (stat(path.c_str(), &st) != 0) {
+    ImageCache::record(path, std::string());
+    return false;
+  }
+  
+  if (!cache.get(path, st, loaded, img, hash)) {
+    // the image is decoded from the same bytes that are hashed
+    try {
+      InputBuffer in(path.c_str());
+      
+      hash = Sha256::hash(in.getData(), in.getLength());
+      loaded = loadPng(img, in) || loadJpeg(img, in);
+    } catch (IOException* e) {
+      delete e;
+      loaded = false;
+    }
+    cache.put(path, st, loaded, img, hash);
+  }
+  
+  ImageCache::record(path, hash);
+  return loaded;
 }
 
-bool UrlValue::loadPng(UrlValue_Img &img) const {
+bool UrlValue::loadPng(UrlValue_Img &img, const InputBuffer &in) const {
 
 #ifdef WITH_LIBPNG
-  unsigned char header[8];    // 8 is the maximum size that can be checked
-  /* open file and test for it being a png */
+  /* test for the file being a png */
   
   png_structp png_ptr;
   png_infop info_ptr;
   png_byte color_type;
   int channels;
-  
-  std::string path = getRelativePath();
+  urlvalue_png_source source;
   
 #ifdef WITH_LIBGLOG
-  VLOG(3) << "PNG path: " << path;
+  VLOG(3) << "PNG path: " << getRelativePath();
 #endif
-    
-  FILE *fp = fopen(path.c_str(), "rb");
-  if (!fp)
-    return false; //"Image file could not be opened"
 
-  fread(header, 1, 8, fp);
-  
-  if (png_sig_cmp(header, 0, 8))
+  // 8 is the maximum size that can be checked
+  if (in.getLength() < 8 ||
+      png_sig_cmp((png_bytep)in.getData(), 0, 8)) {
     return false; //"Image is not a PNG file"
+  }
+  source.data = in.getData() + 8;
+  source.length = in.getLength() - 8;
 
   /* initialize stuff */
   png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
@@ -162,7 +213,7 @@ bool UrlValue::loadPng(UrlValue_Img &img) const {
     throw new ValueException("Error during init_io",
                              *this->getTokens());
 
-  png_init_io(png_ptr, fp);
+  png_set_read_fn(png_ptr, &source, urlvalue_png_read);
   png_set_sig_bytes(png_ptr, 8);
 
   png_read_info(png_ptr, info_ptr);
@@ -199,7 +250,6 @@ bool UrlValue::loadPng(UrlValue_Img &img) const {
   png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
   png_ptr = NULL;
   info_ptr = NULL;
-  fclose(fp);
   
 #ifdef WITH_LIBGLOG
   VLOG(3) << "Read successful";
@@ -208,25 +258,21 @@ bool UrlValue::loadPng(UrlValue_Img &img) const {
   return true;
   
 #else
+  (void)img;
+  (void)in;
   return false;
 #endif  
 }
 
 
-bool UrlValue::loadJpeg(UrlValue_Img &img) const {
+bool UrlValue::loadJpeg(UrlValue_Img &img, const InputBuffer &in) const {
 #ifdef WITH_LIBJPEG
   struct jpeg_decompress_struct cinfo;
   
   struct urlvalue_jpeg_error_mgr jerr;
   /* More stuff */
-  FILE * infile;
   JSAMPARRAY buffer;	/* Output row buffer */
   int row_stride;	/* physical row width in output buffer */
-  std::string path = getRelativePath();
-  
-  if ((infile = fopen(path.c_str(), "rb")) == NULL) {
-    return false;
-  }
 
   /* Step 1: allocate and initialize JPEG decompression object */
 
@@ -236,18 +282,17 @@ bool UrlValue::loadJpeg(UrlValue_Img &img) const {
   /* Establish the setjmp return context for urlvalue_jpeg_error_exit to use. */
   if (setjmp(jerr.setjmp_buffer)) {
     /* If we get here, the JPEG code has signaled an error.
-     * We need to clean up the JPEG object, close the input file, and return.
+     * We need to clean up the JPEG object and return.
      */
     jpeg_destroy_decompress(&cinfo);
-    fclose(infile);
     return false;
   }
   /* Now we can initialize the JPEG decompression object. */
   jpeg_create_decompress(&cinfo);
 
-  /* Step 2: specify data source (eg, a file) */
+  /* Step 2: specify data source, the contents of the file */
 
-  jpeg_stdio_src(&cinfo, infile);
+  jpeg_mem_src(&cinfo, (unsigned char*)in.getData(), in.getLength());
 
   /* Step 3: read file parameters with jpeg_read_header() */
 
@@ -331,14 +376,10 @@ bool UrlValue::loadJpeg(UrlValue_Img &img) const {
   /* This is an important step since it will release a good deal of memory. */
   jpeg_destroy_decompress(&cinfo);
 
-  /* After finish_decompress, we can close the input file.
-   * Here we postpone it until after no more JPEG errors are possible,
-   * so as to simplify the setjmp error logic above. (Actually, I don't
-   * think that jpeg_destroy can do an error exit, but why assume anything...)
-   */
-  fclose(infile);
   return true;
 #else
+  (void)img;
+  (void)in;
   return false;
 #endif
 }
@@ -360,9 +401,9 @@ Color UrlValue::getImageBackground() const {
 
 
 void UrlValue::loadFunctions(FunctionLibrary &lib) {
-  lib.push("imgheight", "R", &UrlValue::imgheight);
-  lib.push("imgwidth", "R", &UrlValue::imgwidth);
-  lib.push("imgbackground", "R", &UrlValue::imgbackground);
+  lib.push("imgheight", "R", &UrlValue::imgheight, false);
+  lib.push("imgwidth", "R", &UrlValue::imgwidth, false);
+  lib.push("imgbackground", "R", &UrlValue::imgbackground, false);
 }
 
 
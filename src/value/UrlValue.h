@@ -4,6 +4,7 @@
 
 #include "Value.h"
 #include "Color.h"
+#include "../css/InputBuffer.h"
 #include <string>
 
 class UrlValue_Img {
@@ -21,8 +22,8 @@ private:
   std::string path;
 
   bool loadImg(UrlValue_Img &img) const;
-  bool loadPng(UrlValue_Img &img) const;
-  bool loadJpeg(UrlValue_Img &img) const;
+  bool loadPng(UrlValue_Img &img, const InputBuffer &in) const;
+  bool loadJpeg(UrlValue_Img &img, const InputBuffer &in) const;
 
 public:
   UrlValue(Token &token, std::string &path);
@@ -5,15 +5,20 @@
 #include "../Token.h"
 #include "../TokenList.h"
 #include "ValueException.h"
+#include "../Arena.h"
 
 class BooleanValue;
 
 /**
  * 
  */
-class Value {
+class Value: public ArenaObject {
 protected:
-  TokenList tokens;
+  /**
+   * Mutable so subclasses can write the tokens when they are first
+   * requested with getTokens().
+   */
+  mutable TokenList tokens;
   
 public:
   enum Type {NUMBER, PERCENTAGE, DIMENSION, COLOR, STRING, UNIT,
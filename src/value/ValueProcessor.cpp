@@ -1,5 +1,8 @@
 
 #include "ValueProcessor.h"
+#include "../Statistics.h"
+
+#include <iterator>
 
 #include <config.h>
 #ifdef WITH_LIBGLOG
@@ -18,11 +21,289 @@ inline std::string to_string (const T& t)
 }
 */
 
-ValueProcessor::ValueProcessor() {
-  NumberValue::loadFunctions(functionLibrary);
-  Color::loadFunctions(functionLibrary);
-  StringValue::loadFunctions(functionLibrary);
-  UrlValue::loadFunctions(functionLibrary);  
+/**
+ * Scope without any variables. Constant statements are evaluated in it
+ * when a value is compiled.
+ */
+class EmptyScope: public ValueScope {
+public:
+  virtual const TokenList* getVariable(Symbol) const {
+    return NULL;
+  }
+};
+
+/**
+ * Builds values for the grammar of ValueProcessor as it parses:
+ * variables are looked up and functions are called as soon as they
+ * are read. A result of NULL means the tokens are not a value in this
+ * scope, and the grammar backs up.
+ *
+ * The compiled expressions are evaluated with the same builder, so a
+ * value that is processed from its tokens and one that is evaluated
+ * from its compiled form give the same result.
+ */
+class ValueProcessor::ValueBuilder {
+public:
+  typedef Value* Result;
+  
+  const ValueProcessor &processor;
+  const ValueScope &scope;
+  /**
+   * If not NULL the functions that are called are added to it instead
+   * of being counted.
+   */
+  std::vector<std::string>* calls;
+
+  ValueBuilder(const ValueProcessor &processor, const ValueScope &scope):
+    processor(processor), scope(scope), calls(NULL) {
+  }
+
+  Value* color(const Token &token) {
+    // generate color from hex value
+    return new Color(token);
+  }
+  Value* number(const Token &token) {
+    return new NumberValue(token);
+  }
+  Value* unit(const Token &token) {
+    return new UnitValue(token);
+  }
+  Value* boolean(const Token &token) {
+    return new BooleanValue(token, true);
+  }
+  Value* identifier(const Token &token) {
+    return new StringValue(token, false);
+  }
+  
+  Value* string(const Token &token) {
+    Token t = token;
+    bool hasQuotes = t.stringHasQuotes();
+
+    processor.interpolate(t, scope);
+    t.removeQuotes();
+    return new StringValue(t, hasQuotes);
+  }
+  
+  Value* escape(const Token &token) {
+    Token t = token;
+
+    processor.interpolate(t, scope);
+    t.removeQuotes();
+    return new StringValue(t, false);
+  }
+  
+  Value* url(const Token &token) {
+    Token t = token;
+    std::string str;
+
+    processor.interpolate(t, scope);
+    str = t.getUrlString();
+#ifdef WITH_LIBGLOG
+    VLOG(3) << "url: " << str;
+#endif
+    return new UrlValue(t, str);
+  }
+
+  Value* variable(const Token &token) {
+    const TokenList* var = scope.getVariable(token.getSymbol());
+    Value* ret;
+
+    if (var == NULL)
+      return NULL;
+    if ((ret = processor.processStatement(*var, scope)) != NULL) {
+      ret->setLocation(token);
+#ifdef WITH_LIBGLOG
+      VLOG(3) << "Variable value: " << ret->getTokens()->toString();
+#endif
+    }
+    return ret;
+  }
+
+  Value* deepVariable(const Token &at, const Token &name) {
+    const TokenList* var = processor.getDeepVariable(name, scope);
+    Value* ret;
+
+    if (var == NULL)
+      return NULL;
+    if ((ret = processor.processStatement(*var, scope)) != NULL)
+      ret->setLocation(at);
+    return ret;
+  }
+
+  /**
+   * Call <code>function</code>. The caller deletes the arguments.
+   */
+  Value* function(const Token &function, std::vector<Value*> &arguments) {
+    vector<const Value*> args(arguments.begin(), arguments.end());
+    const FuncInfo* fi;
+    Value* ret = NULL;
+
+#ifdef WITH_LIBGLOG
+    VLOG(3) << "Function: " << function;
+#endif
+    
+    if ((fi = processor.functionLibrary.getFunction(function.c_str())) ==
+        NULL)
+      return NULL;
+
+    try {
+      if (processor.functionLibrary.checkArguments(fi, args)) {
+        if (calls != NULL)
+          calls->push_back(function);
+        else
+          Statistics::countFunction(function);
+        ret = fi->func(args);
+        ret->setLocation(function);
+      }
+      
+      // If an exception is thrown, processing failed, and we assume
+      // this isn't a function.
+    } catch (ValueException* e) {
+      delete e;
+      ret = NULL;
+    } catch (ParseException* e) {
+      delete e;
+      ret = NULL;
+    }
+    return ret;
+  }
+
+  Value* operation(Operator op, const Token &token,
+                   Value* operand1, Value* operand2) {
+    Value* ret;
+    
+#ifdef WITH_LIBGLOG
+    VLOG(3) << "Operation: " << operand1->getTokens()->toString() << 
+      "(" << Value::typeToString(operand1->type) <<  ") " <<
+      processor.operatorToString(op) << " " <<
+      operand2->getTokens()->toString() << "(" <<
+      Value::typeToString(operand2->type) << ")";
+#endif
+    
+    ret = processor.applyOperator(op, *operand1, *operand2);
+    delete operand1;
+    delete operand2;
+    ret->setLocation(token);
+    return ret;
+  }
+
+  Value* substatement(const Token &paren, Value* statement) {
+    statement->setLocation(paren);
+    return statement;
+  }
+
+  Value* negative(const Token &minus, Value* constant) {
+    Token t_zero("0", Token::NUMBER, 0,0,"generated");
+    Value *zero, *ret;
+    
+#ifdef WITH_LIBGLOG
+    VLOG(3) << "Negate: " << constant->getTokens()->toString();
+#endif
+    
+    zero = new NumberValue(t_zero);
+    ret = zero->substract(*constant);
+    ret->setLocation(minus);
+  
+    delete constant;
+    delete zero;
+    return ret;
+  }
+};
+
+/**
+ * Builds a tree of Expressions for the grammar of ValueProcessor
+ * without looking at a scope, so it assumes that variables and
+ * functions evaluate to values.
+ */
+class ValueProcessor::ExpressionBuilder {
+public:
+  typedef Expression* Result;
+
+  Expression* color(const Token &token) {
+    return new Expression(Expression::COLOR, token);
+  }
+  Expression* number(const Token &token) {
+    return new Expression(Expression::NUMBER, token);
+  }
+  Expression* unit(const Token &token) {
+    return new Expression(Expression::UNIT, token);
+  }
+  Expression* boolean(const Token &token) {
+    return new Expression(Expression::BOOLEAN, token);
+  }
+  Expression* identifier(const Token &token) {
+    return new Expression(Expression::IDENTIFIER, token);
+  }
+
+  Expression* string(const Token &token) {
+    return interpolated(Expression::STRING, token);
+  }
+  Expression* escape(const Token &token) {
+    return interpolated(Expression::ESCAPE, token);
+  }
+  Expression* url(const Token &token) {
+    return interpolated(Expression::URL, token);
+  }
+  
+  Expression* variable(const Token &token) {
+    return new Expression(Expression::VARIABLE, token);
+  }
+
+  Expression* deepVariable(const Token &at, const Token &name) {
+    Expression* e = new Expression(Expression::DEEP_VARIABLE, at);
+
+    e->tokens.push_back(at);
+    e->tokens.push_back(name);
+    return e;
+  }
+
+  /**
+   * Takes over the arguments.
+   */
+  Expression* function(const Token &function,
+                       std::vector<Expression*> &arguments) {
+    Expression* e = new Expression(Expression::FUNCTION, function);
+
+    e->arguments.swap(arguments);
+    return e;
+  }
+
+  Expression* operation(Operator op, const Token &token,
+                        Expression* operand1, Expression* operand2) {
+    Expression* e = new Expression(Expression::OPERATION, token);
+
+    e->op = op;
+    e->left = operand1;
+    e->right = operand2;
+    return e;
+  }
+
+  Expression* substatement(const Token &paren, Expression* statement) {
+    Expression* e = new Expression(Expression::SUBSTATEMENT, paren);
+
+    e->left = statement;
+    return e;
+  }
+
+  Expression* negative(const Token &minus, Expression* constant) {
+    Expression* e = new Expression(Expression::NEGATIVE, minus);
+
+    e->left = constant;
+    return e;
+  }
+
+private:
+  Expression* interpolated(Expression::Type type, const Token &token) {
+    Expression* e = new Expression(type, token);
+
+    e->interpolate = (token.find("@{") != std::string::npos);
+    return e;
+  }
+};
+
+
+ValueProcessor::ValueProcessor():
+  functionLibrary(FunctionLibrary::getInstance()) {
 }
 ValueProcessor::~ValueProcessor() {
 }
@@ -36,6 +317,8 @@ void ValueProcessor::processValue(TokenList &value, const ValueScope &scope)
   TokenList variable;
   const TokenList* oldvalue = &value;
   TokenList::const_iterator i2, itmp, end;
+
+  Statistics::count(Statistics::VALUES);
   
   if (!needsProcessing(value)) {
     // interpolate strings
@@ -73,18 +356,21 @@ void ValueProcessor::processValue(TokenList &value, const ValueScope &scope)
     }
     
     if (v != NULL) {
+      // the value is deleted right after, so take over its tokens
       newvalue.insert(newvalue.end(),
-                      v->getTokens()->begin(),
-                      v->getTokens()->end());
+                      std::make_move_iterator(v->getTokens()->begin()),
+                      std::make_move_iterator(v->getTokens()->end()));
       delete v;
     } else if (i2 != end) {
       // variable containing a non-value.
       if ((*i2).type == Token::ATKEYWORD &&
-          (var = scope.getVariable(*i2)) != NULL) {
+          (var = scope.getVariable((*i2).getSymbol())) != NULL) {
         variable = *var;
         processValue(variable, scope);
         
-        newvalue.insert(newvalue.end(), variable.begin(), variable.end());
+        newvalue.insert(newvalue.end(),
+                        std::make_move_iterator(variable.begin()),
+                        std::make_move_iterator(variable.end()));
         i2++;
 
         // deep variable
@@ -92,7 +378,9 @@ void ValueProcessor::processValue(TokenList &value, const ValueScope &scope)
         variable = *var;
         processValue(variable, scope);
 
-        newvalue.insert(newvalue.end(), variable.begin(), variable.end());
+        newvalue.insert(newvalue.end(),
+                        std::make_move_iterator(variable.begin()),
+                        std::make_move_iterator(variable.end()));
 
       } else if ((*i2).type == Token::IDENTIFIER) {
 
@@ -113,10 +401,283 @@ void ValueProcessor::processValue(TokenList &value, const ValueScope &scope)
   VLOG(2) << "Processed: " << newvalue.toString();
 #endif
   
-  value = newvalue;
+  value.swap(newvalue);
   return;
 }
 
+CompiledValue* ValueProcessor::compileValue(const TokenList &value) const {
+  CompiledValue* compiled = new CompiledValue();
+  TokenList::const_iterator i, itmp, end = value.end();
+  ExpressionBuilder expressions;
+  Expression* e;
+
+  if (!needsProcessing(value)) {
+    compiled->processing = false;
+    return compiled;
+  }
+
+  // Same structure as processValue(), except that variables and
+  // functions are assumed to evaluate to values.
+  try {
+    for (i = value.begin(); i != end; ) {
+      itmp = i;
+      e = parseStatement(itmp, end, expressions);
+      i = itmp;
+
+      if (e != NULL) {
+        compiled->statements.push_back(e);
+        
+      } else if (i != end) {
+        e = new Expression(Expression::RAW, *i);
+        e->tokens.push_back(*i);
+
+        if ((*i).type == Token::IDENTIFIER) {
+          i++;
+          if (i != end && (*i).type == Token::PAREN_OPEN) {
+            e->tokens.push_back(*i);
+            i++;
+          }
+        } else
+          i++;
+        compiled->statements.push_back(e);
+      }
+    }
+  } catch (ParseException* ex) {
+    // leave it to processValue() to report the error
+    delete ex;
+    compiled->valid = false;
+  }
+
+  if (compiled->valid)
+    foldConstants(*compiled);
+
+#ifdef WITH_LIBGLOG
+  VLOG(2) << "Compiled: " << value.toString() << " (" <<
+    compiled->statements.size() << " statements" <<
+    (compiled->folded ? ", folded)" : ")");
+#endif
+  
+  return compiled;
+}
+
+void ValueProcessor::processValue(TokenList &value,
+                                  const CompiledValue &compiled,
+                                  const ValueScope &scope) const {
+  TokenList newvalue;
+  TokenList::iterator i;
+
+  if (!compiled.valid) {
+    processValue(value, scope);
+    return;
+  }
+  Statistics::count(Statistics::VALUES);
+  
+  if (compiled.folded) {
+    value = compiled.result;
+    countFunctions(compiled);
+    return;
+  }
+  if (!compiled.processing) {
+    // interpolate strings
+    for(i = value.begin(); i != value.end(); i++) {
+      if ((*i).type == Token::STRING)
+        interpolate((*i), scope);
+    }
+    return;
+  }
+  
+  if (!evaluateStatements(compiled, scope, newvalue)) {
+    // The value did not evaluate the way it was compiled; the tokens
+    // are processed directly, which reports any errors.
+    processValue(value, scope);
+    return;
+  }
+
+#ifdef WITH_LIBGLOG
+  VLOG(2) << "Processed: " << newvalue.toString();
+#endif
+
+  countFunctions(compiled);
+  value.swap(newvalue);
+}
+
+bool ValueProcessor::evaluateStatements(const CompiledValue &compiled,
+                                        const ValueScope &scope,
+                                        TokenList &newvalue) const {
+  std::vector<Expression*>::const_iterator it;
+  const Expression* e;
+  TokenList variable;
+  const TokenList* var;
+  Value* v;
+
+  try {
+    for (it = compiled.statements.begin();
+         it != compiled.statements.end();
+         it++) {
+      e = *it;
+
+      if (e->type == Expression::RAW) {
+        if (!newvalue.empty() &&
+            needsSpace(newvalue.back(), false) &&
+            needsSpace(e->tokens.front(), true)) {
+          newvalue.push_back(Token::BUILTIN_SPACE);
+        }
+        newvalue.insert(newvalue.end(), e->tokens.begin(), e->tokens.end());
+        continue;
+      }
+      if (e->type == Expression::CONSTANT) {
+        if (!newvalue.empty() &&
+            needsSpace(newvalue.back(), false)) {
+          newvalue.push_back(Token::BUILTIN_SPACE);
+        }
+        newvalue.insert(newvalue.end(), e->tokens.begin(), e->tokens.end());
+        continue;
+      }
+
+      v = evaluate(*e, scope);
+
+      if (v == NULL) {
+        if (e->type != Expression::VARIABLE)
+          return false;
+        
+        // variable containing a non-value.
+        if (!newvalue.empty() &&
+            needsSpace(newvalue.back(), false) &&
+            needsSpace(e->token, true)) {
+          newvalue.push_back(Token::BUILTIN_SPACE);
+        }
+        if ((var = scope.getVariable(e->token.getSymbol())) != NULL) {
+          variable = *var;
+          processValue(variable, scope);
+          newvalue.insert(newvalue.end(),
+                          std::make_move_iterator(variable.begin()),
+                          std::make_move_iterator(variable.end()));
+        } else
+          newvalue.push_back(e->token);
+        continue;
+      }
+
+      if (!newvalue.empty() &&
+          needsSpace(newvalue.back(), false)) {
+        newvalue.push_back(Token::BUILTIN_SPACE);
+      }
+      newvalue.insert(newvalue.end(),
+                      std::make_move_iterator(v->getTokens()->begin()),
+                      std::make_move_iterator(v->getTokens()->end()));
+      delete v;
+    }
+  } catch (ValueException* ex) {
+    delete ex;
+    return false;
+  } catch (ParseException* ex) {
+    delete ex;
+    return false;
+  }
+  return true;
+}
+
+void ValueProcessor::countFunctions(const CompiledValue &compiled) const {
+  std::vector<std::string>::const_iterator it;
+
+  for (it = compiled.functions.begin(); it != compiled.functions.end();
+       it++)
+    Statistics::countFunction(*it);
+}
+
+void ValueProcessor::foldConstants(CompiledValue &compiled) const {
+  std::vector<Expression*>::iterator it;
+  Expression* e;
+  Value* v;
+  EmptyScope scope;
+  ValueBuilder values(*this, scope);
+  std::vector<std::string> calls, functions;
+  bool folded = true;
+
+  // the calls are counted when the value is used, not when it is
+  // compiled
+  if (Statistics::isEnabled())
+    values.calls = &calls;
+
+  for (it = compiled.statements.begin();
+       it != compiled.statements.end();
+       it++) {
+    if ((*it)->type == Expression::RAW)
+      continue;
+    
+    v = NULL;
+    calls.clear();
+    if (isConstant(**it)) {
+      try {
+        v = evaluate(**it, values);
+      } catch (ValueException* ex) {
+        // leave the error to be reported when the value is processed
+        delete ex;
+      } catch (ParseException* ex) {
+        delete ex;
+      }
+    }
+    if (v == NULL) {
+      folded = false;
+      continue;
+    }
+    functions.insert(functions.end(), calls.begin(), calls.end());
+    
+    e = new Expression(Expression::CONSTANT, (*it)->token);
+    e->tokens.insert(e->tokens.end(),
+                     std::make_move_iterator(v->getTokens()->begin()),
+                     std::make_move_iterator(v->getTokens()->end()));
+    delete v;
+    delete *it;
+    *it = e;
+  }
+
+  if (folded) {
+    // only raw tokens and constants are left, so the scope is never
+    // used. The value is not counted until it is processed.
+    evaluateStatements(compiled, scope, compiled.result);
+    compiled.folded = true;
+  }
+  compiled.functions.swap(functions);
+}
+
+bool ValueProcessor::isConstant(const Expression &expression) const {
+  std::vector<Expression*>::const_iterator it;
+  const FuncInfo* fi;
+  
+  switch(expression.type) {
+  case Expression::STRING:
+  case Expression::URL:
+  case Expression::ESCAPE:
+    return !expression.interpolate;
+
+  case Expression::VARIABLE:
+  case Expression::DEEP_VARIABLE:
+    return false;
+
+  case Expression::FUNCTION:
+    fi = functionLibrary.getFunction(expression.token.c_str());
+    if (fi == NULL || !fi->pure)
+      return false;
+    for (it = expression.arguments.begin();
+         it != expression.arguments.end();
+         it++) {
+      if (!isConstant(**it))
+        return false;
+    }
+    return true;
+
+  case Expression::OPERATION:
+    return isConstant(*expression.left) && isConstant(*expression.right);
+
+  case Expression::SUBSTATEMENT:
+  case Expression::NEGATIVE:
+    return isConstant(*expression.left);
+
+  default:
+    return true;
+  }
+}
+
 bool ValueProcessor::needsProcessing(const TokenList &value) const {
   TokenList::const_iterator i;
   const Token* t;
@@ -160,6 +721,8 @@ bool ValueProcessor::needsProcessing(const TokenList &value) const {
 bool ValueProcessor::validateCondition(const TokenList &value, const ValueScope &scope) {
   TokenList::const_iterator i = value.begin();
   TokenList::const_iterator end = value.end();
+
+  Statistics::count(Statistics::GUARDS);
   
   bool ret = validateValue(i, end, scope);
 
@@ -223,34 +786,41 @@ Value* ValueProcessor::processStatement(const TokenList& tokens,
 Value* ValueProcessor::processStatement(TokenList::const_iterator &i,
                                         TokenList::const_iterator &end,
                                         const ValueScope& scope) const {
-  Value* op, *v;
+  ValueBuilder values(*this, scope);
+
+  return parseStatement(i, end, values);
+}
+
+template <class Builder>
+typename Builder::Result ValueProcessor::
+parseStatement(TokenList::const_iterator &i,
+               TokenList::const_iterator &end,
+               Builder &builder) const {
+  typename Builder::Result op, v;
 
   skipWhitespace(i, end);
-  v = processConstant(i, end, scope);
+  v = parseConstant(i, end, builder);
   
   if (v != NULL) {
     skipWhitespace(i, end);
 
-    while ((op = processOperation(i, end, *v, scope, OP_NONE)) != NULL) {
-      delete v;
+    while ((op = parseOperation(i, end, v, builder, OP_NONE)) != NULL) {
       v = op;        
-      
       skipWhitespace(i, end);
     }
-    
-    return v;
-  } else
-    return NULL;
+  }
+  return v;
 }
 
-Value* ValueProcessor::processOperation(TokenList::const_iterator &i,
-                                       TokenList::const_iterator &end,
-                                       const Value &operand1,
-                                       const ValueScope &scope,
-                                       ValueProcessor::Operator lastop) const {
+template <class Builder>
+typename Builder::Result ValueProcessor::
+parseOperation(TokenList::const_iterator &i,
+               TokenList::const_iterator &end,
+               typename Builder::Result operand1,
+               Builder &builder,
+               ValueProcessor::Operator lastop) const {
   TokenList::const_iterator tmp;
-  const Value* operand2;
-  Value* result;
+  typename Builder::Result operand2, result;
   Operator op;
   const Token* opToken;
 
@@ -267,7 +837,7 @@ Value* ValueProcessor::processOperation(TokenList::const_iterator &i,
   i = tmp;
   skipWhitespace(i, end);
   
-  operand2 = processConstant(i, end, scope);
+  operand2 = parseConstant(i, end, builder);
   if (operand2 == NULL) {
     if (i == end)
       throw new ParseException("end of line",
@@ -281,42 +851,37 @@ Value* ValueProcessor::processOperation(TokenList::const_iterator &i,
 
   skipWhitespace(i, end);
   
-  while ((result = processOperation(i, end, *operand2, scope, op))) {
-    delete operand2;
+  while ((result = parseOperation(i, end, operand2, builder, op)) != NULL) {
     operand2 = result;
-    
     skipWhitespace(i, end);
   }
 
-#ifdef WITH_LIBGLOG
-  VLOG(3) << "Operation: " << operand1.getTokens()->toString() << 
-    "(" << Value::typeToString(operand1.type) <<  ") " << operatorToString(op) << " " <<
-    operand2->getTokens()->toString() << "(" <<
-    Value::typeToString(operand2->type) << ")";
-#endif
-  
+  return builder.operation(op, *opToken, operand1, operand2);
+}
+
+
+Value* ValueProcessor::applyOperator(ValueProcessor::Operator op,
+                                     const Value &operand1,
+                                     const Value &operand2) const {
   if (op == OP_ADD) 
-    result = operand1.add(*operand2);
+    return operand1.add(operand2);
   else if (op == OP_SUBSTRACT)
-    result = operand1.substract(*operand2);
+    return operand1.substract(operand2);
   else if (op == OP_MULTIPLY)
-    result = operand1.multiply(*operand2);
+    return operand1.multiply(operand2);
   else if (op == OP_DIVIDE)
-    result = operand1.divide(*operand2);
+    return operand1.divide(operand2);
   else if (op == OP_EQUALS)
-    result = operand1.equals(*operand2);
+    return operand1.equals(operand2);
   else if (op == OP_LESS)
-    result = operand1.lessThan(*operand2);
+    return operand1.lessThan(operand2);
   else if (op == OP_GREATER)
-    result = operand1.greaterThan(*operand2);
+    return operand1.greaterThan(operand2);
   else if (op == OP_LESS_EQUALS)
-    result = operand1.lessThanEquals(*operand2);
+    return operand1.lessThanEquals(operand2);
   else if (op == OP_GREATER_EQUALS) 
-    result = operand1.greaterThanEquals(*operand2);
-  
-  delete operand2;
-  result->setLocation(*opToken);
-  return result;
+    return operand1.greaterThanEquals(operand2);
+  return NULL;
 }
 
 ValueProcessor::Operator ValueProcessor::processOperator(TokenList::const_iterator &i,
@@ -385,20 +950,17 @@ const char* ValueProcessor::operatorToString(ValueProcessor::Operator
   }
 }
 
-Value* ValueProcessor::processConstant(TokenList::const_iterator &i,
-                                       TokenList::const_iterator &end,
-                                       const ValueScope &scope) const {
-  Token token;
-  Value* ret;
-  const TokenList* var;
-  TokenList variable;
-  bool hasQuotes;
-  std::string str;
+template <class Builder>
+typename Builder::Result ValueProcessor::
+parseConstant(TokenList::const_iterator &i,
+              TokenList::const_iterator &end,
+              Builder &builder) const {
+  typename Builder::Result ret;
   
   if (i == end)
     return NULL;
   
-  token = *i;
+  const Token &token = *i;
   
 #ifdef WITH_LIBGLOG
   VLOG(3) << "Constant: " << token << "[type " << token.type << "]";
@@ -407,121 +969,90 @@ Value* ValueProcessor::processConstant(TokenList::const_iterator &i,
   switch(token.type) {
   case Token::HASH:
     i++;
-    // generate color from hex value
-    return new Color(token);
+    return builder.color(token);
     
   case Token::NUMBER:
   case Token::PERCENTAGE:
   case Token::DIMENSION:
     i++;
-    return new NumberValue(token);
+    return builder.number(token);
 
   case Token::ATKEYWORD:
-    if ((var = scope.getVariable(token)) != NULL) {
-      variable = *var;
-
-      ret = processStatement(variable, scope);
-      
-      if (ret != NULL) {
-        i++;
-        ret->setLocation(token);
-
-#ifdef WITH_LIBGLOG
-        VLOG(3) << "Variable value: " << ret->getTokens()->toString();
-#endif
-        
-        return ret;
-      }
-    } 
-    return NULL;
+    if ((ret = builder.variable(token)) != NULL)
+      i++;
+    return ret;
 
   case Token::STRING:
     i++;
-    hasQuotes = token.stringHasQuotes();
-    interpolate(token, scope);
-    token.removeQuotes();
-    return new StringValue(token, hasQuotes);
+    return builder.string(token);
 
   case Token::URL:
     i++;
-    interpolate(token, scope);
-    str = token.getUrlString();
-#ifdef WITH_LIBGLOG
-    VLOG(3) << "url: " << str;
-#endif
-
-    return new UrlValue(token, str);
+    return builder.url(token);
         
   case Token::IDENTIFIER:
     i++;
     
-    if ((*i).type == Token::PAREN_OPEN) {
+    if (i != end && (*i).type == Token::PAREN_OPEN) {
 
       if (functionExists(token.c_str())) {
         i++;
       
-        ret = processFunction(token, i, end, scope);
+        ret = parseFunction(token, i, end, builder);
         if (ret == NULL) {
           i--;
           i--;
-          return NULL;
-        } else
-          return ret;
+        }
+        return ret;
         
       } else {
         i--;
         return NULL;
       }
       
-    } else if ((ret = processUnit(token)) != NULL) {
-      return ret;  
+    } else if (isUnit(token)) {
+      return builder.unit(token);
     } else if (token.compare("true") == 0) {
-      return new BooleanValue(token, true);
+      return builder.boolean(token);
     } else {
-      return new StringValue(token, false);
+      return builder.identifier(token);
     }
     
   case Token::PAREN_OPEN:
-    return processSubstatement(i, end, scope);
+    return parseSubstatement(i, end, builder);
     
   default:
     break;
   }
 
-  if ((var = processDeepVariable(i, end, scope)) != NULL) {
-    variable = *var;
-    ret = processStatement(variable, scope);
-    if (ret != NULL) {
-      ret->setLocation(*i);
-    }
+  if ((ret = parseDeepVariable(i, end, builder)) != NULL)
     return ret;
 
-  }
-  if(token == "%") {
+  if (token == "%") {
     i++;
     if (i != end &&
         (*i).type == Token::PAREN_OPEN) {
       i++;
       
-      if ((ret = processFunction(token, i, end, scope)) != NULL)
+      if ((ret = parseFunction(token, i, end, builder)) != NULL)
         return ret;
 
       i--;
     }
     i--;
   }
-  if ((ret = processEscape(i, end, scope)) != NULL) {
-    return ret;
-  } else if ((ret = processNegative(i, end, scope)) != NULL) {
+  if ((ret = parseEscape(i, end, builder)) != NULL)
     return ret;
-  }
-  return NULL;
+  else
+    return parseNegative(i, end, builder);
 }
 
-Value* ValueProcessor::processSubstatement(TokenList::const_iterator &i,
-                                           TokenList::const_iterator &end,
-                                           const ValueScope &scope) const {
-  Value* ret;
+template <class Builder>
+typename Builder::Result ValueProcessor::
+parseSubstatement(TokenList::const_iterator &i,
+                  TokenList::const_iterator &end,
+                  Builder &builder) const {
+  typename Builder::Result statement, ret;
   TokenList::const_iterator i2 = i;
 
   if (i == end ||
@@ -530,139 +1061,103 @@ Value* ValueProcessor::processSubstatement(TokenList::const_iterator &i,
   
   i2++;
 
-  ret = processStatement(i2, end, scope);
-  
-  if (ret == NULL) 
+  statement = parseStatement(i2, end, builder);
+  if (statement == NULL) 
     return NULL;
 
-  ret->setLocation(*i);
-
   skipWhitespace(i2, end);
     
   if (i2 == end ||
       (*i2).type != Token::PAREN_CLOSED) {
-    delete ret;
+    delete statement;
     return NULL;
   }
 
+  ret = builder.substatement(*i, statement);
+  
   i2++;
-
   i = i2;
-  
   return ret;
 }
 
-const TokenList* ValueProcessor::
-processDeepVariable(TokenList::const_iterator &i,
-                    TokenList::const_iterator &end,
-                    const ValueScope &scope) const {
-  const TokenList* var;
-  TokenList variable;
-  std::string key = "@";
-  
+template <class Builder>
+typename Builder::Result ValueProcessor::
+parseDeepVariable(TokenList::const_iterator &i,
+                  TokenList::const_iterator &end,
+                  Builder &builder) const {
+  typename Builder::Result ret;
+  TokenList::const_iterator i2 = i;
+
   if (i == end ||
       (*i).type != Token::OTHER ||
       (*i) != "@")
     return NULL;
 
-  i++;
-  
-  if (i == end ||
-      (*i).type != Token::ATKEYWORD ||
-      (var = scope.getVariable((*i))) == NULL) {
-    i--;
-    return NULL;
-  }
-
-  variable = *var;
-  processValue(variable, scope);
+  i2++;
   
-  if (variable.size() != 1 || variable.front().type != Token::STRING) {
-    i--;
+  if (i2 == end ||
+      (*i2).type != Token::ATKEYWORD ||
+      (ret = builder.deepVariable(*i, *i2)) == NULL)
     return NULL;
-  }
 
-  i++;
-  // generate key with '@' + var without quotes
-  variable.front().removeQuotes();
-  key.append(variable.front());
-  
-  return scope.getVariable(key);
-}
-
-bool ValueProcessor::functionExists(const char* function) const {
-  
-  return ((functionLibrary.getFunction(function)) != NULL);
+  i2++;
+  i = i2;
+  return ret;
 }
 
-Value* ValueProcessor::processFunction(const Token &function,
-                                       TokenList::const_iterator &i,
-                                       TokenList::const_iterator &end,
-                                       const ValueScope &scope) const {
+template <class Builder>
+typename Builder::Result ValueProcessor::
+parseFunction(const Token &function,
+              TokenList::const_iterator &i,
+              TokenList::const_iterator &end,
+              Builder &builder) const {
   // Use a temporary iterator so we don't disturb <code>i</code> if
-  // processing fails
+  // parsing fails
   TokenList::const_iterator i2 = i;
-
-  vector<const Value*> arguments;
-
-  const FuncInfo* fi;
-  Value* ret = NULL;
-  vector<const Value*>::iterator it;
-  string arg_str;
-
-#ifdef WITH_LIBGLOG
-  VLOG(3) << "Function: " << function;
-#endif
-  
-  fi = functionLibrary.getFunction(function.c_str());
-  
-  if (fi == NULL)
-    return NULL;
+  std::vector<typename Builder::Result> arguments;
+  typename std::vector<typename Builder::Result>::iterator it;
+  typename Builder::Result ret = NULL;
 
   try {
-
-    if (processArguments(i2, end, scope, arguments) &&
-    
-        functionLibrary.checkArguments(fi, arguments)) {
-      
-      ret = fi->func(arguments);
-      ret->setLocation(function);
+    if (parseArguments(i2, end, builder, arguments) &&
+        (ret = builder.function(function, arguments)) != NULL) {
       // advance the iterator
       i = i2;
-    } else
-      ret = NULL;
+    }
 
     // If an exception is thrown, parsing or processing failed, and we
     // assume this isn't a function.
   } catch (ValueException* e) {
+    delete e;
     ret = NULL;
   } catch (ParseException* e) {
+    delete e;
     ret = NULL;
   }
 
-  // delete arguments
-  for (it = arguments.begin(); it != arguments.end(); it++) {
-      delete (*it);
-  }
-  
+  // delete the arguments the builder did not take
+  for (it = arguments.begin(); it != arguments.end(); it++)
+    delete *it;
   return ret;
 }
 
-bool ValueProcessor::processArguments (TokenList::const_iterator &i,
-                                       TokenList::const_iterator &end,
-                                       const ValueScope &scope,
-                                       vector<const Value*> &arguments) const {
-  Value* argument;
+template <class Builder>
+bool ValueProcessor::
+parseArguments(TokenList::const_iterator &i,
+               TokenList::const_iterator &end,
+               Builder &builder,
+               std::vector<typename Builder::Result> &arguments) const {
+  typename Builder::Result argument;
 
   if (i == end) 
     return false;
   
   if ((*i).type != Token::PAREN_CLOSED)  {
-    argument = processStatement(i, end, scope);
+    argument = parseStatement(i, end, builder);
     if (argument != NULL)
       arguments.push_back(argument);
-    else {
-      arguments.push_back(new StringValue(*i, false));
+    else if (i != end) {
+      arguments.push_back(builder.identifier(*i));
       i++;
     }
   }
@@ -672,12 +1167,12 @@ bool ValueProcessor::processArguments (TokenList::const_iterator &i,
           (*i) == ";")) {
     i++;
 
-    argument = processStatement(i, end, scope);
+    argument = parseStatement(i, end, builder);
 
     if (argument != NULL) {
       arguments.push_back(argument);
-    } else if ((*i).type != Token::PAREN_CLOSED) {
-      arguments.push_back(new StringValue(*i, false));
+    } else if (i != end && (*i).type != Token::PAREN_CLOSED) {
+      arguments.push_back(builder.identifier(*i));
       i++;
     }
   }
@@ -693,47 +1188,121 @@ bool ValueProcessor::processArguments (TokenList::const_iterator &i,
   return true;
 }
 
-
-Value* ValueProcessor::processEscape (TokenList::const_iterator &i,
-                                      TokenList::const_iterator &end,
-                                      const ValueScope &scope) const {
-  Token t;
+template <class Builder>
+typename Builder::Result ValueProcessor::
+parseEscape(TokenList::const_iterator &i,
+            TokenList::const_iterator &end,
+            Builder &builder) const {
+  typename Builder::Result ret;
+  TokenList::const_iterator i2 = i;
   
   if (i == end ||
       *i != "~")
     return NULL;
 
-  i++;
+  i2++;
 
-  if ((*i).type != Token::STRING) {
-    i--;
+  if (i2 == end ||
+      (*i2).type != Token::STRING)
     return NULL;
-  }
 
-  t = *i;
-  i++;
-  interpolate(t, scope);
-  t.removeQuotes();
-  return new StringValue(t, false);
+  ret = builder.escape(*i2);
+  i2++;
+  i = i2;
+  return ret;
+}
+
+template <class Builder>
+typename Builder::Result ValueProcessor::
+parseNegative(TokenList::const_iterator &i,
+              TokenList::const_iterator &end,
+              Builder &builder) const {
+  typename Builder::Result constant;
+  TokenList::const_iterator i2 = i;
+  
+  if (i == end ||
+      (*i) != "-")
+    return NULL;
+
+  i2++;
+  skipWhitespace(i2, end);
+  
+  constant = parseConstant(i2, end, builder);
+  if (constant == NULL)
+    return NULL;
+
+  constant = builder.negative(*i, constant);
+  i = i2;
+  return constant;
+}
+
+const TokenList* ValueProcessor::
+processDeepVariable(TokenList::const_iterator &i,
+                    TokenList::const_iterator &end,
+                    const ValueScope &scope) const {
+  const TokenList* var;
+  TokenList::const_iterator i2 = i;
+  
+  if (i == end ||
+      (*i).type != Token::OTHER ||
+      (*i) != "@")
+    return NULL;
+
+  i2++;
+  
+  if (i2 == end ||
+      (*i2).type != Token::ATKEYWORD ||
+      (var = getDeepVariable(*i2, scope)) == NULL)
+    return NULL;
+
+  i2++;
+  i = i2;
+  return var;
 }
 
-UnitValue* ValueProcessor::processUnit(Token &t) const {
+const TokenList* ValueProcessor::getDeepVariable(const Token &name,
+                                                 const ValueScope &scope)
+  const {
+  const TokenList* var;
+  TokenList variable;
+  std::string key = "@";
+
+  if ((var = scope.getVariable(name.getSymbol())) == NULL)
+    return NULL;
+
+  variable = *var;
+  processValue(variable, scope);
+  
+  if (variable.size() != 1 || variable.front().type != Token::STRING)
+    return NULL;
+
+  // generate key with '@' + var without quotes
+  variable.front().removeQuotes();
+  key.append(variable.front());
+  
+  return scope.getVariable(SymbolTable::intern(key));
+}
+
+
+bool ValueProcessor::functionExists(const char* function) const {
+  
+  return ((functionLibrary.getFunction(function)) != NULL);
+}
+
+bool ValueProcessor::isUnit(const Token &t) const {
   // em,ex,px,ch,in,mm,cm,pt,pc,ms
   string units("emexpxchinmmcmptpcms");
   size_t pos;
-  if (t.size() == 2 &&
-      (pos = units.find(t)) != string::npos &&
-      pos % 2 == 0) {
-    return new UnitValue(t);
-  } else if(t.compare("m") == 0 ||
-            t.compare("s") == 0 ||
-            t.compare("rad") == 0 ||
-            t.compare("deg") == 0 ||
-            t.compare("grad") == 0 ||
-            t.compare("turn") == 0) {
-    return new UnitValue(t);
-  } else
-    return NULL;
+  
+  return (t.size() == 2 &&
+          (pos = units.find(t)) != string::npos &&
+          pos % 2 == 0) ||
+    t.compare("m") == 0 ||
+    t.compare("s") == 0 ||
+    t.compare("rad") == 0 ||
+    t.compare("deg") == 0 ||
+    t.compare("grad") == 0 ||
+    t.compare("turn") == 0;
 }
 
 bool ValueProcessor::needsSpace(const Token &t, bool before) const {
@@ -762,45 +1331,7 @@ void ValueProcessor::skipWhitespace(TokenList::const_iterator &i,
     i++;
 }
 
-Value* ValueProcessor::processNegative(TokenList::const_iterator &i,
-                                       TokenList::const_iterator &end,
-                                       const ValueScope &scope) const {
-  Token minus;
-  Value* constant;
-  Value *zero, *ret;
-  Token t_zero("0", Token::NUMBER, 0,0,"generated");
-    
-  if (i == end ||
-      (*i) != "-")
-    return NULL;
-  
-  minus = *i;
-  i++;
-  
-  skipWhitespace(i, end);
-  
-  constant = processConstant(i, end, scope);
-  if (constant == NULL) {
-    i--;
-    return NULL;
-  }
-  
-#ifdef WITH_LIBGLOG
-  VLOG(3) << "Negate: " << constant->getTokens()->toString();
-#endif
-
-  zero = new NumberValue(t_zero);
-  ret = zero->substract(*constant);
-
-  ret->setLocation(minus);
-  
-  delete constant;
-  delete zero;
-  
-  return ret;
-}
-
-void ValueProcessor::interpolate(std::string &str, const ValueScope &scope)
+void ValueProcessor::interpolate(Token &token, const ValueScope &scope)
   const {
   size_t start, end = 0;
   string key , value;
@@ -808,19 +1339,19 @@ void ValueProcessor::interpolate(std::string &str, const ValueScope &scope)
   TokenList variable;
 
 #ifdef WITH_LIBGLOG
-  VLOG(3) << "Interpolate: " << str;
+  VLOG(3) << "Interpolate: " << token;
 #endif
 
-  while ((start = str.find("@{", end)) != string::npos &&
-         (end = str.find("}", start)) != string::npos) {
+  while ((start = token.find("@{", end)) != string::npos &&
+         (end = token.find("}", start)) != string::npos) {
     key = "@";
-    key.append(str.substr(start + 2, end - (start + 2)));
+    key.append(token.substr(start + 2, end - (start + 2)));
 
 #ifdef WITH_LIBGLOG
     VLOG(3) << "Key: " << key;
 #endif
     
-    var = scope.getVariable(key);
+    var = scope.getVariable(SymbolTable::intern(key));
     
     if (var != NULL) {
       variable = *var;
@@ -835,7 +1366,7 @@ void ValueProcessor::interpolate(std::string &str, const ValueScope &scope)
 
       value = variable.toString();
       
-      str.replace(start, (end + 1) - start, value);
+      token.replace(start, (end + 1) - start, value);
       end = start + value.length();
     }
   }
@@ -850,3 +1381,88 @@ void ValueProcessor::interpolate(TokenList &tokens,
   }
 }
 
+Value* ValueProcessor::evaluate(const Expression &expression,
+                                const ValueScope &scope) const {
+  ValueBuilder values(*this, scope);
+
+  return evaluate(expression, values);
+}
+
+Value* ValueProcessor::evaluate(const Expression &expression,
+                                ValueBuilder &values) const {
+  std::vector<Value*> arguments;
+  std::vector<Value*>::iterator it;
+  std::vector<Expression*>::const_iterator a_it;
+  Value* ret, *operand1, *operand2;
+  
+  switch(expression.type) {
+  case Expression::COLOR:
+    return values.color(expression.token);
+  case Expression::NUMBER:
+    return values.number(expression.token);
+  case Expression::UNIT:
+    return values.unit(expression.token);
+  case Expression::BOOLEAN:
+    return values.boolean(expression.token);
+  case Expression::IDENTIFIER:
+    return values.identifier(expression.token);
+  case Expression::STRING:
+    return values.string(expression.token);
+  case Expression::ESCAPE:
+    return values.escape(expression.token);
+  case Expression::URL:
+    return values.url(expression.token);
+  case Expression::VARIABLE:
+    return values.variable(expression.token);
+  case Expression::DEEP_VARIABLE:
+    return values.deepVariable(expression.tokens.front(),
+                               expression.tokens.back());
+    
+  case Expression::FUNCTION:
+    ret = NULL;
+    try {
+      for (a_it = expression.arguments.begin();
+           a_it != expression.arguments.end();
+           a_it++) {
+        if ((operand1 = evaluate(**a_it, values)) == NULL)
+          break;
+        arguments.push_back(operand1);
+      }
+      if (arguments.size() == expression.arguments.size())
+        ret = values.function(expression.token, arguments);
+    } catch (ValueException* e) {
+      delete e;
+      ret = NULL;
+    } catch (ParseException* e) {
+      delete e;
+      ret = NULL;
+    }
+    for (it = arguments.begin(); it != arguments.end(); it++)
+      delete *it;
+    return ret;
+
+  case Expression::OPERATION:
+    if ((operand1 = evaluate(*expression.left, values)) == NULL)
+      return NULL;
+    if ((operand2 = evaluate(*expression.right, values)) == NULL) {
+      delete operand1;
+      return NULL;
+    }
+    return values.operation((Operator)expression.op, expression.token,
+                            operand1, operand2);
+    
+  case Expression::SUBSTATEMENT:
+    if ((ret = evaluate(*expression.left, values)) == NULL)
+      return NULL;
+    return values.substatement(expression.token, ret);
+    
+  case Expression::NEGATIVE:
+    if ((ret = evaluate(*expression.left, values)) == NULL)
+      return NULL;
+    return values.negative(expression.token, ret);
+
+  case Expression::RAW:
+  default:
+    return NULL;
+  }
+}
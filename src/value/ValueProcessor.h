@@ -14,6 +14,7 @@
 #include "ValueException.h"
 #include "ValueScope.h"
 #include "FunctionLibrary.h"
+#include "Expression.h"
 #include <map>
 #include <vector>
 #include <cstring>
@@ -27,7 +28,16 @@ public:
                 OP_MULTIPLY, OP_DIVIDE, OP_NONE}; 
 
 private:
-  FunctionLibrary functionLibrary;
+  const FunctionLibrary &functionLibrary;
+
+  /**
+   * Builds values from the grammar below; see ValueProcessor.cpp.
+   */
+  class ValueBuilder;
+  /**
+   * Builds Expression trees from the grammar below.
+   */
+  class ExpressionBuilder;
 
   Value* processStatement(const TokenList& tokens,
                           const ValueScope& scope) const;
@@ -36,52 +46,120 @@ private:
                           TokenList::const_iterator &end,
                           const ValueScope &scope) const;
 
-  Value* processOperation(TokenList::const_iterator &i,
-                          TokenList::const_iterator &end,
-                          const Value &operand1,
-                          const ValueScope &scope,
-                          ValueProcessor::Operator lastop) const;
+  /**
+   * The grammar of values. It is the same for processing and
+   * compiling; the Builder decides whether the result is a Value or an
+   * Expression. Builder::Result is NULL where the tokens are not a
+   * value.
+   */
+  template <class Builder>
+  typename Builder::Result parseStatement(TokenList::const_iterator &i,
+                                          TokenList::const_iterator &end,
+                                          Builder &builder) const;
+  template <class Builder>
+  typename Builder::Result parseOperation(TokenList::const_iterator &i,
+                                          TokenList::const_iterator &end,
+                                          typename Builder::Result operand1,
+                                          Builder &builder,
+                                          Operator lastop) const;
+  template <class Builder>
+  typename Builder::Result parseConstant(TokenList::const_iterator &i,
+                                         TokenList::const_iterator &end,
+                                         Builder &builder) const;
+  template <class Builder>
+  typename Builder::Result parseSubstatement(TokenList::const_iterator &i,
+                                             TokenList::const_iterator &end,
+                                             Builder &builder) const;
+  template <class Builder>
+  typename Builder::Result parseDeepVariable(TokenList::const_iterator &i,
+                                             TokenList::const_iterator &end,
+                                             Builder &builder) const;
+  template <class Builder>
+  typename Builder::Result parseFunction(const Token &function,
+                                         TokenList::const_iterator &i,
+                                         TokenList::const_iterator &end,
+                                         Builder &builder) const;
+  template <class Builder>
+  bool parseArguments(TokenList::const_iterator &i,
+                      TokenList::const_iterator &end,
+                      Builder &builder,
+                      std::vector<typename Builder::Result> &arguments)
+    const;
+  template <class Builder>
+  typename Builder::Result parseEscape(TokenList::const_iterator &i,
+                                       TokenList::const_iterator &end,
+                                       Builder &builder) const;
+  template <class Builder>
+  typename Builder::Result parseNegative(TokenList::const_iterator &i,
+                                         TokenList::const_iterator &end,
+                                         Builder &builder) const;
 
   Operator processOperator(TokenList::const_iterator &i,
                            TokenList::const_iterator &end) const;
 
-  Value* processConstant(TokenList::const_iterator &it,
-                         TokenList::const_iterator &end,
-                         const ValueScope& scope) const;
+  Value* applyOperator(Operator op, const Value &operand1,
+                       const Value &operand2) const;
 
-  Value* processSubstatement(TokenList::const_iterator &i,
-                             TokenList::const_iterator &end,
-                             const ValueScope &scope) const;
-    
+  /**
+   * Returns the variable named by the value of the variable
+   * <code>name</code>, or NULL.
+   */
+  const TokenList* getDeepVariable(const Token &name,
+                                   const ValueScope &scope) const;
   const TokenList* processDeepVariable (TokenList::const_iterator &it,
                                         TokenList::const_iterator &end,
                                         const ValueScope& scope) const;
   
-  Value* processFunction(const Token &function,
-                         TokenList::const_iterator &it,
-                         TokenList::const_iterator &end,
-                         const ValueScope &scope) const;
-  
-  bool processArguments (TokenList::const_iterator &it,
-                         TokenList::const_iterator &end,
-                         const ValueScope &scope,
-                         vector<const Value*> &arguments) const;
-  
-  Value* processEscape (TokenList::const_iterator &it,
-                        TokenList::const_iterator &end,
-                        const ValueScope &scope) const;
-  UnitValue* processUnit(Token &t) const;
+  bool isUnit(const Token &t) const;
   
   bool needsSpace(const Token &t, bool before) const;
 
-  Value* processNegative(TokenList::const_iterator &it,
-                         TokenList::const_iterator &end,
-                         const ValueScope &scope) const;
-
   void skipWhitespace(TokenList::const_iterator &i,
                       TokenList::const_iterator &end) const;
 
   const char* operatorToString(ValueProcessor::Operator o) const;
+
+  /**
+   * Evaluate a compiled expression.
+   *
+   * @return the value, or NULL if the expression can not be evaluated
+   *         in this scope the way it was compiled. The value then has
+   *         to be processed from its tokens.
+   */
+  Value* evaluate(const Expression &expression,
+                  const ValueScope &scope) const;
+  Value* evaluate(const Expression &expression,
+                  ValueBuilder &values) const;
+
+  /**
+   * Evaluate the statements of a compiled value that do not depend on
+   * the scope, and replace them with CONSTANT expressions. If all
+   * statements are constant the processed value is stored in the
+   * compiled value.
+   */
+  void foldConstants(CompiledValue &compiled) const;
+  /**
+   * Evaluate the statements of a compiled value and add the result to
+   * <code>newvalue</code>.
+   *
+   * @return false if a statement could not be evaluated the way it was
+   *         compiled.
+   */
+  bool evaluateStatements(const CompiledValue &compiled,
+                          const ValueScope &scope,
+                          TokenList &newvalue) const;
+  /**
+   * Count the calls of the functions that were folded into
+   * <code>compiled</code>.
+   */
+  void countFunctions(const CompiledValue &compiled) const;
+
+  /**
+   * @return true if the expression does not contain variables,
+   *         interpolated strings or functions that are not pure.
+   */
+  bool isConstant(const Expression &expression) const;
+  
 public:
 
   ValueProcessor();
@@ -98,6 +176,22 @@ public:
 
   void processValue(TokenList &value, const ValueScope &scope) const;
 
+  /**
+   * Parse a value once so it can be processed repeatedly with
+   * processValue(TokenList&, const CompiledValue&, const ValueScope&)
+   * without parsing the tokens again. The caller owns the returned
+   * object.
+   */
+  CompiledValue* compileValue(const TokenList &value) const;
+
+  /**
+   * Process a value using its compiled form. <code>value</code> has to
+   * contain the tokens that <code>compiled</code> was created from;
+   * they are processed directly if the compiled value can't be used.
+   */
+  void processValue(TokenList &value, const CompiledValue &compiled,
+                    const ValueScope &scope) const;
+
   bool validateCondition(const TokenList &value, const ValueScope &scope);
   bool validateValue(TokenList::const_iterator &i,
                      TokenList::const_iterator &end,
@@ -105,7 +199,7 @@ public:
   
   bool functionExists(const char* function) const;
 
-  void interpolate(string &str, const ValueScope &scope) const;
+  void interpolate(Token &token, const ValueScope &scope) const;
   void interpolate(TokenList &tokens, const ValueScope &scope) const;
 };
 
@@ -10,7 +10,7 @@
 
 class ValueScope {
 public:
-  virtual const TokenList* getVariable(const std::string &key) const =0;
+  virtual const TokenList* getVariable(Symbol key) const =0;
   
 };
 
@@ -0,0 +1,73 @@
+#include "Arena.h"
+#include "gtest/gtest.h"
+
+#include <stdint.h>
+
+class ArenaTestObject: public ArenaObject {
+public:
+  double value;
+};
+
+TEST(ArenaTest, Allocate) {
+  Arena arena(1024);
+  void* p1, *p2, *large;
+
+  p1 = arena.allocate(1);
+  p2 = arena.allocate(20);
+  ASSERT_EQ(0U, (uintptr_t)p1 % 16);
+  ASSERT_EQ(0U, (uintptr_t)p2 % 16);
+  ASSERT_EQ((char*)p1 + 16, (char*)p2);
+  ASSERT_EQ(48U, arena.getUsed());
+  ASSERT_EQ(1024U, arena.getReserved());
+
+  // larger than a block
+  large = arena.allocate(4000);
+  ASSERT_NE((void*)NULL, large);
+  ASSERT_EQ(1024U + 4000U, arena.getReserved());
+}
+
+TEST(ArenaTest, Reuse) {
+  Arena arena;
+  void* p1, *p2;
+
+  p1 = arena.allocate(32);
+  arena.allocate(32);
+  arena.deallocate(p1, 32);
+  ASSERT_EQ(32U, arena.getUsed());
+
+  p2 = arena.allocate(32);
+  ASSERT_EQ(p1, p2);
+
+  // other sizes don't take it
+  arena.deallocate(p2, 32);
+  ASSERT_NE(p1, arena.allocate(48));
+}
+
+TEST(ArenaTest, Scope) {
+  Arena outer, inner;
+  ArenaTestObject* o1, *o2, *o3;
+
+  ASSERT_TRUE(Arena::getCurrent() == NULL);
+  {
+    ArenaScope s1(outer);
+    o1 = new ArenaTestObject();
+    {
+      ArenaScope s2(inner);
+      o2 = new ArenaTestObject();
+      ASSERT_EQ(&inner, Arena::getCurrent());
+    }
+    ASSERT_EQ(&outer, Arena::getCurrent());
+  }
+  ASSERT_TRUE(Arena::getCurrent() == NULL);
+  o3 = new ArenaTestObject();
+
+  ASSERT_NE(0U, outer.getUsed());
+  ASSERT_NE(0U, inner.getUsed());
+
+  // objects go back to the arena they came from
+  delete o1;
+  delete o2;
+  delete o3;
+  ASSERT_EQ(0U, outer.getUsed());
+  ASSERT_EQ(0U, inner.getUsed());
+}
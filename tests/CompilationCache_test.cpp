@@ -0,0 +1,218 @@
+#include "less/CompilationCache.h"
+#include "Sha256.h"
+#include "gtest/gtest.h"
+
+#include "TempDirectory.h"
+
+#include <string>
+#include <vector>
+#include <ctime>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+class CompilationCacheTest : public ::testing::Test {
+public:
+  TempDirectory directory;
+  std::string cache;
+
+  virtual void SetUp() {
+    cache = directory.path + "/cache";
+  }
+
+  /**
+   * Write a file and return it with the digest of its contents.
+   */
+  std::pair<std::string, std::string>
+  writeFile(const char* name, const std::string &contents) {
+    return std::make_pair(directory.write(name, contents),
+                          Sha256::hash(contents.data(), contents.size()));
+  }
+
+  /**
+   * Set the modification time of every file in the cache that is
+   * newer than <code>mtime</code>.
+   */
+  void age(time_t mtime) {
+    DIR* dir = opendir(cache.c_str());
+    struct dirent* entry;
+    struct stat st;
+    std::string path;
+
+    while (dir != NULL && (entry = readdir(dir)) != NULL) {
+      path = cache + "/" + entry->d_name;
+      if (entry->d_name[0] != '.' && stat(path.c_str(), &st) == 0 &&
+          st.st_mtime > mtime)
+        TempDirectory::setTime(path, mtime);
+    }
+    if (dir != NULL)
+      closedir(dir);
+  }
+};
+
+TEST_F(CompilationCacheTest, Hit) {
+  CompilationCache c(cache, 0);
+  CompilationCache::FileHashes files;
+  std::vector<std::string> found;
+  std::string css, map;
+  unsigned long long hits, misses, size;
+  size_t entries;
+
+  files.push_back(writeFile("a.less", "a { b: c; }"));
+  files.push_back(writeFile("b.less", "d { e: f; }"));
+
+  ASSERT_FALSE(c.get("key1", false, css, map, found));
+  c.put("key1", files, "a{b:c}d{e:f}", NULL);
+
+  ASSERT_TRUE(c.get("key1", false, css, map, found));
+  ASSERT_EQ("a{b:c}d{e:f}", css);
+  ASSERT_EQ(2U, found.size());
+  ASSERT_EQ(files[0].first, found[0]);
+  ASSERT_EQ(files[1].first, found[1]);
+
+  // another key doesn't match the same files
+  ASSERT_FALSE(c.get("key2", false, css, map, found));
+
+  c.getStats(hits, misses, entries, size);
+  ASSERT_EQ(1U, hits);
+  ASSERT_EQ(2U, misses);
+  ASSERT_EQ(1U, entries);
+}
+
+TEST_F(CompilationCacheTest, SourceMap) {
+  CompilationCache c(cache, 0);
+  CompilationCache::FileHashes files;
+  std::vector<std::string> found;
+  std::string css, map, sourcemap = "{}";
+
+  files.push_back(writeFile("a.less", "a { b: c; }"));
+  c.put("key1", files, "a{b:c}", NULL);
+
+  // no source map was stored
+  ASSERT_FALSE(c.get("key1", true, css, map, found));
+
+  c.put("key1", files, "a{b:c}", &sourcemap);
+  ASSERT_TRUE(c.get("key1", true, css, map, found));
+  ASSERT_EQ("{}", map);
+}
+
+TEST_F(CompilationCacheTest, DependencyChanged) {
+  CompilationCache c(cache, 0);
+  CompilationCache::FileHashes files;
+  std::vector<std::string> found;
+  std::string css, map;
+
+  files.push_back(writeFile("a.less", "@import \"b.less\";"));
+  files.push_back(writeFile("b.less", "a { b: c; }"));
+  c.put("key1", files, "a{b:c}", NULL);
+  ASSERT_TRUE(c.get("key1", false, css, map, found));
+
+  writeFile("b.less", "a { b: d; }");
+  ASSERT_FALSE(c.get("key1", false, css, map, found));
+
+  // a file removed since it was read doesn't match either
+  writeFile("b.less", "a { b: c; }");
+  ASSERT_TRUE(c.get("key1", false, css, map, found));
+  unlink(files[1].first.c_str());
+  ASSERT_FALSE(c.get("key1", false, css, map, found));
+}
+
+TEST_F(CompilationCacheTest, MissingFileCreated) {
+  // a.less imports b.less, which was found in an include path after
+  // it was looked for next to a.less
+  CompilationCache c(cache, 0);
+  CompilationCache::FileHashes files;
+  std::vector<std::string> found;
+  std::string css, map;
+  std::string shadow = directory.path + "/b.less";
+
+  files.push_back(writeFile("a.less", "@import \"b.less\";"));
+  files.push_back(std::make_pair(shadow, std::string()));
+  mkdir((directory.path + "/inc").c_str(), 0777);
+  files.push_back(writeFile("inc/b.less", "x { y: inc; }"));
+  c.put("key1", files, "x{y:inc}", NULL);
+
+  ASSERT_TRUE(c.get("key1", false, css, map, found));
+  // the missing file is not one the output was compiled from
+  ASSERT_EQ(2U, found.size());
+  ASSERT_EQ(files[0].first, found[0]);
+  ASSERT_EQ(files[2].first, found[1]);
+
+  // the new file would be imported instead
+  writeFile("b.less", "x { y: local; }");
+  ASSERT_FALSE(c.get("key1", false, css, map, found));
+  unlink(shadow.c_str());
+  ASSERT_TRUE(c.get("key1", false, css, map, found));
+}
+
+TEST_F(CompilationCacheTest, ChangedWhileCompiling) {
+  // the output is stored under the contents that were read, not the
+  // contents of the files when it is stored
+  CompilationCache c(cache, 0);
+  CompilationCache::FileHashes files;
+  std::vector<std::string> found;
+  std::string css, map;
+
+  files.push_back(writeFile("a.less", "a { b: c; }"));
+  writeFile("a.less", "a { b: d; }");
+  c.put("key1", files, "a{b:c}", NULL);
+  ASSERT_FALSE(c.get("key1", false, css, map, found));
+}
+
+TEST_F(CompilationCacheTest, LeastRecentlyUsed) {
+  CompilationCache::FileHashes files1, files2, files3;
+  std::vector<std::string> found;
+  std::string css, map;
+  unsigned long long hits, misses, size;
+  size_t entries;
+  time_t now = time(NULL);
+
+  files1.push_back(writeFile("a1.less", "a { b: 1; }"));
+  files2.push_back(writeFile("a2.less", "a { b: 2; }"));
+  files3.push_back(writeFile("a3.less", "a { b: 3; }"));
+
+  {
+    CompilationCache c(cache, 0);
+    c.put("key1", files1, "a{b:1}", NULL);
+    age(now - 200);
+    c.put("key2", files2, "a{b:2}", NULL);
+    age(now - 100);
+    c.getStats(hits, misses, entries, size);
+    ASSERT_EQ(2U, entries);
+
+    // using the first entry makes the second the least recently used
+    ASSERT_TRUE(c.get("key1", false, css, map, found));
+  }
+  {
+    // room for two entries
+    CompilationCache c(cache, size);
+    c.put("key3", files3, "a{b:3}", NULL);
+
+    c.getStats(hits, misses, entries, size);
+    ASSERT_EQ(2U, entries);
+    ASSERT_TRUE(c.get("key1", false, css, map, found));
+    ASSERT_FALSE(c.get("key2", false, css, map, found));
+    ASSERT_TRUE(c.get("key3", false, css, map, found));
+  }
+}
+
+TEST(Sha256Test, Digest) {
+  std::string million(1000000, 'a');
+  Sha256 sha;
+  
+  ASSERT_EQ("e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855",
+            Sha256::hash("", 0));
+  ASSERT_EQ("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+            Sha256::hash("abc", 3));
+  ASSERT_EQ("248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1",
+            Sha256::hash("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+                         56));
+
+  // added in pieces that don't line up with the blocks
+  sha.update(million.data(), 1);
+  sha.update(million.data(), 63);
+  sha.update(million.data(), 100);
+  sha.update(million.data() + 164, million.size() - 164);
+  ASSERT_EQ("cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0",
+            sha.getDigest());
+}
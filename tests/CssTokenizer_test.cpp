@@ -1,6 +1,8 @@
 
 #include "css/CssTokenizer.h"
+#include "css/InputBuffer.h"
 #include "gtest/gtest.h"
+#include <cstring>
 
 /**
  * Test if the tokenizer reckognizes the tokens in the input string.
@@ -153,3 +155,70 @@ TEST(CssTokenizerTest, StringEscape) {
   EXPECT_EQ(Token::STRING, t.readNextToken());
   EXPECT_STREQ("'string\\''", t.getToken().c_str());
 }
+
+/**
+ * Test if tokenizing a memory buffer gives the same tokens and
+ * locations as tokenizing a stream.
+ */
+TEST(CssTokenizerTest, Buffer) {
+  const char* str = "a { b: 'c' url(d.png); }\n/* e\n f */ #g 1.5em -h";
+  istringstream in(str);
+  CssTokenizer t1(in, "test"), t2(str, std::strlen(str), "test");
+
+  while (t1.readNextToken() != Token::EOS) {
+    ASSERT_EQ(t1.getTokenType(), t2.readNextToken());
+    EXPECT_STREQ(t1.getToken().c_str(), t2.getToken().c_str());
+    EXPECT_EQ(t1.getToken().line, t2.getToken().line);
+    EXPECT_EQ(t1.getToken().column, t2.getToken().column);
+  }
+  EXPECT_EQ(Token::EOS, t2.readNextToken());
+}
+
+TEST(CssTokenizerTest, InputBuffer) {
+  istringstream in("a{b:c}");
+  InputBuffer buffer(in);
+  CssTokenizer t(buffer, "test");
+
+  ASSERT_EQ((size_t)6, buffer.getLength());
+  EXPECT_EQ(Token::IDENTIFIER, t.readNextToken());
+  EXPECT_EQ(Token::BRACKET_OPEN, t.readNextToken());
+  EXPECT_EQ(Token::IDENTIFIER, t.readNextToken());
+  EXPECT_EQ(Token::COLON, t.readNextToken());
+  EXPECT_EQ(Token::IDENTIFIER, t.readNextToken());
+  EXPECT_EQ(Token::BRACKET_CLOSED, t.readNextToken());
+  EXPECT_EQ(Token::EOS, t.readNextToken());
+}
+
+/**
+ * Test that skipping long runs of whitespace, comments and strings in
+ * a buffer keeps the same tokens, lines and columns as reading a
+ * stream, for runs that cross the scanner's block boundaries.
+ */
+TEST(CssTokenizerTest, BufferLongRuns) {
+  for (size_t n = 0; n < 70; n++) {
+    string pad(n, 'x'), space(n, ' ');
+    string str = "a" + space + "\n\t" + space + "b /*" + pad + "\n" + pad +
+      "**" + pad + "*/ '" + pad + "\\'" + pad + "' \"" + pad + "\" c\n";
+    istringstream in(str);
+    CssTokenizer t1(in, "test"), t2(str.data(), str.size(), "test");
+
+    while (t1.readNextToken() != Token::EOS) {
+      ASSERT_EQ(t1.getTokenType(), t2.readNextToken());
+      EXPECT_EQ(t1.getToken(), t2.getToken());
+      EXPECT_EQ(t1.getToken().line, t2.getToken().line);
+      EXPECT_EQ(t1.getToken().column, t2.getToken().column);
+    }
+    EXPECT_EQ(Token::EOS, t2.readNextToken());
+  }
+}
+
+TEST(CssTokenizerTest, BufferUnterminated) {
+  string comment = "/*" + string(40, 'x'),
+    str = "'" + string(40, 'x') + "\n'";
+
+  CssTokenizer t1(comment.data(), comment.size(), "test"),
+    t2(str.data(), str.size(), "test");
+
+  EXPECT_THROW(t1.readNextToken(), ParseException*);
+  EXPECT_THROW(t2.readNextToken(), ParseException*);
+}
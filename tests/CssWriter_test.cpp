@@ -0,0 +1,210 @@
+#include "css/CssWriter.h"
+#include "css/SourceMapWriter.h"
+#include "gtest/gtest.h"
+
+#include <list>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <string.h>
+
+/**
+ * Append a token to <code>list</code>, one column after the previous
+ * token.
+ */
+static void tokens(TokenList &list, const char* source, unsigned int line,
+                   const char* text, Token::Type type) {
+  list.push_back(Token(text, type, line, list.size(), source));
+}
+
+static void writeRuleset(CssWriter &writer, const char* source,
+                         unsigned int line) {
+  TokenList selector, value;
+  Token property("b", Token::IDENTIFIER, line, 4, source);
+
+  tokens(selector, source, line, "a", Token::IDENTIFIER);
+  tokens(value, source, line, "c", Token::IDENTIFIER);
+
+  writer.writeRulesetStart(selector);
+  writer.writeDeclaration(property, value);
+  writer.writeRulesetEnd();
+}
+
+TEST(CssWriterTest, Buffered) {
+  std::ostringstream out;
+  CssWriter writer(out);
+
+  writeRuleset(writer, "a.less", 0);
+  ASSERT_EQ("", out.str());
+
+  writer.flush();
+  ASSERT_EQ("a{b:c}", out.str());
+}
+
+TEST(CssWriterTest, LargerThanBuffer) {
+  std::ostringstream out;
+  std::string expected;
+  unsigned int i;
+
+  {
+    CssWriter writer(out);
+
+    for (i = 0; i < 20000; i++) {
+      writeRuleset(writer, "a.less", i);
+      expected.append("a{b:c}");
+    }
+    // a full buffer is written without waiting for a flush
+    ASSERT_LT(0U, out.str().size());
+    ASSERT_GT(expected.size(), out.str().size());
+  }
+  // the rest is written when the writer is destroyed
+  ASSERT_EQ(expected, out.str());
+}
+
+TEST(CssWriterTest, RootPath) {
+  std::ostringstream out;
+  CssWriter writer(out);
+  TokenList selector, value;
+  Token property("background", Token::IDENTIFIER, 0, 0, "a.less");
+
+  tokens(selector, "a.less", 0, "a", Token::IDENTIFIER);
+  tokens(value, "a.less", 0, "url(\"img/a.png\")", Token::URL);
+  tokens(value, "a.less", 0, " ", Token::WHITESPACE);
+  tokens(value, "a.less", 0, "url(http://example.com/b.png)", Token::URL);
+
+  writer.rootpath = "../";
+  writer.writeRulesetStart(selector);
+  writer.writeDeclaration(property, value);
+  writer.writeRulesetEnd();
+  writer.flush();
+
+  // relative urls are rewritten, absolute ones are left alone
+  ASSERT_EQ("a{background:url(\"../img/a.png\") "
+            "url(http://example.com/b.png)}", out.str());
+}
+
+TEST(CssWriterTest, SameWithSourceMap) {
+  std::ostringstream out1, out2, map;
+  std::list<const char*> sources;
+  unsigned int i;
+
+  sources.push_back("a.less");
+  {
+    CssWriter writer(out1);
+    SourceMapWriter sourcemap(map, sources, "a.css");
+    CssWriter mapped(out2, sourcemap);
+
+    for (i = 0; i < 20000; i++) {
+      writeRuleset(writer, "a.less", i);
+      writeRuleset(mapped, "a.less", i);
+    }
+    mapped.flush();
+    sourcemap.close();
+  }
+  ASSERT_EQ(out1.str(), out2.str());
+}
+
+/**
+ * Decode the mappings of a source map into one string per segment,
+ * "line:column source:line:column" with absolute positions.
+ */
+static std::vector<std::string> decodeMappings(const std::string &map) {
+  std::vector<std::string> segments;
+  std::string mappings;
+  std::ostringstream segment;
+  size_t start = map.find("\"mappings\": \"") + 13;
+  int fields[4] = {0, 0, 0, 0}, field = 0, value = 0, shift = 0, digit;
+  unsigned int line = 0;
+  std::string::const_iterator i;
+
+  mappings = map.substr(start, map.find('"', start) - start);
+
+  for (i = mappings.begin(); i != mappings.end(); i++) {
+    if (*i == ';' || *i == ',') {
+      if (field == 4) {
+        segment.str("");
+        segment << line << ":" << fields[0] << " " << fields[1] << ":" <<
+          fields[2] << ":" << fields[3];
+        segments.push_back(segment.str());
+      }
+      field = 0;
+      if (*i == ';') {
+        line++;
+        fields[0] = 0;
+      }
+      continue;
+    }
+    digit = strchr(SourceMapWriter::base64, *i) - SourceMapWriter::base64;
+    value += (digit & 0x1F) << shift;
+    shift += 5;
+    if ((digit & 0x20) == 0) {
+      fields[field++] += (value & 1) ? -(value >> 1) : (value >> 1);
+      value = 0;
+      shift = 0;
+    }
+  }
+  return segments;
+}
+
+TEST(SourceMapWriterTest, Preamble) {
+  std::ostringstream map;
+  std::list<const char*> sources;
+
+  sources.push_back("/base/a.less");
+  sources.push_back("/base/b.less");
+  SourceMapWriter sourcemap(map, sources, "/base/a.css", "root/", "/base/");
+  sourcemap.close();
+
+  ASSERT_EQ("{\"version\" : 3,\"sourceRoot\": \"root/\","
+            "\"file\": \"a.css\",\"sources\": [\"a.less\",\"b.less\"],"
+            "\"names\": [],\"mappings\": \"\"}\n", map.str());
+}
+
+TEST(SourceMapWriterTest, Mappings) {
+  std::ostringstream map;
+  std::list<const char*> sources;
+  const char* a = "a.less", *b = "b.less";
+  std::vector<std::string> segments;
+
+  sources.push_back(a);
+  sources.push_back(b);
+  SourceMapWriter sourcemap(map, sources, "a.css");
+
+  sourcemap.writeMapping(0, Token("a", Token::IDENTIFIER, 3, 2, a));
+  // the same source position is left out
+  sourcemap.writeMapping(1, Token("a", Token::IDENTIFIER, 3, 2, a));
+  // large and negative differences
+  sourcemap.writeMapping(70000, Token("b", Token::IDENTIFIER, 1000, 40, b));
+  sourcemap.writeMapping(70010, Token("c", Token::IDENTIFIER, 1, 0, a));
+  sourcemap.writeNewline();
+  // a new line repeats the position
+  sourcemap.writeMapping(5, Token("c", Token::IDENTIFIER, 1, 0, a));
+  sourcemap.close();
+
+  segments = decodeMappings(map.str());
+  ASSERT_EQ(4U, segments.size());
+  ASSERT_EQ("0:0 0:3:2", segments[0]);
+  ASSERT_EQ("0:70000 1:1000:40", segments[1]);
+  ASSERT_EQ("0:70010 0:1:0", segments[2]);
+  ASSERT_EQ("1:5 0:1:0", segments[3]);
+}
+
+TEST(SourceMapWriterTest, SourceAddedLater) {
+  // imports add sources after the writer is created
+  std::ostringstream map;
+  std::list<const char*> sources;
+  const char* a = "a.less", *b = "b.less";
+  std::vector<std::string> segments;
+
+  sources.push_back(a);
+  SourceMapWriter sourcemap(map, sources, "a.css");
+
+  sourcemap.writeMapping(0, Token("a", Token::IDENTIFIER, 0, 0, a));
+  sources.push_back(b);
+  sourcemap.writeMapping(1, Token("b", Token::IDENTIFIER, 0, 0, b));
+  sourcemap.close();
+
+  segments = decodeMappings(map.str());
+  ASSERT_EQ(2U, segments.size());
+  ASSERT_EQ("0:1 1:0:0", segments[1]);
+}
@@ -0,0 +1,94 @@
+#include <config.h>
+
+#include "less/LessParser.h"
+#include "gtest/gtest.h"
+
+#include "TempDirectory.h"
+
+#include <list>
+#include <string>
+#include <sstream>
+
+#ifdef WITH_LIBPNG
+
+/**
+ * A 2x3 png with the background color #336699.
+ */
+static const std::string PNG_2X3(
+  "\x89\x50\x4e\x47\x0d\x0a\x1a\x0a\x00\x00\x00\x0d\x49\x48\x44\x52\x00\x00"
+  "\x00\x02\x00\x00\x00\x03\x08\x02\x00\x00\x00\x36\x88\x49\xd6\x00\x00\x00"
+  "\x06\x62\x4b\x47\x44\x00\x33\x00\x66\x00\x99\xda\x4b\xe5\x5b\x00\x00\x00"
+  "\x10\x49\x44\x41\x54\x78\x9c\x63\x30\x4e\x9b\x09\x44\x0c\x28\x14\x00\x48"
+  "\xff\x07\x2d\x9b\x82\x40\x72\x00\x00\x00\x00\x49\x45\x4e\x44\xae\x42\x60"
+  "\x82", 91);
+
+/**
+ * A 5x1 png with the background color #ff0000.
+ */
+static const std::string PNG_5X1(
+  "\x89\x50\x4e\x47\x0d\x0a\x1a\x0a\x00\x00\x00\x0d\x49\x48\x44\x52\x00\x00"
+  "\x00\x05\x00\x00\x00\x01\x08\x02\x00\x00\x00\x99\x9c\xf3\xa4\x00\x00\x00"
+  "\x06\x62\x4b\x47\x44\x00\xff\x00\x00\x00\x00\x33\x27\x7c\xf3\x00\x00\x00"
+  "\x0d\x49\x44\x41\x54\x78\x9c\x63\xf8\xcf\xc0\x80\x8c\x00\x2c\xe3\x04\xfc"
+  "\x6c\xe3\xa2\x69\x00\x00\x00\x00\x49\x45\x4e\x44\xae\x42\x60\x82", 88);
+
+class ImageCacheTest : public ::testing::Test {
+public:
+  TempDirectory directory;
+
+  /**
+   * Compile a ruleset with the size and background of the image at
+   * <code>path</code>.
+   */
+  std::string compile(const std::string &path) {
+    std::string less = "a { w: imgwidth(url(\"" + path + "\")); "
+      "h: imgheight(url(\"" + path + "\")); "
+      "c: imgbackground(url(\"" + path + "\")); }";
+    std::istringstream in(less);
+    LessTokenizer t(in, "test");
+    std::list<const char*> sources;
+    LessParser p(t, sources);
+    LessStylesheet stylesheet;
+    Stylesheet css;
+    ProcessingContext context;
+    std::ostringstream out;
+
+    {
+      CssWriter writer(out);
+
+      p.parseStylesheet(stylesheet);
+      stylesheet.process(css, context);
+      css.write(writer);
+    }
+    return out.str();
+  }
+};
+
+TEST_F(ImageCacheTest, Cached) {
+  std::string path = directory.write("a.png", PNG_2X3, 1000);
+
+  ASSERT_EQ("a{w:2px;h:3px;c:#369}", compile(path));
+  // the second time the size and color are copied from the cache
+  ASSERT_EQ("a{w:2px;h:3px;c:#369}", compile(path));
+}
+
+TEST_F(ImageCacheTest, Changed) {
+  std::string path = directory.write("a.png", PNG_2X3, 1000);
+
+  ASSERT_EQ("a{w:2px;h:3px;c:#369}", compile(path));
+  directory.write("a.png", PNG_5X1, 2000);
+  ASSERT_EQ("a{w:5px;h:1px;c:#f00}", compile(path));
+}
+
+TEST_F(ImageCacheTest, NotAnImage) {
+  std::string path = directory.write("a.png", "not a png", 1000);
+
+  ASSERT_EQ("a{w:0px;h:0px;c:#000}", compile(path));
+  ASSERT_EQ("a{w:0px;h:0px;c:#000}", compile(path));
+
+  // an image written over it is loaded
+  directory.write("a.png", PNG_2X3, 2000);
+  ASSERT_EQ("a{w:2px;h:3px;c:#369}", compile(path));
+}
+
+#endif
@@ -0,0 +1,180 @@
+#include "less/ImportCache.h"
+#include "Sha256.h"
+#include "less/ImportPathCache.h"
+#include "less/LessParser.h"
+#include "gtest/gtest.h"
+
+#include "TempDirectory.h"
+
+#include <list>
+#include <vector>
+#include <string>
+
+class ImportCacheTest : public ::testing::Test {
+public:
+  TempDirectory directory;
+
+  std::string readTokens(BufferedTokenizer* tokens) {
+    std::string result;
+
+    while (tokens->readNextToken() != Token::EOS)
+      result.append(tokens->getToken());
+    delete tokens;
+    return result;
+  }
+};
+
+TEST_F(ImportCacheTest, Hit) {
+  ImportCache &cache = ImportCache::getInstance();
+  std::string path = directory.write("a.less", "a { b: c; }", 1000);
+  size_t hits, misses;
+  BufferedTokenizer* tokens;
+
+  ASSERT_EQ("a { b: c; }", readTokens(cache.get(path)));
+  hits = cache.getHits();
+  misses = cache.getMisses();
+
+  tokens = cache.get(path);
+  ASSERT_EQ(Sha256::hash("a { b: c; }", 11), tokens->getHash());
+  ASSERT_EQ("a { b: c; }", readTokens(tokens));
+  ASSERT_EQ(hits + 1, cache.getHits());
+  ASSERT_EQ(misses, cache.getMisses());
+}
+
+TEST_F(ImportCacheTest, UnchangedContent) {
+  // a new modification time makes the file be read again, but the
+  // same contents are not tokenized again
+  ImportCache &cache = ImportCache::getInstance();
+  std::string path = directory.write("a.less", "a { b: c; }", 1000);
+  size_t hits, misses;
+
+  readTokens(cache.get(path));
+  hits = cache.getHits();
+  misses = cache.getMisses();
+
+  directory.write("a.less", "a { b: c; }", 2000);
+  ASSERT_EQ("a { b: c; }", readTokens(cache.get(path)));
+  ASSERT_EQ(hits + 1, cache.getHits());
+  ASSERT_EQ(misses, cache.getMisses());
+}
+
+TEST_F(ImportCacheTest, ChangedModificationTime) {
+  // same size, different contents
+  ImportCache &cache = ImportCache::getInstance();
+  std::string path = directory.write("a.less", "a { b: c; }", 1000);
+  size_t hits, misses;
+  BufferedTokenizer* tokens;
+
+  readTokens(cache.get(path));
+  hits = cache.getHits();
+  misses = cache.getMisses();
+
+  directory.write("a.less", "a { b: d; }", 2000);
+  tokens = cache.get(path);
+  ASSERT_EQ(Sha256::hash("a { b: d; }", 11), tokens->getHash());
+  ASSERT_EQ("a { b: d; }", readTokens(tokens));
+  ASSERT_EQ(hits, cache.getHits());
+  ASSERT_EQ(misses + 1, cache.getMisses());
+}
+
+TEST_F(ImportCacheTest, ChangedSize) {
+  // same modification time, different size
+  ImportCache &cache = ImportCache::getInstance();
+  std::string path = directory.write("a.less", "a { b: c; }", 1000);
+  size_t hits, misses;
+
+  readTokens(cache.get(path));
+  hits = cache.getHits();
+  misses = cache.getMisses();
+
+  directory.write("a.less", "a { b: cd; }", 1000);
+  ASSERT_EQ("a { b: cd; }", readTokens(cache.get(path)));
+  ASSERT_EQ(hits, cache.getHits());
+  ASSERT_EQ(misses + 1, cache.getMisses());
+}
+
+TEST_F(ImportCacheTest, ImportOnce) {
+  std::string path = directory.write("a.less", "a { b: c; }", 1000);
+  std::string less = "@import \"" + path + "\"; @import \"" + path + "\";";
+  std::istringstream in(less);
+  LessTokenizer t(in, "test");
+  std::list<const char*> sources, includePaths;
+  LessParser p(t, sources);
+  LessStylesheet stylesheet;
+  Stylesheet css;
+  ProcessingContext context;
+  std::ostringstream out;
+  CssWriter writer(out);
+
+  p.includePaths = &includePaths;
+  p.parseStylesheet(stylesheet);
+  stylesheet.process(css, context);
+  css.write(writer);
+  ASSERT_STREQ("a{b:c}", out.str().c_str());
+}
+
+TEST_F(ImportCacheTest, ImportMultiple) {
+  ImportCache &cache = ImportCache::getInstance();
+  std::string path = directory.write("a.less", "a { b: c; }", 1000);
+  std::string less = "@import (multiple) \"" + path +
+    "\"; @import (multiple) \"" + path + "\";";
+  std::istringstream in(less);
+  LessTokenizer t(in, "test");
+  std::list<const char*> sources, includePaths;
+  LessParser p(t, sources);
+  LessStylesheet stylesheet;
+  Stylesheet css;
+  ProcessingContext context;
+  std::ostringstream out;
+  CssWriter writer(out);
+  size_t hits, misses;
+
+  hits = cache.getHits();
+  misses = cache.getMisses();
+
+  p.includePaths = &includePaths;
+  p.parseStylesheet(stylesheet);
+  stylesheet.process(css, context);
+  css.write(writer);
+  ASSERT_STREQ("a{b:c}a{b:c}", out.str().c_str());
+  // the second import is read from the cache
+  ASSERT_EQ(hits + 1, cache.getHits());
+  ASSERT_EQ(misses + 1, cache.getMisses());
+}
+
+TEST_F(ImportCacheTest, PathCache) {
+  ImportPathCache &cache = ImportPathCache::getInstance();
+  std::vector<std::string> probed;
+  std::string key = directory.path + "/a.less", filename;
+  bool found;
+
+  probed.push_back(key);
+  cache.put(key, key, true, probed);
+  ASSERT_TRUE(cache.get(key, filename, found));
+  ASSERT_TRUE(found);
+  ASSERT_EQ(key, filename);
+
+  cache.clear();
+  ASSERT_FALSE(cache.get(key, filename, found));
+}
+
+TEST_F(ImportCacheTest, PathCacheCreatedFile) {
+  // a file that was not found is looked for again once its directory
+  // changed
+  ImportPathCache &cache = ImportPathCache::getInstance();
+  std::vector<std::string> probed;
+  std::string key = directory.path + "/missing.less", filename;
+  bool found;
+
+  probed.push_back(key);
+  cache.put(key, "", false, probed);
+  cache.check();
+  ASSERT_TRUE(cache.get(key, filename, found));
+  ASSERT_FALSE(found);
+
+  directory.write("missing.less", "", 1000);
+  // not before the next compilation
+  ASSERT_TRUE(cache.get(key, filename, found));
+  cache.check();
+  ASSERT_FALSE(cache.get(key, filename, found));
+}
@@ -0,0 +1,208 @@
+#include "less/ImportResolver.h"
+#include "less/LessParser.h"
+#include "css/CssWriter.h"
+#include "gtest/gtest.h"
+
+#include "TempDirectory.h"
+
+#include <list>
+#include <string>
+#include <sstream>
+#include <sys/stat.h>
+
+class ImportResolverTest : public ::testing::Test {
+public:
+  TempDirectory directory;
+
+  /**
+   * Import <code>name</code> from the temporary directory.
+   */
+  std::string import(const char* name, const char* directives = "") {
+    return std::string("@import ") + directives + " \"" + directory.path +
+      "/" + name + "\";\n";
+  }
+
+  /**
+   * Parse and process <code>less</code>, reading its imports on
+   * <code>threads</code> workers, or on the parser if it is 0. The
+   * resolver scans <code>scan</code> for imports instead of the input
+   * if it is given.
+   *
+   * @return the css; the part before an error if there was one, which
+   *         is rethrown after <code>css</code> is set.
+   */
+  void compile(const std::string &less, unsigned int threads,
+               std::string &css, const std::string* scan = NULL) {
+    std::istringstream input(less), scanInput(scan != NULL ? *scan : "");
+    InputBuffer in(input), scanned(scanInput);
+    LessTokenizer t(in, "test");
+    std::list<const char*> sources, includePaths;
+    LessParser p(t, sources);
+    ImportResolver resolver(&includePaths, threads);
+    LessStylesheet stylesheet;
+    Stylesheet result;
+    ProcessingContext context;
+    std::ostringstream out;
+    CssWriter writer(out);
+    ParseException* parseError = NULL;
+    IOException* ioError = NULL;
+
+    p.includePaths = &includePaths;
+    if (threads > 0) {
+      resolver.scan(scan != NULL ? scanned : in, "test");
+      p.resolver = &resolver;
+    }
+
+    try {
+      p.parseStylesheet(stylesheet);
+    } catch (ParseException* e) {
+      parseError = e;
+    } catch (IOException* e) {
+      ioError = e;
+    }
+    stylesheet.process(result, context);
+    result.write(writer);
+    css = out.str();
+
+    if (parseError != NULL)
+      throw parseError;
+    if (ioError != NULL)
+      throw ioError;
+  }
+
+  std::string compile(const std::string &less, unsigned int threads) {
+    std::string css;
+
+    compile(less, threads, css);
+    return css;
+  }
+};
+
+TEST_F(ImportResolverTest, SpliceOrder) {
+  std::string less, css;
+
+  directory.write("a.less", "@import \"a1.less\";\n.a { x: a; }\n"
+                  "@import \"a2.less\";\n");
+  directory.write("a1.less", ".a1 { x: a1; }\n");
+  directory.write("a2.less", ".a2 { x: a2; }\n@import \"c.less\";\n");
+  directory.write("b.less", ".b { x: b; }\n@import \"c.less\";\n");
+  directory.write("c.less", ".c { x: c; }\n");
+
+  less = import("a.less") + import("b.less") + ".main { x: m; }";
+  css = ".a1{x:a1}.a{x:a}.a2{x:a2}.c{x:c}.b{x:b}.main{x:m}";
+  ASSERT_EQ(css, compile(less, 0));
+  ASSERT_EQ(css, compile(less, 1));
+  ASSERT_EQ(css, compile(less, 4));
+}
+
+TEST_F(ImportResolverTest, Directives) {
+  std::string less, css;
+
+  directory.write("once.less", ".once { x: 1; }\n");
+  directory.write("multiple.less", ".multiple { x: 2; }\n");
+  directory.write("reference.less", ".ref { x: 3; }\n"
+                  ".mixin() { y: 4; }\n");
+
+  less = import("once.less") + import("once.less", "(once)") +
+    import("multiple.less", "(multiple)") +
+    import("multiple.less", "(multiple)") +
+    import("reference.less", "(reference)") +
+    import("missing.less", "(optional)") +
+    ".use { .mixin(); }";
+  css = ".once{x:1}.multiple{x:2}.multiple{x:2}.use{y:4}";
+  ASSERT_EQ(css, compile(less, 0));
+  ASSERT_EQ(css, compile(less, 4));
+}
+
+TEST_F(ImportResolverTest, WorkerError) {
+  // the tokenizer error in the second file is found by a worker, but
+  // only thrown when the parser gets to the file
+  std::string less, sequential, parallel;
+  unsigned int line = 0;
+
+  directory.write("before.less", ".before { x: 1; }\n");
+  directory.write("error.less", ".error { x: 2; }\n.string { x: \"a\n");
+  directory.write("after.less", ".after { x: 3; }\n");
+  less = import("before.less") + import("error.less") + import("after.less");
+
+  try {
+    compile(less, 0, sequential);
+    FAIL() << "no error";
+  } catch (ParseException* e) {
+    line = e->getLineNumber();
+    delete e;
+  }
+  try {
+    compile(less, 4, parallel);
+    FAIL() << "no error";
+  } catch (ParseException* e) {
+    ASSERT_EQ(line, e->getLineNumber());
+    ASSERT_EQ(directory.path + "/error.less", e->getSource());
+    delete e;
+  }
+  ASSERT_EQ(".before{x:1}.error{x:2}", sequential);
+  ASSERT_EQ(sequential, parallel);
+}
+
+TEST_F(ImportResolverTest, WorkerIOError) {
+  // a directory can be found but not read
+  std::string less, css;
+
+  directory.write("before.less", ".before { x: 1; }\n");
+  mkdir((directory.path + "/directory.less").c_str(), 0755);
+  less = import("before.less") + import("directory.less") + ".after { }";
+
+  try {
+    compile(less, 4, css);
+    FAIL() << "no error";
+  } catch (IOException* e) {
+    delete e;
+  }
+  ASSERT_EQ(".before{x:1}", css);
+}
+
+TEST_F(ImportResolverTest, MissedByScan) {
+  // the resolver only sees the first import, so the parser reads the
+  // second one itself
+  std::string less, scan = import("a.less"), css;
+
+  directory.write("a.less", ".a { x: a; }\n");
+  directory.write("b.less", ".b { x: b; }\n");
+  less = import("a.less") + import("b.less");
+
+  compile(less, 4, css, &scan);
+  ASSERT_EQ(".a{x:a}.b{x:b}", css);
+  ASSERT_EQ(compile(less, 0), css);
+}
+
+TEST_F(ImportResolverTest, NotQueued) {
+  std::list<const char*> includePaths;
+  ImportResolver resolver(&includePaths, 4);
+
+  ASSERT_TRUE(resolver.take(directory.path + "/a.less") == NULL);
+}
+
+TEST_F(ImportResolverTest, SameAsSequential) {
+  // a tree of imports, each of which imports the two after it
+  std::ostringstream less, file;
+  std::string css;
+  int i;
+
+  for (i = 0; i < 40; i++) {
+    file.str("");
+    file << ".f" << i << " { x: " << i << "; }\n";
+    if (i + 1 < 40)
+      file << "@import (multiple) \"f" << (i + 1) << ".less\";\n";
+    if (i + 2 < 40 && i % 3 == 0)
+      file << "@import \"f" << (i + 2) << ".less\";\n";
+    file << ".g" << i << " { .f" << i << "; }\n";
+    directory.write("f" + std::to_string(i) + ".less", file.str());
+  }
+  less << import("f0.less") << import("f20.less") << import("f5.less");
+
+  css = compile(less.str(), 0);
+  ASSERT_NE("", css);
+  ASSERT_EQ(css, compile(less.str(), 1));
+  ASSERT_EQ(css, compile(less.str(), 4));
+  ASSERT_EQ(css, compile(less.str(), 16));
+}
@@ -1,5 +1,6 @@
 
 #include "less/LessParser.h"
+#include "lessstylesheet/TokenMatcher.h"
 #include "gtest/gtest.h"
 #include <list>
 
@@ -1068,3 +1069,269 @@ TEST_F(LessParserTest, ExtendOutsideMedia) {
   ASSERT_STREQ("@media print{.selector,.screenClass{color:black;}}\
 .selector{color:red;}@media screen{.selector{color: blue;}}", out->str().c_str());
 }
+
+TEST_F(LessParserTest, MixinExpansionReused) {
+  LessRuleset* mixin;
+  
+  in->str(".m { color: red; } \
+a { .m; } \
+b { .m; }");
+  
+  p->parseStylesheet(*less);
+  less->process(*css, *context);
+  css->write(*writer);
+  ASSERT_STREQ(".m{color:red}a{color:red}b{color:red}", out->str().c_str());
+
+  mixin = dynamic_cast<LessRuleset*>(less->getRulesets().front());
+  ASSERT_TRUE(mixin != NULL);
+  EXPECT_TRUE(context->getExpansion(*mixin) != NULL);
+}
+
+TEST_F(LessParserTest, MixinExpansionArguments) {
+  in->str(".m(@c) { color: @c; } \
+a { .m(red); } \
+b { .m(blue); } \
+c { .m(red); }");
+  
+  p->parseStylesheet(*less);
+  less->process(*css, *context);
+  css->write(*writer);
+  ASSERT_STREQ("a{color:red}b{color:blue}c{color:red}", out->str().c_str());
+}
+
+TEST_F(LessParserTest, MixinExpansionChangedVariable) {
+  // .m reads @c from the arguments of the call to .p
+  in->str(".m { color: @c; width: @w; } \
+.p(@c; @w: 1px) { .m; } \
+a { .p(red); } \
+b { .p(blue); } \
+c { .p(red; 2px); } \
+d { .p(red); }");
+  
+  p->parseStylesheet(*less);
+  less->process(*css, *context);
+  css->write(*writer);
+  ASSERT_STREQ(".m{color:@c;width:@w}\
+a{color:red;width:1px}\
+b{color:blue;width:1px}\
+c{color:red;width:2px}\
+d{color:red;width:1px}", out->str().c_str());
+}
+
+TEST_F(LessParserTest, TailCallLoop) {
+  // the guard fails on the last call
+  in->str(".loop(@i) when (@i > 0) { \
+  w-@{i}: @i; \
+  .loop(@i - 1); \
+} \
+a { .loop(3); } \
+b { .loop(0); c: d; }");
+  
+  p->parseStylesheet(*less);
+  less->process(*css, *context);
+  css->write(*writer);
+  ASSERT_STREQ("a{w-3:3;w-2:2;w-1:1}b{c:d}", out->str().c_str());
+}
+
+TEST_F(LessParserTest, TailCallNestedRules) {
+  in->str(".loop(@i) when (@i > 0) { \
+  .c-@{i} { w: @i; } \
+  .loop(@i - 1); \
+} \
+a { .loop(3); }");
+  
+  p->parseStylesheet(*less);
+  less->process(*css, *context);
+  css->write(*writer);
+  ASSERT_STREQ("a .c-1{w:1}a .c-2{w:2}a .c-3{w:3}", out->str().c_str());
+}
+
+TEST_F(LessParserTest, TailCallOverloads) {
+  // both mixins match every call, so the loop is not run as a tail call
+  in->str(".loop(@i) when (@i > 0) { \
+  w-@{i}: @i; \
+  .loop(@i - 1); \
+} \
+.loop(@i) when (@i = 0) { end: done; } \
+a { .loop(3); } \
+.m(@i) when (@i > 0) { a: @i; .m(@i - 1); } \
+.m(@i) { b: @i; } \
+x { .m(2); }");
+  
+  p->parseStylesheet(*less);
+  less->process(*css, *context);
+  css->write(*writer);
+  ASSERT_STREQ("a{w-3:3;w-2:2;w-1:1;end:done}x{a:2;a:1;b:0;b:1;b:2}",
+               out->str().c_str());
+}
+
+TEST_F(LessParserTest, TailCallDeepLoop) {
+  // deeper than the stack allows for recursive calls
+  in->str(".loop(@i) when (@i > 0) { .loop(@i - 1); } \
+a { .loop(50000); x: y; }");
+  
+  p->parseStylesheet(*less);
+  less->process(*css, *context);
+  css->write(*writer);
+  ASSERT_STREQ("a{x:y}", out->str().c_str());
+}
+
+TEST_F(LessParserTest, ExtendExactMatch) {
+  // without 'all' only whole selectors match
+  in->str(".a { x: 1; } \
+.a.b { y: 2; } \
+.x .a { z: 3; } \
+div.a { w: 4; } \
+.c:extend(.a) {} \
+.d:extend(div.a) {}");
+  
+  p->parseStylesheet(*less);
+  less->process(*css, *context);
+  css->write(*writer);
+  ASSERT_STREQ(".a,.c{x:1}.a.b{y:2}.x .a{z:3}div.a,.d{w:4}",
+               out->str().c_str());
+}
+
+TEST_F(LessParserTest, ExtendAllPartialMatch) {
+  in->str(".a { x: 1; } \
+.a.b { y: 2; } \
+.x > .a:hover { z: 3; } \
+.d .a .e { w: 4; } \
+.c:extend(.a all) {}");
+  
+  p->parseStylesheet(*less);
+  less->process(*css, *context);
+  css->write(*writer);
+  ASSERT_STREQ(".a,.c{x:1}.a.b,.c.b{y:2}\
+.x > .a:hover,.x > .c:hover{z:3}.d .a .e,.d .c .e{w:4}",
+               out->str().c_str());
+}
+
+TEST_F(LessParserTest, ExtendAllCompoundTarget) {
+  // the target has more than one part, and an extension adds a selector
+  // that a later one matches
+  in->str(".a.b { x: 1; } \
+.b .a { y: 2; } \
+.c:extend(.a.b all) {} \
+.e:extend(.b all) {}");
+  
+  p->parseStylesheet(*less);
+  less->process(*css, *context);
+  css->write(*writer);
+  ASSERT_STREQ(".a.b,.c,.a.e{x:1}.b .a,.e .a{y:2}", out->str().c_str());
+}
+
+TEST_F(LessParserTest, ExtendChain) {
+  in->str(".a { x: 1; } \
+.b:extend(.a) {} \
+.c:extend(.b) {} \
+.d:extend(.c all) {} \
+.f .g { y: 2; } \
+.h:extend(.f .g) {}");
+  
+  p->parseStylesheet(*less);
+  less->process(*css, *context);
+  css->write(*writer);
+  ASSERT_STREQ(".a,.b,.c,.d{x:1}.f .g,.h{y:2}", out->str().c_str());
+}
+
+TEST_F(LessParserTest, MixinIndexOrder) {
+  // every ruleset that matches is called, in the order of the source
+  in->str(".m { a: 1; } .n { b: 2; } .m { c: 3; } x { .m; .n; }");
+  
+  p->parseStylesheet(*less);
+  less->process(*css, *context);
+  css->write(*writer);
+  ASSERT_STREQ(".m{a:1}.n{b:2}.m{c:3}x{a:1;c:3;b:2}", out->str().c_str());
+}
+
+TEST_F(LessParserTest, MixinIndexSelectorList) {
+  // each part of a selector list is indexed, and only whole parts match
+  in->str(".a, .b { x: 1; } .c .b { y: 2; } y { .b; }");
+  
+  p->parseStylesheet(*less);
+  less->process(*css, *context);
+  css->write(*writer);
+  ASSERT_STREQ(".a,.b{x:1}.c .b{y:2}y{x:1}", out->str().c_str());
+}
+
+TEST_F(LessParserTest, MixinIndexNamespace) {
+  in->str("#ns { .m() { a: 1; } .n { b: 2; } } \
+.m { c: 3; } \
+#id { d: 4; } \
+z { #ns > .m(); #ns.n; .m; #id; }");
+  
+  p->parseStylesheet(*less);
+  less->process(*css, *context);
+  css->write(*writer);
+  ASSERT_STREQ("#ns .n{b:2}.m{c:3}#id{d:4}z{a:1;b:2;c:3;d:4}",
+               out->str().c_str());
+}
+
+TEST_F(LessParserTest, MixinIndexParametric) {
+  // the index only narrows down the candidates; arguments and guards
+  // still decide which are called
+  in->str(".m(@a) when (@a > 1) { big: @a; } \
+.m(@a) { any: @a; } \
+.m(@a; @b) { two: @a @b; } \
+w { .m(2); .m(1); .m(1; 2); }");
+  
+  p->parseStylesheet(*less);
+  less->process(*css, *context);
+  css->write(*writer);
+  ASSERT_STREQ("w{big:2;any:2;any:1;two:1 2}", out->str().c_str());
+}
+
+TEST_F(LessParserTest, ExtendAllOverlapping) {
+  // several all-extensions match the same selectors; each is applied,
+  // also to the selectors the ones before it added
+  in->str(".a .b { x: 1; } \
+.b .c { y: 2; } \
+.a > .c { z: 3; } \
+.p:extend(.a all) {} \
+.q:extend(.b all) {} \
+.r:extend(.a .b all) {}");
+  
+  p->parseStylesheet(*less);
+  less->process(*css, *context);
+  css->write(*writer);
+  ASSERT_STREQ(".a .b,.p .b,.a .q,.p .q,.r{x:1}.b .c,.q .c{y:2}\
+.a > .c,.p > .c{z:3}", out->str().c_str());
+}
+
+TEST(TokenMatcherTest, Find) {
+  // the patterns 'he', 'she', 'his' and 'hers' in 'ushers'
+  const char* patterns[] = {"he", "she", "his", "hers", NULL};
+  const char* text = "ushers";
+  std::vector<TokenMatcher::Key> keys;
+  std::set<size_t> ids;
+  TokenMatcher matcher;
+  size_t i;
+  const char* c;
+
+  ASSERT_TRUE(matcher.empty());
+  for (i = 0; patterns[i] != NULL; i++) {
+    keys.clear();
+    for (c = patterns[i]; *c != '\0'; c++)
+      keys.push_back(*c);
+    matcher.add(keys, i);
+  }
+  matcher.build();
+  ASSERT_FALSE(matcher.empty());
+
+  keys.clear();
+  for (c = text; *c != '\0'; c++)
+    keys.push_back(*c);
+  matcher.find(keys, ids);
+
+  ASSERT_EQ(3U, ids.size());
+  ASSERT_EQ(1U, ids.count(0));
+  ASSERT_EQ(1U, ids.count(1));
+  ASSERT_EQ(1U, ids.count(3));
+
+  // nothing matches
+  ids.clear();
+  keys.assign(3, 'x');
+  matcher.find(keys, ids);
+  ASSERT_TRUE(ids.empty());
+}
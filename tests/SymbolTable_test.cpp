@@ -0,0 +1,59 @@
+#include "SymbolTable.h"
+#include "Token.h"
+#include "gtest/gtest.h"
+
+TEST(SymbolTableTest, Intern) {
+  Symbol a = SymbolTable::intern("symbol-table-test-a"),
+    b = SymbolTable::intern("symbol-table-test-b");
+
+  ASSERT_NE(SymbolTable::NONE, a);
+  ASSERT_NE(a, b);
+  ASSERT_EQ(a, SymbolTable::intern("symbol-table-test-a"));
+  ASSERT_EQ("symbol-table-test-a", SymbolTable::getString(a));
+  ASSERT_EQ("symbol-table-test-b", SymbolTable::getString(b));
+  ASSERT_EQ("", SymbolTable::getString(SymbolTable::NONE));
+}
+
+TEST(SymbolTableTest, Compilation) {
+  Symbol color = SymbolTable::intern("color"), name;
+  size_t size = SymbolTable::size();
+
+  {
+    SymbolTable symbols;
+    SymbolScope scope(symbols);
+
+    // well-known names have the same symbol in every table
+    ASSERT_EQ(color, SymbolTable::intern("color"));
+    ASSERT_EQ(Token::BUILTIN_COMMA.getSymbol(), SymbolTable::intern(","));
+
+    name = SymbolTable::intern("symbol-table-test-compilation");
+    ASSERT_EQ("symbol-table-test-compilation", SymbolTable::getString(name));
+    ASSERT_EQ(&symbols, SymbolTable::getCurrent());
+  }
+
+  // the names of the compilation were discarded with its table
+  ASSERT_TRUE(SymbolTable::getCurrent() == NULL);
+  ASSERT_EQ(size, SymbolTable::size());
+  ASSERT_EQ("color", SymbolTable::getString(color));
+}
+
+TEST(SymbolTableTest, OutsideCompilation) {
+  Token outside("symbol-table-test-outside", Token::IDENTIFIER, 0, 0,
+                Token::BUILTIN_SOURCE),
+    inside("symbol-table-test-inside", Token::IDENTIFIER, 0, 0,
+           Token::BUILTIN_SOURCE);
+
+  outside.getSymbol();
+  {
+    SymbolTable symbols;
+    SymbolScope scope(symbols);
+
+    // symbols of the process wide table and of a compilation differ
+    ASSERT_NE(outside.getSymbol(), inside.getSymbol());
+    ASSERT_FALSE(outside == inside);
+    ASSERT_EQ("symbol-table-test-inside",
+              SymbolTable::getString(inside.getSymbol()));
+    ASSERT_EQ("symbol-table-test-outside",
+              SymbolTable::getString(outside.getSymbol()));
+  }
+}
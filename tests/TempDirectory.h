@@ -0,0 +1,84 @@
+#ifndef __TempDirectory_h__
+#define __TempDirectory_h__
+
+#include <string>
+#include <fstream>
+#include <cstdlib>
+#include <ctime>
+#include <dirent.h>
+#include <unistd.h>
+#include <utime.h>
+#include <sys/stat.h>
+
+/**
+ * A directory the tests of the file caches write to. It is removed
+ * along with everything in it when the object is destroyed.
+ */
+class TempDirectory {
+public:
+  std::string path;
+
+  TempDirectory() {
+    char name[] = "/tmp/lessc_test_XXXXXX";
+
+    if (mkdtemp(name) != NULL)
+      path = name;
+  }
+  ~TempDirectory() {
+    if (!path.empty())
+      remove(path);
+  }
+
+  /**
+   * Write <code>contents</code> to the file <code>name</code> in the
+   * directory.
+   *
+   * @return the path of the file.
+   */
+  std::string write(const std::string &name,
+                    const std::string &contents) const {
+    std::string file = path + "/" + name;
+    std::ofstream out(file.c_str(), std::ios::out | std::ios::binary);
+
+    out << contents;
+    return file;
+  }
+
+  /**
+   * Write a file and set its modification time.
+   */
+  std::string write(const std::string &name,
+                    const std::string &contents, time_t mtime) const {
+    std::string file = write(name, contents);
+
+    setTime(file, mtime);
+    return file;
+  }
+
+  static void setTime(const std::string &file, time_t mtime) {
+    struct utimbuf times;
+
+    times.actime = times.modtime = mtime;
+    utime(file.c_str(), &times);
+  }
+
+  static void remove(const std::string &file) {
+    DIR* dir = opendir(file.c_str());
+    struct dirent* entry;
+    std::string name;
+
+    if (dir == NULL) {
+      unlink(file.c_str());
+      return;
+    }
+    while ((entry = readdir(dir)) != NULL) {
+      name = entry->d_name;
+      if (name != "." && name != "..")
+        remove(file + "/" + name);
+    }
+    closedir(dir);
+    rmdir(file.c_str());
+  }
+};
+
+#endif
@@ -0,0 +1,94 @@
+#include "TokenList.h"
+#include "stylesheet/Selector.h"
+#include "css/CssTokenizer.h"
+#include "gtest/gtest.h"
+
+#include <list>
+#include <cstring>
+#include <utility>
+
+static void tokenize(const char* str, TokenList &l) {
+  CssTokenizer t(str, std::strlen(str), "test");
+
+  while (t.readNextToken() != Token::EOS)
+    l.push_back(t.getToken());
+}
+
+TEST(TokenListTest, Move) {
+  // moving a list takes over its tokens instead of copying them
+  TokenList l1, l2, l3;
+  const Token* first;
+
+  tokenize("a b c", l1);
+  first = &l1.front();
+
+  l2 = std::move(l1);
+  ASSERT_EQ(first, &l2.front());
+  ASSERT_EQ("a b c", l2.toString());
+
+  TokenList l4(std::move(l2));
+  ASSERT_EQ(first, &l4.front());
+
+  std::pair<TokenList, int> p(std::move(l4), 1);
+  ASSERT_EQ(first, &p.first.front());
+}
+
+TEST(TokenListTest, SelectorSplit) {
+  Selector s;
+  std::list<Selector> parts;
+  std::list<Selector>::iterator it;
+
+  tokenize("p .class,a:hover,:not(a, b)", s);
+  s.split(parts);
+
+  ASSERT_EQ(3U, parts.size());
+  it = parts.begin();
+  ASSERT_EQ("p .class", (it++)->toString());
+  ASSERT_EQ("a:hover", (it++)->toString());
+  ASSERT_EQ(":not(a, b)", it->toString());
+}
+
+TEST(TokenListTest, FrontAndTrim) {
+  TokenList l;
+
+  tokenize("  a b  ", l);
+  l.trim();
+  ASSERT_EQ("a b", l.toString());
+
+  l.pop_front();
+  ASSERT_EQ(" b", l.toString());
+  l.ltrim();
+  l.push_front(Token("c", Token::IDENTIFIER, 0, 0, "test"));
+  ASSERT_EQ("cb", l.toString());
+
+  l.clear();
+  l.trim();
+  ASSERT_TRUE(l.empty());
+
+  tokenize("  ", l);
+  l.ltrim();
+  ASSERT_TRUE(l.empty());
+}
+
+TEST(TokenListTest, Contains) {
+  TokenList l;
+
+  tokenize("a, @b", l);
+  ASSERT_TRUE(l.contains(Token::BUILTIN_COMMA));
+  ASSERT_TRUE(l.contains(Token::ATKEYWORD, "@b"));
+  ASSERT_FALSE(l.contains(Token::IDENTIFIER, "@b"));
+  ASSERT_TRUE(l.containsType(Token::WHITESPACE));
+  ASSERT_FALSE(l.containsType(Token::STRING));
+}
+
+TEST(TokenListTest, InsertInMiddle) {
+  // inserting moves the following tokens; the list keeps its order
+  TokenList l1, l2;
+
+  tokenize("a d", l1);
+  tokenize("b c", l2);
+  l1.insert(l1.begin() + 1, l2.begin(), l2.end());
+  ASSERT_EQ("ab c d", l1.toString());
+  l1.erase(l1.begin(), l1.begin() + 2);
+  ASSERT_EQ(" c d", l1.toString());
+}
@@ -1,6 +1,20 @@
 #include "value/ValueProcessor.h"
+#include "value/Expression.h"
 #include "lessstylesheet/ProcessingContext.h"
+#include "less/LessTokenizer.h"
 #include "gtest/gtest.h"
+#include <cstring>
+#include <map>
+
+/**
+ * Tokenize a value the way the parser does.
+ */
+static void tokenize(const char* value, TokenList &l) {
+  LessTokenizer t(value, std::strlen(value), "test");
+
+  while (t.readNextToken() != Token::EOS)
+    l.push_back(t.getToken());
+}
 
 TEST(ValueProcessorTest, Operators) {
   TokenList l;
@@ -1170,3 +1184,261 @@ TEST(ValueProcessorTest, IsUnit) {
 - `average`: no
 - `negation`: no
 */
+
+TEST(ValueProcessorTest, FoldConstants) {
+  TokenList l;
+  ValueProcessor vp;
+  ProcessingContext c;
+  CompiledValue* compiled;
+
+  tokenize("1px + 2px solid percentage(0.5)", l);
+  compiled = vp.compileValue(l);
+
+  ASSERT_TRUE(compiled->valid);
+  EXPECT_TRUE(compiled->folded);
+  EXPECT_STREQ("3px solid 50%", compiled->result.toString().c_str());
+
+  vp.processValue(l, *compiled, c);
+  EXPECT_STREQ("3px solid 50%", l.toString().c_str());
+  delete compiled;
+}
+
+TEST(ValueProcessorTest, FoldConstantStatements) {
+  TokenList l;
+  ValueProcessor vp;
+  CompiledValue* compiled;
+
+  // the variable is looked up every time; the sum only once
+  tokenize("1px + 1px @a", l);
+  compiled = vp.compileValue(l);
+
+  ASSERT_TRUE(compiled->valid);
+  EXPECT_FALSE(compiled->folded);
+  ASSERT_EQ((size_t)2, compiled->statements.size());
+  EXPECT_EQ(Expression::CONSTANT, compiled->statements[0]->type);
+  EXPECT_EQ(Expression::VARIABLE, compiled->statements[1]->type);
+  delete compiled;
+
+  l.clear();
+  tokenize("1 + percentage(@a)", l);
+  compiled = vp.compileValue(l);
+
+  ASSERT_TRUE(compiled->valid);
+  EXPECT_FALSE(compiled->folded);
+  ASSERT_EQ((size_t)1, compiled->statements.size());
+  EXPECT_NE(Expression::CONSTANT, compiled->statements[0]->type);
+  delete compiled;
+}
+
+TEST(ValueProcessorTest, FoldImpureFunctions) {
+  const char* values[] = {
+    "data-uri('image.png')",
+    "imgwidth(url('image.png'))",
+    "imgheight(url('image.png'))",
+    "imgbackground(url('image.png'))",
+    NULL
+  };
+  ValueProcessor vp;
+  CompiledValue* compiled;
+  size_t i, j;
+
+  // functions that read files are evaluated every time
+  for (i = 0; values[i] != NULL; i++) {
+    TokenList l;
+
+    tokenize(values[i], l);
+    compiled = vp.compileValue(l);
+
+    ASSERT_TRUE(compiled->valid) << values[i];
+    EXPECT_FALSE(compiled->folded) << values[i];
+    for (j = 0; j < compiled->statements.size(); j++) {
+      EXPECT_NE(Expression::CONSTANT, compiled->statements[j]->type) <<
+        values[i];
+    }
+    delete compiled;
+  }
+}
+
+/**
+ * Scope with variables set by the test.
+ */
+class TestScope: public ValueScope {
+public:
+  std::map<Symbol, TokenList> variables;
+
+  void set(const char* name, const char* value) {
+    TokenList l;
+
+    tokenize(value, l);
+    variables[SymbolTable::intern(name)] = l;
+  }
+  
+  virtual const TokenList* getVariable(Symbol key) const {
+    std::map<Symbol, TokenList>::const_iterator it = variables.find(key);
+    
+    return it == variables.end() ? NULL : &it->second;
+  }
+};
+
+TEST(ValueProcessorTest, CompiledEqualsProcessed) {
+  const char* values[] = {
+    // folded constants
+    "1px + 2px solid percentage(0.5)",
+    "(1 + 2) * 3 - -4",
+    "2 * 3 + 4 / 2 = 8",
+    "-(1px + 1px)",
+    "#111 + #222",
+    "~\"escaped\" 'quoted' url('a.png')",
+    "%('%d/%d', 1, 2)",
+    "lighten(#000, 10%) red",
+    // variables
+    "@a + 1",
+    "@a @b",
+    "@list",
+    "@missing + 1",
+    "@@name",
+    "@@missing",
+    "percentage(@a)",
+    "percentage(@b)",
+    "(@a * 2) solid",
+    "-@a",
+    "\"@{b}-@{a}\" url(\"@{b}.png\") ~\"@{b}\"",
+    // not values
+    "foo(1, 2) bar",
+    "rgb(1, 2",
+    "unit(5, px) 1px + #fff",
+    "a, b; c",
+    NULL
+  };
+  ValueProcessor vp;
+  TestScope scope;
+  CompiledValue* compiled;
+  size_t i;
+
+  scope.set("@a", "2");
+  scope.set("@b", "\"str\"");
+  scope.set("@list", "1px solid black");
+  scope.set("@name", "\"a\"");
+
+  for (i = 0; values[i] != NULL; i++) {
+    TokenList processed, evaluated;
+
+    tokenize(values[i], processed);
+    evaluated = processed;
+    compiled = vp.compileValue(evaluated);
+
+    vp.processValue(processed, scope);
+    vp.processValue(evaluated, *compiled, scope);
+    EXPECT_EQ(processed.toString(), evaluated.toString()) << values[i];
+
+    if (compiled->folded) {
+      EXPECT_EQ(processed.toString(), compiled->result.toString()) <<
+        values[i];
+    }
+    delete compiled;
+  }
+}
+
+TEST(ValueProcessorTest, NumberValue) {
+  NumberValue n(Token("1.5px", Token::DIMENSION, 0, 0, "test")),
+    three(Token("3", Token::NUMBER, 0, 0, "test"));
+  Value* v, *v2;
+
+  EXPECT_EQ(1.5, n.getValue());
+  EXPECT_EQ("px", n.getUnit());
+
+  n.setValue(2);
+  EXPECT_EQ("2px", n.getTokens()->toString());
+  n.setUnit("em");
+  EXPECT_EQ("2em", n.getTokens()->toString());
+
+  // each step is rounded to 10 significant digits, the same as when
+  // the number was written to the token after every operation
+  v = NumberValue(1).divide(three);
+  v2 = v->multiply(three);
+  EXPECT_EQ("0.3333333333", v->getTokens()->toString());
+  EXPECT_EQ("0.9999999999", v2->getTokens()->toString());
+  delete v;
+  delete v2;
+}
+
+TEST(ValueProcessorTest, ColorTokens) {
+  Color c(10, 20, 30);
+  double hsl[3];
+
+  EXPECT_EQ("#0a141e", c.getTokens()->toString());
+  c.setRGB(255, 0, 0);
+  EXPECT_EQ("#f00", c.getTokens()->toString());
+
+  Color copy(c);
+  EXPECT_EQ("#f00", copy.getTokens()->toString());
+
+  c.getHSL(hsl);
+  EXPECT_DOUBLE_EQ(0, hsl[0]);
+  EXPECT_DOUBLE_EQ(1, hsl[1]);
+  EXPECT_DOUBLE_EQ(0.5, hsl[2]);
+}
+
+TEST(ValueProcessorTest, FunctionLibrary) {
+  const char* names[] = {
+    "rgb", "rgba", "lighten", "darken", "saturate", "desaturate",
+    "fadein", "fadeout", "spin", "hsl", "hue", "saturation",
+    "lightness", "argb", "red", "blue", "green", "alpha", "unit",
+    "get-unit", "ceil", "floor", "percentage", "round", "sqrt", "abs",
+    "sin", "asin", "cos", "acos", "tan", "atan", "pi", "pow", "mod",
+    "convert", "escape", "e", "%", "replace", "color", "data-uri",
+    "imgheight", "imgwidth", "imgbackground", NULL
+  };
+  const char* unknown[] = {
+    "", "rg", "rgbb", "RGB", "lighten2", "data", "percentage ", NULL
+  };
+  const FunctionLibrary &lib = FunctionLibrary::getInstance();
+  const FuncInfo* fi;
+  NumberValue n(0.5), m(1);
+  vector<const Value*> arguments;
+  size_t i;
+
+  ASSERT_EQ(&lib, &FunctionLibrary::getInstance());
+
+  for (i = 0; names[i] != NULL; i++) {
+    fi = lib.getFunction(names[i]);
+    ASSERT_TRUE(fi != NULL) << names[i];
+    EXPECT_EQ(names[i], fi->name);
+  }
+  for (i = 0; unknown[i] != NULL; i++)
+    EXPECT_TRUE(lib.getFunction(unknown[i]) == NULL) << unknown[i];
+
+  fi = lib.getFunction("percentage");
+  EXPECT_FALSE(lib.checkArguments(fi, arguments));
+  arguments.push_back(&n);
+  EXPECT_TRUE(lib.checkArguments(fi, arguments));
+  arguments.push_back(&m);
+  EXPECT_FALSE(lib.checkArguments(fi, arguments));
+}
+
+/**
+ * A scope with only the variables in the map.
+ */
+class VariableScope: public ValueScope {
+public:
+  VariableMap variables;
+
+  virtual const TokenList* getVariable(Symbol key) const {
+    return variables.getVariable(key);
+  }
+};
+
+TEST(ValueProcessorTest, InterpolateToken) {
+  ValueProcessor vp;
+  VariableScope scope;
+  Token t("@{name}-x", Token::IDENTIFIER, 0, 0, 0);
+
+  tokenize("b", scope.variables[SymbolTable::intern("@name")]);
+
+  // the symbol of the old text is dropped along with it
+  t.getSymbol();
+  vp.interpolate(t, scope);
+  ASSERT_STREQ("b-x", t.c_str());
+  ASSERT_TRUE(Token("b-x", Token::IDENTIFIER, 0, 0, 0) == t);
+  ASSERT_EQ(SymbolTable::intern("b-x"), t.getSymbol());
+}
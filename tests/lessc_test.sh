@@ -0,0 +1,135 @@
+#!/bin/sh
+#
+# Tests of the lessc command line modes that compile more than one
+# stylesheet per process. LESSC is the lessc binary to test.
+
+LESSC=${LESSC:-`pwd`/../src/lessc}
+dir=`mktemp -d /tmp/lessc_test_XXXXXX` || exit 1
+status=0
+
+cleanup() {
+  rm -rf "$dir"
+}
+trap cleanup EXIT
+
+fail() {
+  echo "FAIL: $1" >&2
+  status=1
+}
+
+# check FILE CSS
+check() {
+  if [ "`cat "$1" 2>/dev/null`" != "$2" ]; then
+    fail "$1 is '`cat "$1" 2>/dev/null`' instead of '$2'"
+  fi
+}
+
+# wait_for COMMAND: wait up to 5 seconds for COMMAND to succeed.
+wait_for() {
+  i=0
+  while ! eval "$1"; do
+    i=`expr $i + 1`
+    if [ $i -gt 50 ]; then
+      return 1
+    fi
+    sleep 0.1
+  done
+}
+
+cd "$dir" || exit 1
+printf '@import "c.less";\na { b: @c; }\n' > a.less
+printf '@c: 1px;\n' > c.less
+printf 'd { e: f; }\n' > b.less
+printf 'x { y: z;\n' > bad.less
+
+# batch mode
+"$LESSC" --batch a.less b.less:out.css || fail "batch exited with $?"
+check a.css "a{b:1px}"
+check out.css "d{e:f}"
+
+rm -f a.css out.css
+if "$LESSC" --batch -j 2 a.less bad.less b.less:out.css 2>/dev/null; then
+  fail "batch with an error in one job succeeded"
+fi
+check a.css "a{b:1px}"
+check out.css "d{e:f}"
+
+# an output file can't be given to a batch, and a batch needs files
+if "$LESSC" --batch a.less -o ignored.css 2>/dev/null; then
+  fail "batch with -o succeeded"
+fi
+test -f ignored.css && fail "batch with -o wrote ignored.css"
+if "$LESSC" --batch 2>/dev/null; then
+  fail "batch without files succeeded"
+fi
+
+rm -f a.css b.css
+printf 'a.less out.css\nb.less\n' > manifest.txt
+"$LESSC" --manifest=manifest.txt || fail "manifest exited with $?"
+check out.css "a{b:1px}"
+check b.css "d{e:f}"
+
+# cache
+mkdir inc
+printf '@import "d.less";\n' > e.less
+printf 'x { y: inc; }\n' > inc/d.less
+"$LESSC" --cache-dir=cache -I inc e.less -o cache.css
+"$LESSC" --cache-dir=cache -I inc e.less -o cache.css
+check cache.css "x{y:inc}"
+
+# a file that shadows the import is a miss
+printf 'x { y: local; }\n' > d.less
+"$LESSC" --cache-dir=cache -I inc e.less -o cache.css
+check cache.css "x{y:local}"
+
+# stats: calls that were folded into constants or are in a reused
+# mixin expansion are counted every time they are used
+printf '.m() { c: darken(#fff, 10%%); }\na { .m(); }\nb { .m(); }\nc { .m(); }\nd { c: darken(#fff, 10%%); }\n' > stats.less
+"$LESSC" --stats stats.less -o stats.css 2> stats.txt
+grep -q '^function_calls  *4$' stats.txt ||
+  fail "function_calls is not 4: `grep function_calls stats.txt`"
+grep -q '^ *4  darken$' stats.txt ||
+  fail "darken is not called 4 times: `grep darken stats.txt`"
+grep -q '^values  *4$' stats.txt ||
+  fail "values is not 4: `grep values stats.txt`"
+grep -q '^arena_objects  *[1-9][0-9]*$' stats.txt ||
+  fail "arena_objects are not counted"
+
+# daemon mode
+"$LESSC" --daemon=lessc.sock &
+daemon=$!
+if wait_for 'test -S lessc.sock'; then
+  "$LESSC" --connect=lessc.sock a.less -o daemon.css ||
+    fail "connect exited with $?"
+  check daemon.css "a{b:1px}"
+
+  # an edited import is read again
+  printf '@c: 22px;\n' > c.less
+  touch -t 200001010000 c.less
+  "$LESSC" --connect=lessc.sock a.less -o daemon.css ||
+    fail "connect exited with $?"
+  check daemon.css "a{b:22px}"
+
+  # the verbosity is global to the daemon, so a request can't set it
+  if "$LESSC" --connect=lessc.sock -v 1 a.less -o daemon.css 2>/dev/null; then
+    fail "connect with -v succeeded"
+  fi
+else
+  fail "the daemon did not create its socket"
+fi
+kill $daemon
+wait $daemon 2>/dev/null
+
+# watch mode
+printf '@c: 1px;\n' > c.less
+"$LESSC" --watch a.less -o watch.css 2>/dev/null &
+watch=$!
+wait_for 'test "`cat watch.css 2>/dev/null`" = "a{b:1px}"' ||
+  fail "watch did not compile a.less"
+printf '@c: 3px;\n' > c.less
+wait_for 'test "`cat watch.css 2>/dev/null`" = "a{b:3px}"' ||
+  fail "watch did not recompile after c.less changed"
+kill $watch
+wait $watch 2>/dev/null
+
+exit $status